@@ -0,0 +1 @@
+gcc -O2 bench_langue.c langue.c langue_cache.c token.c -o bench_langue -pthread -lm && gcc -O2 bench_placement.c placement.c langue.c token.c -o bench_placement -pthread -lm && ./bench_langue "$@"
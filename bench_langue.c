@@ -0,0 +1,495 @@
+/**
+ * @file bench_langue.c
+ * @brief Mesure de performance et de précision de la détection de langue
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Ce programme fait tourner les moteurs de détection de langue sur le corpus
+ * multilingue fourni (fichiers .txt de corpus/<code>/, une phrase par ligne) pour plusieurs
+ * longueurs de message. Pour chaque moteur et chaque longueur il affiche le
+ * temps par octet, le nombre d'allocations par appel et la précision, puis la
+ * matrice de confusion par langue.
+ *
+ * Des seuils optionnels font échouer le programme (code de retour 1), ce qui
+ * permet de l'utiliser en boucle locale pour détecter les régressions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+
+#include "langue.h"
+#include "langue_cache.h"
+#include "token.h"
+
+/** @brief Longueurs de message mesurées par défaut */
+static const size_t default_lengths[] = {16, 32, 48, 64, 256, 1024};
+#define MAX_LENGTHS 8
+#define MAX_SENTENCES 4096
+
+/* ------------------------------------------------------------------------- */
+/* Comptage des allocations                                                  */
+/* ------------------------------------------------------------------------- */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+/** @brief Nombre d'allocations depuis la dernière remise à zéro */
+static size_t alloc_count = 0;
+
+void *malloc(size_t size) {
+    alloc_count++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    alloc_count++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Moteurs de détection                                                      */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief Moteur de détection mesuré
+ *
+ * classify() reçoit un message terminé par '\0' et renvoie l'indice de la
+ * langue détectée dans languages[], ou -1 si la langue est inconnue.
+ * Un moteur sans allocation échoue dès qu'une passe chronométrée alloue,
+ * quel que soit le seuil -m. Un moteur partiel ne répond qu'à une partie
+ * des messages (les autres sont comptés dans la colonne "?") : le seuil -a
+ * ne s'applique pas à lui.
+ */
+struct engine {
+    const char *name;
+    int (*classify)(char *text, size_t len);
+    int allocation_free;
+    int partial;
+};
+
+/** @brief Renvoie l'indice d'un nom de langue de languages[] */
+static int language_index(const char *name) {
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        if (name == languages[i] || strcmp(name, languages[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int engine_getlangue(char *text, size_t len) {
+    (void)len;
+    return language_index(getlangue(text));
+}
+
+static int engine_model(char *text, size_t len) {
+    struct langue_result result;
+    return langue_classify_model(text, len, &result);
+}
+
+/** @brief Lexique seul : "?" quand il ne conclut pas (message long ou ambigu) */
+static int engine_short(char *text, size_t len) {
+    struct langue_result result;
+    return langue_classify_short(text, len, &result);
+}
+
+static int engine_classify(char *text, size_t len) {
+    struct langue_result result;
+    return langue_classify_buf(text, len, &result);
+}
+
+/** @brief Cache du moteur "cache" : les passes chronométrées le trouvent rempli */
+static struct langue_cache bench_cache;
+
+static int engine_cache(char *text, size_t len) {
+    if (!bench_cache.entries) {
+        langue_cache_init(&bench_cache, 1 << 20);
+    }
+    struct langue_result result;
+    return langue_cache_detect(&bench_cache, text, len, &result);
+}
+
+/** @brief Moteurs comparés par le banc de mesure */
+static const struct engine engines[] = {
+    {"getlangue", engine_getlangue, 1, 0},
+    {"modèle", engine_model, 1, 0},
+    {"lexique", engine_short, 1, 1},
+    {"classify", engine_classify, 1, 0},
+    {"cache", engine_cache, 1, 0},
+};
+#define ENGINE_COUNT (sizeof(engines) / sizeof(engines[0]))
+
+/* ------------------------------------------------------------------------- */
+/* Corpus                                                                    */
+/* ------------------------------------------------------------------------- */
+
+/** @brief Phrases d'une langue du corpus */
+struct corpus_lang {
+    char *sentences[MAX_SENTENCES];
+    int count;
+};
+
+/** @brief Un message de test et sa langue attendue */
+struct sample {
+    char *text;
+    size_t len;
+    int lang;
+};
+
+static struct corpus_lang corpus[LANGUE_COUNT];
+
+/**
+ * @brief Charge toutes les phrases des fichiers .txt de corpus/<code>/
+ * @return Nombre de phrases chargées
+ */
+static int load_language(const char *dir, int lang) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, language_codes[lang]);
+
+    DIR *d = opendir(path);
+    if (!d) {
+        perror(path);
+        return 0;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        size_t name_len = strlen(entry->d_name);
+        if (name_len < 4 || strcmp(entry->d_name + name_len - 4, ".txt") != 0) {
+            continue;
+        }
+
+        char file_path[8192];
+        snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+        FILE *f = fopen(file_path, "r");
+        if (!f) {
+            perror(file_path);
+            continue;
+        }
+
+        char line[4096];
+        while (fgets(line, sizeof(line), f) && corpus[lang].count < MAX_SENTENCES) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] != '\0') {
+                corpus[lang].sentences[corpus[lang].count++] = strdup(line);
+            }
+        }
+        fclose(f);
+    }
+    closedir(d);
+    return corpus[lang].count;
+}
+
+/** @brief Retire un éventuel caractère UTF-8 incomplet en fin de texte */
+static size_t utf8_trim(const char *text, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+    size_t p = len - 1;
+    while (p > 0 && ((unsigned char)text[p] & 0xC0) == 0x80) {
+        p--;
+    }
+    unsigned char lead = text[p];
+    size_t expected = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    return p + expected > len ? p : len;
+}
+
+/**
+ * @brief Construit un message de longueur donnée à partir de la phrase start
+ *
+ * Les phrases suivantes sont concaténées jusqu'à atteindre la longueur,
+ * puis le texte est coupé sans casser de séquence UTF-8.
+ */
+static struct sample make_sample(int lang, int start, size_t length) {
+    struct sample s;
+    s.text = __libc_malloc(length + 1);
+    s.lang = lang;
+    s.len = 0;
+
+    int i = start;
+    while (s.len < length) {
+        const char *sentence = corpus[lang].sentences[i % corpus[lang].count];
+        if (s.len > 0) {
+            s.text[s.len++] = ' ';
+        }
+        size_t n = strlen(sentence);
+        if (n > length - s.len) {
+            n = length - s.len;
+        }
+        memcpy(s.text + s.len, sentence, n);
+        s.len += n;
+        i++;
+    }
+    s.len = utf8_trim(s.text, s.len);
+    s.text[s.len] = '\0';
+    return s;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Mesures                                                                   */
+/* ------------------------------------------------------------------------- */
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** @brief Résultat d'un moteur pour une longueur de message */
+struct measure {
+    double ns_per_byte;
+    double ns_per_call;
+    double allocs_per_call;
+    int correct;
+    int total;
+    int confusion[LANGUE_COUNT][LANGUE_COUNT + 1];
+};
+
+static void run_engine(const struct engine *e, struct sample *samples, int count,
+                       int iterations, struct measure *m) {
+    memset(m, 0, sizeof(*m));
+
+    // Passe de précision (sert aussi d'échauffement)
+    for (int i = 0; i < count; i++) {
+        int found = e->classify(samples[i].text, samples[i].len);
+        m->confusion[samples[i].lang][found < 0 ? LANGUE_COUNT : found]++;
+        if (found == samples[i].lang) {
+            m->correct++;
+        }
+        m->total++;
+    }
+
+    // Passes chronométrées
+    size_t bytes = 0;
+    alloc_count = 0;
+    double start = now_ns();
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 0; i < count; i++) {
+            e->classify(samples[i].text, samples[i].len);
+            bytes += samples[i].len;
+        }
+    }
+    double elapsed = now_ns() - start;
+    size_t allocs = alloc_count;
+    size_t calls = (size_t)iterations * count;
+
+    m->ns_per_byte = bytes ? elapsed / bytes : 0;
+    m->ns_per_call = calls ? elapsed / calls : 0;
+    m->allocs_per_call = calls ? (double)allocs / calls : 0;
+}
+
+/**
+ * @brief Débit du découpage en mots sur les messages de 1024 octets
+ * @return Débit en Go/s
+ */
+static double measure_tokenizer(int iterations, size_t *words) {
+    int count = 0;
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        count += corpus[lang].count;
+    }
+    struct sample *samples = __libc_malloc(count * sizeof(*samples));
+    int n = 0;
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        for (int s = 0; s < corpus[lang].count; s++) {
+            samples[n++] = make_sample(lang, s, 1024);
+        }
+    }
+
+    size_t bytes = 0, total = 0;
+    double start = now_ns();
+    for (int it = 0; it < iterations * 10; it++) {
+        for (int i = 0; i < n; i++) {
+            struct token_span spans[64];
+            size_t pos = 0, n_spans;
+            do {
+                n_spans = token_split(samples[i].text, samples[i].len, &pos, spans, 64);
+                total += n_spans;
+            } while (n_spans == 64);
+            bytes += samples[i].len;
+        }
+    }
+    double elapsed = now_ns() - start;
+
+    for (int i = 0; i < n; i++) {
+        __libc_free(samples[i].text);
+    }
+    __libc_free(samples);
+    *words = total;
+    return elapsed > 0 ? bytes / elapsed : 0;
+}
+
+static void print_confusion(int confusion[LANGUE_COUNT][LANGUE_COUNT + 1]) {
+    printf("    %-12s", "attendu\\lu");
+    for (int j = 0; j < LANGUE_COUNT; j++) {
+        printf(" %6s", language_codes[j]);
+    }
+    printf(" %6s %8s\n", "?", "précision");
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        int row = 0;
+        printf("    %-12s", language_codes[i]);
+        for (int j = 0; j <= LANGUE_COUNT; j++) {
+            printf(" %6d", confusion[i][j]);
+            row += confusion[i][j];
+        }
+        printf(" %7.1f%%\n", row ? 100.0 * confusion[i][i] / row : 0.0);
+    }
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-c CORPUS] [-p PROFIL] [-i ITERATIONS] [-l L1,L2,...] [-a PRECISION_MIN]\n"
+           "          [-t NS_PAR_OCTET_MAX] [-m ALLOCS_MAX] [-v]\n"
+           "  -c  dossier du corpus (défaut: corpus)\n"
+           "  -p  profil de langues écrit par train (défaut: tables intégrées)\n"
+           "  -i  nombre de passes chronométrées (défaut: 20)\n"
+           "  -l  longueurs de message mesurées (défaut: 16,32,48,64,256,1024)\n"
+           "  -a  précision globale minimale en %% pour chaque moteur\n"
+           "  -t  temps maximal par octet (ns) sur la plus grande longueur\n"
+           "  -m  nombre maximal d'allocations par appel\n"
+           "  -v  affiche la matrice de confusion de chaque longueur\n", prog);
+}
+
+/**
+ * @brief Point d'entrée du banc de mesure
+ * @return 0 si tous les seuils sont respectés, 1 sinon
+ */
+int main(int argc, char *argv[]) {
+    const char *corpus_dir = "corpus";
+    int iterations = 20;
+    size_t lengths[MAX_LENGTHS];
+    int length_count = sizeof(default_lengths) / sizeof(default_lengths[0]);
+    double min_accuracy = -1;
+    double max_ns_per_byte = -1;
+    double max_allocs = -1;
+    int verbose = 0;
+    int opt;
+
+    memcpy(lengths, default_lengths, sizeof(default_lengths));
+
+    while ((opt = getopt(argc, argv, "c:p:i:l:a:t:m:vh")) != -1) {
+        switch (opt) {
+            case 'c': corpus_dir = optarg; break;
+            case 'p':
+                if (langue_load_profile(optarg) != 0) {
+                    return 1;
+                }
+                break;
+            case 'i': iterations = atoi(optarg); break;
+            case 'l': {
+                length_count = 0;
+                for (char *tok = strtok(optarg, ","); tok && length_count < MAX_LENGTHS;
+                     tok = strtok(NULL, ",")) {
+                    lengths[length_count++] = strtoul(tok, NULL, 10);
+                }
+                break;
+            }
+            case 'a': min_accuracy = atof(optarg); break;
+            case 't': max_ns_per_byte = atof(optarg); break;
+            case 'm': max_allocs = atof(optarg); break;
+            case 'v': verbose = 1; break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        if (load_language(corpus_dir, lang) == 0) {
+            fprintf(stderr, "Corpus vide pour la langue %s\n", language_codes[lang]);
+            return 1;
+        }
+    }
+
+    size_t words;
+    double throughput = measure_tokenizer(iterations, &words);
+    printf("Découpage en mots : %.2f Go/s (%zu mots)\n\n", throughput, words);
+
+    int failed = 0;
+    for (size_t e = 0; e < ENGINE_COUNT; e++) {
+        int total_confusion[LANGUE_COUNT][LANGUE_COUNT + 1] = {{0}};
+        int correct = 0, total = 0;
+        double worst_allocs = 0;
+        double last_ns_per_byte = 0;
+
+        printf("Moteur : %s\n", engines[e].name);
+        printf("  %8s %12s %12s %14s %10s\n",
+               "longueur", "ns/octet", "ns/appel", "allocs/appel", "précision");
+
+        for (int l = 0; l < length_count; l++) {
+            int count = 0;
+            for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+                count += corpus[lang].count;
+            }
+            struct sample *samples = __libc_malloc(count * sizeof(*samples));
+            int n = 0;
+            for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+                for (int s = 0; s < corpus[lang].count; s++) {
+                    samples[n++] = make_sample(lang, s, lengths[l]);
+                }
+            }
+
+            struct measure m;
+            run_engine(&engines[e], samples, n, iterations, &m);
+            printf("  %8zu %12.2f %12.1f %14.2f %9.1f%%\n", lengths[l], m.ns_per_byte,
+                   m.ns_per_call, m.allocs_per_call, 100.0 * m.correct / m.total);
+            if (verbose) {
+                print_confusion(m.confusion);
+            }
+
+            for (int i = 0; i < LANGUE_COUNT; i++) {
+                for (int j = 0; j <= LANGUE_COUNT; j++) {
+                    total_confusion[i][j] += m.confusion[i][j];
+                }
+            }
+            correct += m.correct;
+            total += m.total;
+            if (m.allocs_per_call > worst_allocs) {
+                worst_allocs = m.allocs_per_call;
+            }
+            last_ns_per_byte = m.ns_per_byte;
+
+            for (int i = 0; i < n; i++) {
+                __libc_free(samples[i].text);
+            }
+            __libc_free(samples);
+        }
+
+        double accuracy = total ? 100.0 * correct / total : 0;
+        printf("  Précision globale : %.1f%% (%d/%d)\n", accuracy, correct, total);
+        print_confusion(total_confusion);
+        printf("\n");
+
+        if (min_accuracy >= 0 && accuracy < min_accuracy && !engines[e].partial) {
+            printf("ÉCHEC: %s précision %.1f%% < %.1f%%\n", engines[e].name, accuracy, min_accuracy);
+            failed = 1;
+        }
+        if (max_ns_per_byte >= 0 && last_ns_per_byte > max_ns_per_byte) {
+            printf("ÉCHEC: %s %.2f ns/octet > %.2f\n", engines[e].name, last_ns_per_byte, max_ns_per_byte);
+            failed = 1;
+        }
+        if (max_allocs >= 0 && worst_allocs > max_allocs) {
+            printf("ÉCHEC: %s %.2f allocations/appel > %.2f\n", engines[e].name, worst_allocs, max_allocs);
+            failed = 1;
+        }
+        if (engines[e].allocation_free && worst_allocs > 0) {
+            printf("ÉCHEC: %s %.2f allocations/appel (attendu 0)\n", engines[e].name, worst_allocs);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
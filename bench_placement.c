@@ -0,0 +1,257 @@
+/**
+ * @file bench_placement.c
+ * @brief Mesure du débit de la chaîne réception -> détection selon le
+ * placement des threads
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Reproduit le passage d'un message entre les deux threads du serveur : le
+ * thread de réception copie le message dans un tampon (struct
+ * message_buffer) et le passe par une msgbuf_queue au thread de détection,
+ * qui détecte sa langue et rend le tampon par une seconde file. Chaque
+ * thread alloue sa mémoire après avoir été placé, comme dans le serveur.
+ *
+ * Placements mesurés : threads non fixés, fixés sur le même CPU, sur deux
+ * CPU du même nœud NUMA et sur deux nœuds différents (si la machine en a
+ * plusieurs) ; ou seulement celui donné par -r et -d.
+ *
+ * Usage: ./bench_placement [-n MESSAGES] [-l LONGUEUR] [-c CORPUS]
+ *                          [-r CPU_RECEPTION -d CPU_DETECTION]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "langue.h"
+#include "msgbuf.h"
+#include "placement.h"
+
+/** @brief Tampons en circulation entre les deux threads */
+#define BENCH_BUFFERS 256
+/** @brief Taille maximale du texte du corpus chargé */
+#define BENCH_TEXT_MAX (1 << 20)
+
+/** @brief Texte d'où sont tirés les messages */
+static char *text;
+static size_t text_length;
+
+static long message_count = 200000;
+static size_t message_length = 64;
+
+/** @brief État partagé d'une mesure */
+static struct msgbuf_queue work;       /**< Réception -> détection */
+static struct msgbuf_queue done;       /**< Détection -> réception (tampons libres) */
+static pthread_barrier_t ready;
+
+/** @brief Charge les phrases du corpus, toutes langues mêlées */
+static void load_text(const char *dir) {
+    text = malloc(BENCH_TEXT_MAX);
+    text_length = 0;
+    for (int lang = 0; lang < LANGUE_COUNT && text; lang++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", dir, language_codes[lang]);
+        DIR *d = opendir(path);
+        if (!d) {
+            continue;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(d)) != NULL) {
+            size_t name_len = strlen(entry->d_name);
+            if (name_len < 4 || strcmp(entry->d_name + name_len - 4, ".txt") != 0) {
+                continue;
+            }
+            char file_path[8192];
+            snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+            FILE *f = fopen(file_path, "r");
+            if (!f) {
+                continue;
+            }
+            text_length += fread(text + text_length, 1, BENCH_TEXT_MAX - text_length, f);
+            fclose(f);
+        }
+        closedir(d);
+    }
+    if (text_length < MESSAGE_MAX) {
+        // Pas de corpus : texte fixe
+        const char *sentence = "Le serveur reçoit un message et cherche sa langue. ";
+        size_t n = strlen(sentence);
+        for (text_length = 0; text_length + n < MESSAGE_MAX * 4; text_length += n) {
+            memcpy(text + text_length, sentence, n);
+        }
+    }
+}
+
+/** @brief Thread de réception : copie les messages dans les tampons */
+static void *reception(void *arg) {
+    (void)arg;
+    placement_apply(PLACEMENT_RECEPTION, "réception");
+    struct message_buffer *buffers = aligned_alloc(64, BENCH_BUFFERS * sizeof(*buffers));
+    memset(buffers, 0, BENCH_BUFFERS * sizeof(*buffers));
+    for (int i = 0; i < BENCH_BUFFERS; i++) {
+        msgbuf_queue_push(&done, &buffers[i]);
+    }
+    pthread_barrier_wait(&ready);
+
+    size_t offset = 0;
+    for (long i = 0; i < message_count; i++) {
+        struct message_buffer *b;
+        while ((b = msgbuf_queue_pop(&done)) == NULL) {
+            sched_yield();
+        }
+        if (offset + message_length > text_length) {
+            offset = 0;
+        }
+        memcpy(b->data, text + offset, message_length);
+        b->data[message_length] = '\0';
+        b->length = message_length;
+        offset += message_length / 2 + 1;
+        msgbuf_queue_push(&work, b);
+    }
+    // Attendre le retour de tous les tampons avant de les libérer
+    for (int i = 0; i < BENCH_BUFFERS; i++) {
+        while (msgbuf_queue_pop(&done) == NULL) {
+            sched_yield();
+        }
+    }
+    free(buffers);
+    return NULL;
+}
+
+/** @brief Thread de détection : détecte la langue et rend le tampon */
+static void *detection(void *arg) {
+    (void)arg;
+    placement_apply(PLACEMENT_CLASSIFIER, "détection");
+    langue_profile_localize();
+    pthread_barrier_wait(&ready);
+
+    for (long i = 0; i < message_count; i++) {
+        struct message_buffer *b;
+        while ((b = msgbuf_queue_pop(&work)) == NULL) {
+            sched_yield();
+        }
+        langue_classify_buf(b->data, b->length, &b->result);
+        msgbuf_queue_push(&done, b);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Mesure un placement
+ * @param reception_cpus CPU du thread de réception ("" : non fixé)
+ * @param detection_cpus CPU du thread de détection ("" : non fixé)
+ */
+static void run(const char *label, const char *reception_cpus, const char *detection_cpus) {
+    if (placement_set(PLACEMENT_RECEPTION, reception_cpus) != 0 ||
+        placement_set(PLACEMENT_CLASSIFIER, detection_cpus) != 0) {
+        printf("%-8s %-8s CPU indisponibles pour le processus    %s\n", reception_cpus,
+               detection_cpus, label);
+        return;
+    }
+    memset(&work, 0, sizeof(work));
+    memset(&done, 0, sizeof(done));
+    pthread_barrier_init(&ready, NULL, 3);
+
+    pthread_t threads[2];
+    pthread_create(&threads[0], NULL, reception, NULL);
+    pthread_create(&threads[1], NULL, detection, NULL);
+    pthread_barrier_wait(&ready);
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    pthread_barrier_destroy(&ready);
+
+    double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%-8s %-8s %10.0f msg/s %8.0f ns/msg  %s\n", reception_cpus[0] ? reception_cpus : "-",
+           detection_cpus[0] ? detection_cpus : "-", message_count / seconds,
+           seconds * 1e9 / message_count, label);
+}
+
+/**
+ * @brief Choisit les CPU des placements à mesurer
+ * @param same Second CPU du nœud du premier (-1 : aucun)
+ * @param other CPU d'un autre nœud (-1 : aucun)
+ * @return Premier CPU disponible
+ */
+static int pick_cpus(int *same, int *other) {
+    cpu_set_t set;
+    sched_getaffinity(0, sizeof(set), &set);
+    int first = -1;
+    *same = *other = -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) {
+            continue;
+        }
+        if (first < 0) {
+            first = cpu;
+        } else if (*same < 0 && placement_cpu_node(cpu) == placement_cpu_node(first)) {
+            *same = cpu;
+        } else if (*other < 0 && placement_cpu_node(cpu) != placement_cpu_node(first)) {
+            *other = cpu;
+        }
+    }
+    return first;
+}
+
+int main(int argc, char *argv[]) {
+    const char *corpus_dir = "corpus";
+    const char *reception_cpus = NULL, *detection_cpus = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:c:r:d:")) != -1) {
+        if (opt == 'n') {
+            message_count = atol(optarg);
+        } else if (opt == 'l') {
+            message_length = strtoul(optarg, NULL, 10);
+        } else if (opt == 'c') {
+            corpus_dir = optarg;
+        } else if (opt == 'r') {
+            reception_cpus = optarg;
+        } else if (opt == 'd') {
+            detection_cpus = optarg;
+        } else {
+            printf("Usage: %s [-n MESSAGES] [-l LONGUEUR] [-c CORPUS]\n"
+                   "       [-r CPU_RECEPTION -d CPU_DETECTION]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (message_count <= 0 || message_length == 0 || message_length >= MESSAGE_MAX ||
+        (!reception_cpus != !detection_cpus)) {
+        printf("Arguments invalides (LONGUEUR < %d, -r et -d ensemble)\n", MESSAGE_MAX);
+        return 1;
+    }
+    load_text(corpus_dir);
+    if (!text) {
+        return 1;
+    }
+
+    printf("%ld messages de %zu octets\n", message_count, message_length);
+    printf("Récept.  Détect.             Débit    Par message  Placement\n");
+    run("non fixés", "", "");
+    if (reception_cpus) {
+        run("donné", reception_cpus, detection_cpus);
+    } else {
+        int same, other;
+        int first = pick_cpus(&same, &other);
+        char a[16], b[16], c[16];
+        snprintf(a, sizeof(a), "%d", first);
+        snprintf(b, sizeof(b), "%d", same);
+        snprintf(c, sizeof(c), "%d", other);
+        run("même CPU", a, a);
+        if (same >= 0) {
+            run("même nœud, CPU différents", a, b);
+        }
+        if (other >= 0) {
+            run("nœuds différents", a, c);
+        } else {
+            printf("(un seul nœud NUMA : pas de mesure entre nœuds)\n");
+        }
+    }
+    return 0;
+}
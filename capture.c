@@ -0,0 +1,145 @@
+/**
+ * @file capture.c
+ * @brief Enregistrement des signaux reçus par le serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Les enregistrements sont ajoutés par la boucle d'événements (consommateur
+ * de la file des signaux), jamais par le gestionnaire de signal. La capture
+ * peut être démarrée et arrêtée par la socket de contrôle pendant que la
+ * boucle écrit : un verrou protège le fichier, pris seulement quand la
+ * capture est active.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "capture.h"
+#include "metrics.h"
+
+static pthread_mutex_t capture_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *capture_file = NULL;
+static atomic_int capture_active = 0;
+/** @brief Horodatage de l'enregistrement précédent */
+static uint64_t capture_last_ns;
+static uint64_t capture_count;
+
+/**
+ * @brief Démarre la capture dans un fichier (remplacé s'il existe)
+ * @return 0 en cas de succès, -1 sinon
+ *
+ * Une capture en cours est d'abord arrêtée.
+ */
+int capture_start(const char *path) {
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        return -1;
+    }
+    struct capture_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.server_pid = getpid();
+    header.base_ns = metrics_now_ns();
+    header.start_time = time(NULL);
+    if (fwrite(&header, sizeof(header), 1, out) != 1) {
+        fclose(out);
+        return -1;
+    }
+
+    pthread_mutex_lock(&capture_lock);
+    if (capture_file) {
+        fclose(capture_file);
+    }
+    capture_file = out;
+    capture_last_ns = header.base_ns;
+    capture_count = 0;
+    atomic_store(&capture_active, 1);
+    pthread_mutex_unlock(&capture_lock);
+    return 0;
+}
+
+/** @brief Arrête la capture et ferme le fichier */
+void capture_stop(void) {
+    pthread_mutex_lock(&capture_lock);
+    atomic_store(&capture_active, 0);
+    if (capture_file) {
+        fclose(capture_file);
+        capture_file = NULL;
+    }
+    pthread_mutex_unlock(&capture_lock);
+}
+
+/**
+ * @brief Ajoute un signal à la capture en cours (sans effet sinon)
+ *
+ * Un écart de plus de 71 minutes entre deux signaux est ramené à la valeur
+ * maximale de delta_us.
+ */
+void capture_record_signal(const struct signal_event *ev) {
+    if (!atomic_load_explicit(&capture_active, memory_order_relaxed)) {
+        return;
+    }
+    struct capture_record record;
+    record.pid = ev->pid;
+    record.type = ev->signo == SIGUSR1 ? CAPTURE_BIT1 : ev->signo == SIGUSR2 ? CAPTURE_BIT0 : CAPTURE_END;
+    record.flags = ev->code == SI_QUEUE ? (ev->value & 0x7F) | CAPTURE_QUEUED : 0;
+
+    pthread_mutex_lock(&capture_lock);
+    if (capture_file) {
+        uint64_t delta = ev->ns > capture_last_ns ? (ev->ns - capture_last_ns) / 1000 : 0;
+        record.delta_us = delta > UINT32_MAX ? UINT32_MAX : delta;
+        capture_last_ns += (uint64_t)record.delta_us * 1000;
+        fwrite(&record, sizeof(record), 1, capture_file);
+        capture_count++;
+    }
+    pthread_mutex_unlock(&capture_lock);
+}
+
+/**
+ * @brief Écrit les enregistrements en attente
+ *
+ * Appelée à la fin de chaque lot de signaux : la capture reste exploitable
+ * si le serveur est tué.
+ */
+void capture_flush(void) {
+    if (!atomic_load_explicit(&capture_active, memory_order_relaxed)) {
+        return;
+    }
+    pthread_mutex_lock(&capture_lock);
+    if (capture_file) {
+        fflush(capture_file);
+    }
+    pthread_mutex_unlock(&capture_lock);
+}
+
+/**
+ * @brief Commande de contrôle "capture [FICHIER|stop]"
+ *
+ * Sans argument, indique l'état de la capture.
+ */
+void capture_command(int argc, char *argv[], FILE *reply) {
+    if (argc < 2) {
+        pthread_mutex_lock(&capture_lock);
+        if (capture_file) {
+            fprintf(reply, "Capture en cours : %llu signaux\n", (unsigned long long)capture_count);
+        } else {
+            fprintf(reply, "Pas de capture en cours\n");
+        }
+        pthread_mutex_unlock(&capture_lock);
+    } else if (strcmp(argv[1], "stop") == 0) {
+        pthread_mutex_lock(&capture_lock);
+        uint64_t count = capture_count;
+        pthread_mutex_unlock(&capture_lock);
+        capture_stop();
+        fprintf(reply, "Capture arrêtée (%llu signaux)\n", (unsigned long long)count);
+    } else if (capture_start(argv[1]) != 0) {
+        fprintf(reply, "Erreur: impossible d'écrire %s\n", argv[1]);
+    } else {
+        fprintf(reply, "Capture des signaux dans %s\n", argv[1]);
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file capture.h
+ * @brief Enregistrement des signaux reçus par le serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * En mode capture, chaque signal du protocole sorti de la file du
+ * gestionnaire (PID de l'émetteur, signal, drapeaux de sigqueue(),
+ * horodatage) est ajouté à un fichier binaire compact. L'outil replay
+ * rejoue ensuite ce fichier sur un serveur.
+ *
+ * Format : un en-tête struct capture_header puis des struct capture_record
+ * de 10 octets, dans l'ordre de réception.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ring.h"
+
+#define CAPTURE_MAGIC "MTCAPT01"
+
+/** @brief Type d'un enregistrement */
+enum capture_type {
+    CAPTURE_BIT0,       /**< SIGUSR2 */
+    CAPTURE_BIT1,       /**< SIGUSR1 */
+    CAPTURE_END,        /**< SIGQUIT */
+};
+
+/** @brief Le signal a été envoyé par sigqueue() ; flags contient si_value */
+#define CAPTURE_QUEUED 0x80
+
+/** @brief En-tête du fichier de capture */
+struct capture_header {
+    char magic[8];          /**< "MTCAPT01" */
+    int32_t server_pid;     /**< PID du serveur enregistré */
+    uint32_t reserved;
+    uint64_t base_ns;       /**< CLOCK_MONOTONIC du premier enregistrement */
+    int64_t start_time;     /**< Heure de début (time()) */
+};
+
+/** @brief Signal enregistré */
+struct capture_record {
+    uint32_t delta_us;      /**< Écart avec l'enregistrement précédent (µs) */
+    int32_t pid;            /**< PID de l'émetteur */
+    uint8_t type;           /**< enum capture_type */
+    uint8_t flags;          /**< Drapeaux PROTO_FLAG_* et CAPTURE_QUEUED */
+} __attribute__((packed));
+
+int capture_start(const char *path);
+void capture_stop(void);
+void capture_record_signal(const struct signal_event *ev);
+void capture_flush(void);
+void capture_command(int argc, char *argv[], FILE *reply);
+
+#endif
@@ -6,6 +6,9 @@
  *
  * Ce programme client permet d'envoyer des messages à un serveur en utilisant
  * des signaux UNIX. Chaque caractère est converti en binaire et envoyé bit par bit.
+ * Le message peut aussi passer par une socket Unix ou un tube nommé (voir
+ * transport.h). Le client peut enfin s'abonner à un canal pour recevoir
+ * les messages que le serveur relaie (voir relay.h).
  */
 
 #include <stdio.h>
@@ -13,104 +16,451 @@
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+#include "protocole.h"
+#include "shards.h"
+#include "transport.h"
+#include "relay.h"
 
 /**
- * @brief Convertit un caractère en sa représentation binaire
- * @param c Le caractère à convertir
- * @param binary Buffer de sortie pour stocker la représentation binaire (doit être de taille 9)
- * 
- * Cette fonction convertit un caractère en sa représentation binaire sur 8 bits.
- * Le résultat est stocké dans le buffer binary sous forme de chaîne de '0' et '1'.
+ * @brief Vide les traces du client dans un fichier
+ * @param path Chemin du fichier, ou NULL pour client_trace_PID.bin
  */
-void char_to_binary(char c, char *binary) {
-    int ascii_value = (int)c;
-    for (int i = 7; i >= 0; i--) {
-        binary[7 - i] = (ascii_value & (1 << i)) ? '1' : '0';
+void dump_trace(const char *path) {
+    char default_path[64];
+    if (!path) {
+        snprintf(default_path, sizeof(default_path), "client_trace_%d.bin", getpid());
+        path = default_path;
+    }
+    if (trace_dump(path) >= 0) {
+        printf("Traces écrites dans %s\n", path);
     }
-    binary[8] = '\0';
 }
 
-// Variable globale pour l'accusé de réception
-volatile sig_atomic_t ack_received = 0;
+/** @brief État de l'envoi vers un serveur en mode diffusion */
+struct target {
+    pid_t pid;
+    int bit;                        /**< Rang du bit en attente d'ACK */
+    volatile sig_atomic_t acked;    /**< ACK reçu pour ce bit */
+    volatile sig_atomic_t busy;     /**< L'ACK est un refus (serveur saturé) */
+    uint64_t deadline_us;           /**< Échéance de l'attente de l'ACK */
+    uint64_t resume_us;             /**< Fin de la pause avant un nouvel essai (0 : pas de pause) */
+    unsigned pause_us;              /**< Durée de la prochaine pause */
+    unsigned waited_us;             /**< Durée cumulée des pauses */
+    int done;
+    int failed;
+};
+
+/** @brief Serveurs destinataires du mode diffusion */
+struct target *targets = NULL;
+int target_count = 0;
 
-// Handler pour recevoir l'accusé de réception
-void ack_handler(int signo) {
-    if (signo == SIGUSR1) {
-        ack_received = 1;
+/** @brief Classe de priorité des envois (option -b ou message long) */
+int lane = LANE_INTERACTIVE;
+/** @brief Reprise de l'envoi après un redémarrage du serveur (option -r) */
+int resume = 0;
+
+/**
+ * @brief Handler des ACK temps réel du mode diffusion
+ *
+ * Les ACK SIG_ACK_RT sont mis en file par le noyau : chacun est
+ * attribué à son serveur grâce à si_pid.
+ */
+void fanout_ack_handler(int signo, siginfo_t *info, void *context) {
+    (void)signo;
+    (void)context;
+    for (int t = 0; t < target_count; t++) {
+        if (targets[t].pid == info->si_pid) {
+            targets[t].busy = (info->si_value.sival_int & PROTO_ACK_BUSY) != 0;
+            targets[t].acked = 1;
+            trace_event(TRACE_ACK_RECV, info->si_pid, targets[t].bit);
+            break;
+        }
     }
 }
 
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Envoie un bit du message avec sigqueue() en demandant un ACK temps
+ * réel portant le crédit du serveur
+ */
+static void send_queued_bit(struct target *t, const char *message, uint64_t now) {
+    int value = ((unsigned char)message[t->bit / 8] >> (7 - t->bit % 8)) & 1;
+    union sigval flags = {.sival_int = PROTO_FLAG_RT_ACK | PROTO_FLAG_CREDIT |
+                                       (lane == LANE_BULK ? PROTO_FLAG_BULK : 0)};
+
+    t->deadline_us = now + ACK_TIMEOUT_US;
+    trace_event(TRACE_BIT_SENT, t->pid, t->bit);
+    sigqueue(t->pid, value ? SIGUSR1 : SIGUSR2, flags);
+}
+
+/**
+ * @brief Envoie le même message à plusieurs serveurs en parallèle
+ * @param pids PID des serveurs
+ * @param count Nombre de serveurs
+ * @param message Message à envoyer
+ * @return 0 si tous les serveurs ont reçu le message, 1 sinon
+ *
+ * Chaque serveur garde son propre protocole à attente d'ACK, mais les
+ * envois sont entrelacés : dès qu'un serveur acquitte un bit, on lui envoie
+ * le suivant sans attendre les autres. La durée totale reste proche de celle
+ * d'un envoi vers un seul serveur. Un serveur saturé qui refuse un bit est
+ * mis en pause sans ralentir les autres.
+ */
+int send_fanout(char **pids, int count, char *message) {
+    struct sigaction sa;
+    sa.sa_sigaction = fanout_ack_handler;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIG_ACK_RT, &sa, NULL) == -1) {
+        perror("sigaction");
+        return 1;
+    }
+
+    targets = calloc(count, sizeof(struct target));
+    target_count = count;
+    int total_bits = strlen(message) * 8;
+    int remaining = 0;
+    uint64_t now = now_us();
+
+    for (int t = 0; t < count; t++) {
+        targets[t].pid = atoi(pids[t]);
+        printf("Envoi du message au serveur (PID: %d)\n", targets[t].pid);
+        if (total_bits > 0) {
+            send_queued_bit(&targets[t], message, now);
+            remaining++;
+        } else {
+            targets[t].done = 1;
+        }
+    }
+
+    while (remaining > 0) {
+        usleep(100);  // Interrompu par l'arrivée d'un ACK
+        now = now_us();
+        for (int t = 0; t < count; t++) {
+            struct target *target = &targets[t];
+            if (target->done || target->failed) {
+                continue;
+            }
+            if (target->resume_us) {
+                if (now >= target->resume_us) {
+                    target->resume_us = 0;
+                    send_queued_bit(target, message, now);
+                }
+            } else if (target->acked && target->busy) {
+                // Refus : pause de plus en plus longue, puis même bit
+                target->acked = 0;
+                if (target->waited_us >= FLOW_WAIT_MAX_US) {
+                    printf("Erreur: serveur saturé (PID: %d)\n", target->pid);
+                    target->failed = 1;
+                    remaining--;
+                    continue;
+                }
+                if (target->pause_us == 0) {
+                    target->pause_us = FLOW_PAUSE_MIN_US;
+                }
+                trace_event(TRACE_PAUSE, target->pid, target->pause_us);
+                target->resume_us = now + target->pause_us;
+                target->waited_us += target->pause_us;
+                if (target->pause_us < FLOW_PAUSE_MAX_US) {
+                    target->pause_us *= 2;
+                }
+            } else if (target->acked) {
+                target->acked = 0;
+                target->pause_us = 0;
+                if (++target->bit == total_bits) {
+                    target->done = 1;
+                    remaining--;
+                } else {
+                    send_queued_bit(target, message, now);
+                }
+            } else if (now > target->deadline_us) {
+                trace_event(TRACE_TIMEOUT, target->pid, target->bit);
+                printf("Erreur: Pas de réponse du serveur (PID: %d)\n", target->pid);
+                target->failed = 1;
+                remaining--;
+            }
+        }
+    }
+
+    printf("Message envoyé, envoi du signal de fin...\n");
+    usleep(1000);  // Attendre un peu avant d'envoyer le signal de fin
+    int failed = 0;
+    for (int t = 0; t < count; t++) {
+        if (targets[t].failed) {
+            failed = 1;
+            continue;
+        }
+        kill(targets[t].pid, SIGQUIT);
+        trace_event(TRACE_QUIT_SENT, targets[t].pid, strlen(message));
+    }
+    printf("Terminé.\n");
+    return failed;
+}
+
+/**
+ * @brief Envoie un message par un transport
+ * @param ops Transport utilisé
+ * @param address Adresse du serveur pour ce transport
+ * @param message Message à envoyer
+ * @param shards_path Fichier de découverte où retrouver un serveur relancé
+ * (signal avec -r), ou NULL
+ * @return 0 en cas de succès, 1 sinon
+ */
+int send_with(const struct transport_ops *ops, const char *address, char *message,
+              const char *shards_path) {
+    struct transport t;
+    memset(&t, 0, sizeof(t));
+    t.ops = ops;
+    t.lane = lane;
+    t.resume = resume;
+    t.shards = shards_path;
+    if (ops->connect(&t, address) != 0) {
+        printf("Erreur: connexion %s à %s impossible : %s\n", ops->name, address, strerror(errno));
+        return 1;
+    }
+    int result = ops->send(&t, message, strlen(message));
+    ops->close(&t);
+    if (result == 0) {
+        printf("Terminé.\n");
+    }
+    return result;
+}
+
+/**
+ * @brief Affiche les messages relayés jusqu'à la fin de l'abonnement
+ * @param sock Connexion d'abonnement
+ * @param pipe_fd Tube de réception, ou -1 si les messages arrivent sur sock
+ *
+ * Un paquet par message sur la socket ; des lignes dans le tube.
+ */
+static void print_relayed(int sock, int pipe_fd) {
+    char packet[MESSAGE_MAX + 256];
+    ssize_t n;
+    struct pollfd fds[2] = {{sock, POLLIN, 0}, {pipe_fd, POLLIN, 0}};
+    while (1) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) {
+            n = read(pipe_fd, packet, sizeof(packet));
+            if (n > 0) {
+                fwrite(packet, 1, n, stdout);
+            } else if (n == 0) {
+                fds[1].fd = -1;  // Plus d'écrivain : le serveur a fermé l'abonnement
+            }
+        }
+        if (fds[0].revents) {
+            n = recv(sock, packet, sizeof(packet) - 1, 0);
+            if (n <= 0) {
+                break;
+            }
+            packet[n] = '\0';
+            printf("%s\n", packet);
+        }
+        fflush(stdout);
+    }
+}
+
+/**
+ * @brief S'abonne à un canal et affiche les messages relayés
+ * @param address Socket de relais du serveur
+ * @param channel Canal, "*" pour tous les canaux
+ * @param fifo Tube où recevoir les messages, ou NULL pour les recevoir sur
+ * la socket
+ * @return 0 quand le serveur ferme l'abonnement, 1 en cas d'erreur
+ *
+ * Le tube est créé s'il n'existe pas et ouvert en lecture avant la
+ * demande : le serveur l'ouvre en écriture avant de répondre. Un tube créé
+ * ici est supprimé dès la réponse, les deux extrémités restant ouvertes.
+ */
+static int subscribe(const char *address, const char *channel, const char *fifo) {
+    struct transport t;
+    memset(&t, 0, sizeof(t));
+    t.ops = &transport_unix;
+    if (transport_unix.connect(&t, address) != 0) {
+        printf("Erreur: connexion au relais %s impossible : %s\n", address, strerror(errno));
+        return 1;
+    }
+    char request[256];
+    int pipe_fd = -1, created = 0;
+    if (fifo) {
+        created = mkfifo(fifo, 0600) == 0;
+        if (created || errno == EEXIST) {
+            pipe_fd = open(fifo, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        }
+        if (pipe_fd < 0) {
+            perror(fifo);
+        }
+        snprintf(request, sizeof(request), "%s fifo:%s", channel, fifo);
+    } else {
+        snprintf(request, sizeof(request), "%s unix", channel);
+    }
+
+    char reply[256];
+    ssize_t n = -1;
+    if ((!fifo || pipe_fd >= 0) && send(t.fd, request, strlen(request), MSG_NOSIGNAL) >= 0) {
+        n = recv(t.fd, reply, sizeof(reply) - 1, 0);
+    }
+    reply[n > 0 ? n : 0] = '\0';
+    if (created) {
+        unlink(fifo);
+    }
+    int status = 1;
+    if (fifo && pipe_fd < 0) {
+        // Erreur déjà affichée
+    } else if (n <= 0) {
+        printf("Erreur: pas de réponse du relais %s\n", address);
+    } else if (strncmp(reply, "ok ", 3) != 0) {
+        printf("Erreur: abonnement refusé : %s\n", reply);
+    } else {
+        printf("Abonné (canal et transport) : %s\n", reply + 3);
+        fflush(stdout);
+        print_relayed(t.fd, pipe_fd);
+        printf("Abonnement terminé par le serveur\n");
+        status = 0;
+    }
+    transport_unix.close(&t);
+    if (pipe_fd >= 0) {
+        close(pipe_fd);
+    }
+    return status;
+}
+
 /**
  * @brief Point d'entrée du programme
  * @param argc Nombre d'arguments
  * @param argv Tableau des arguments
  * @return 0 en cas de succès
  * 
- * Usage: ./client PID MESSAGE
- * - PID: ID du processus serveur
+ * Usage: ./client [-b] [-r] PID [PID...] MESSAGE
+ *        ./client [-b] [-r] -d FICHIER_SHARDS MESSAGE
+ *        ./client [-b] -u SOCKET MESSAGE
+ *        ./client [-b] -f TUBE MESSAGE
+ *        ./client -l SOCKET_RELAIS [-F TUBE] [CANAL]
+ * - PID: ID du processus serveur (plusieurs PID : mode diffusion)
  * - MESSAGE: Message à envoyer
  * 
  * Le programme envoie chaque caractère du message bit par bit au serveur
  * en utilisant SIGUSR1 pour 1 et SIGUSR2 pour 0.
  * Un signal SIGQUIT est envoyé à la fin du message.
+ * Avec plusieurs PID, le message est envoyé à tous les serveurs en
+ * parallèle (voir send_fanout()).
+ *
+ * Avec -d FICHIER_SHARDS, le serveur est choisi parmi les workers publiés
+ * par un serveur lancé avec -w, par hachage cohérent du PID du client.
+ *
+ * Avec -r (un seul serveur, refusé en mode diffusion), un serveur qui ne répond plus n'arrête pas
+ * l'envoi : le client l'attend (RESUME_WAIT_MAX_US au plus), lui demande
+ * le dernier bit qu'il a reçu et reprend à partir de là. Avec -d, le
+ * serveur relancé est retrouvé dans le fichier de découverte.
+ *
+ * Avec -u ou -f, le message est envoyé d'un bloc sur la socket Unix ou
+ * dans le tube nommé d'un serveur lancé avec la même option.
+ *
+ * Un message commençant par "#canal " est relayé aux abonnés de ce canal,
+ * les autres à ceux de "general". Avec -l, le client s'abonne au CANAL
+ * ("general" par défaut, "*" pour tous) d'un serveur lancé avec -l et
+ * affiche les messages relayés jusqu'à l'arrêt du serveur : sur la socket,
+ * ou dans TUBE avec -F.
+ *
+ * Avec -b, ou si le message dépasse LANE_INTERACTIVE_MAX octets, le
+ * message est un envoi de masse : le serveur fait passer les messages
+ * interactifs avant lui.
+ *
+ * En cas d'absence de réponse, les traces de l'envoi sont écrites dans
+ * client_trace_PID.bin ; si MINITEAMS_TRACE est défini, elles sont aussi
+ * écrites dans ce fichier à la fin de l'envoi.
  */
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        printf("Usage: %s PID MESSAGE\n", argv[0]);
+    const char *shards_path = NULL;
+    const struct transport_ops *ops = NULL;
+    const char *address = NULL;
+    const char *relay = NULL, *relay_fifo = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "+brd:u:f:l:F:")) != -1) {
+        if (opt == 'b') {
+            lane = LANE_BULK;
+        } else if (opt == 'r') {
+            resume = 1;
+        } else if (opt == 'd') {
+            shards_path = optarg;
+        } else if (opt == 'u' || opt == 'f') {
+            ops = opt == 'u' ? &transport_unix : &transport_fifo;
+            address = optarg;
+        } else if (opt == 'l') {
+            relay = optarg;
+        } else if (opt == 'F') {
+            relay_fifo = optarg;
+        } else {
+            optind = argc;
+            break;
+        }
+    }
+    int args = argc - optind;
+    int single = shards_path || ops;
+    if (relay && args <= 1) {
+        return subscribe(relay, args == 1 ? argv[optind] : RELAY_DEFAULT_CHANNEL, relay_fifo);
+    }
+    if (relay || relay_fifo || args < (single ? 1 : 2) || (single && args != 1)) {
+        printf("Usage: %s [-b] [-r] PID [PID...] MESSAGE\n"
+               "       %s [-b] [-r] -d FICHIER_SHARDS MESSAGE\n"
+               "       %s [-b] -u SOCKET MESSAGE\n"
+               "       %s [-b] -f TUBE MESSAGE\n"
+               "       %s -l SOCKET_RELAIS [-F TUBE] [CANAL]\n", argv[0], argv[0], argv[0], argv[0],
+               argv[0]);
         return 1;
     }
-
-    // Configuration du handler pour l'accusé de réception
-    struct sigaction sa;
-    sa.sa_handler = ack_handler;
-    sa.sa_flags = 0;
-    sigemptyset(&sa.sa_mask);
-    if (sigaction(SIGUSR1, &sa, NULL) == -1) {
-        perror("sigaction");
+    if (resume && (ops || (!shards_path && args > 2))) {
+        printf("Erreur: -r n'est possible qu'avec un seul serveur joint par signaux (PID ou -d)\n");
         return 1;
     }
 
-    int pid = atoi(argv[1]);
-    char *message = argv[2];
-    int timeout_count;
-
-    printf("Envoi du message au serveur (PID: %d)\n", pid);
-
-    for (int i = 0; i < strlen(message); i++) {
-        char binary[9];
-        char_to_binary(message[i], binary);
-        
-        for (int j = 0; j < 8; j++) {
-            ack_received = 0;
-            timeout_count = 0;
-            
-            // Envoi du bit
-            if (binary[j] == '1') {
-                kill(pid, SIGUSR1);
-            } else {
-                kill(pid, SIGUSR2);
-            }
-
-            // Attente de l'accusé de réception avec timeout
-            while (!ack_received && timeout_count < 1000) {
-                usleep(100);
-                timeout_count++;
-            }
+    char *message = argv[argc - 1];
+    int result;
+    if (strlen(message) > LANE_INTERACTIVE_MAX) {
+        lane = LANE_BULK;
+    }
 
-            if (!ack_received) {
-                printf("Erreur: Pas de réponse du serveur\n");
-                return 1;
-            }
+    trace_init();
 
-            // Petit délai entre chaque bit pour stabilité
-            usleep(100);
+    if (ops) {
+        result = send_with(ops, address, message, NULL);
+    } else if (shards_path) {
+        struct shard_map map;
+        int shard;
+        if (shards_read(shards_path, &map) <= 0 || (shard = shards_pick(&map, getpid())) < 0) {
+            printf("Erreur: aucun worker dans %s\n", shards_path);
+            return 1;
         }
+        printf("Shard %d choisi\n", shard);
+        char pid[16];
+        snprintf(pid, sizeof(pid), "%d", map.pids[shard]);
+        result = send_with(&transport_signal, pid, message, shards_path);
+    } else if (args == 2) {
+        result = send_with(&transport_signal, argv[optind], message, NULL);
+    } else {
+        result = send_fanout(&argv[optind], args - 1, message);
     }
 
-    printf("Message envoyé, envoi du signal de fin...\n");
-    usleep(1000);  // Attendre un peu avant d'envoyer le signal de fin
-    kill(pid, SIGQUIT);
-    printf("Terminé.\n");
-    
-    return 0;
+    if (result != 0 || getenv("MINITEAMS_TRACE")) {
+        dump_trace(getenv("MINITEAMS_TRACE"));
+    }
+    return result;
 }
@@ -1 +1 @@
-gcc client.c -o client
\ No newline at end of file
+gcc client.c trace.c shards.c metrics.c session.c journal.c transport.c transport_signal.c transport_unix.c transport_fifo.c transport_uring.c msgbuf.c capture.c scheduler.c -o client -pthread
\ No newline at end of file
@@ -0,0 +1,240 @@
+/**
+ * @file config.c
+ * @brief Fichier de configuration du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Chaque clé est décrite par une entrée de la table keys : type, position
+ * dans struct config et moment de prise en compte. Le fichier est lu
+ * entièrement dans une copie des réglages ; ceux-ci ne sont modifiés que
+ * si toutes les lignes sont valides.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include "config.h"
+
+enum config_type {
+    CONFIG_STRING,          /**< Chaîne (chemin...) */
+    CONFIG_UNSIGNED,        /**< Entier positif ou nul */
+    CONFIG_INT,             /**< Entier signé */
+    CONFIG_BOOL,            /**< oui/non, 1/0 */
+    CONFIG_LIST,            /**< Chaîne répétable */
+};
+
+/** @brief Description d'une clé */
+struct config_key {
+    const char *name;
+    enum config_type type;
+    size_t offset;          /**< Position du champ dans struct config */
+    size_t size;            /**< Chaîne : taille du champ (d'un élément pour une liste) */
+    size_t count_offset;    /**< Liste : position du nombre d'éléments */
+    int reloadable;         /**< Pris en compte par "reload" */
+};
+
+#define STRING(key, field, reload) \
+    {key, CONFIG_STRING, offsetof(struct config, field), sizeof(((struct config *)0)->field), 0, reload}
+#define NUMBER(key, type, field, reload) \
+    {key, type, offsetof(struct config, field), sizeof(((struct config *)0)->field), 0, reload}
+#define LIST(key, field, count) \
+    {key, CONFIG_LIST, offsetof(struct config, field), sizeof(((struct config *)0)->field[0]), \
+     offsetof(struct config, count), 0}
+
+static const struct config_key keys[] = {
+    STRING("log", log, 0),
+    STRING("metriques", metrics, 0),
+    NUMBER("metriques_periode_ms", CONFIG_UNSIGNED, metrics_interval_ms, 0),
+    STRING("controle", control, 0),
+    STRING("shards", shards, 0),
+    STRING("capture", capture, 0),
+    LIST("socket", sockets, socket_count),
+    LIST("tube", fifos, fifo_count),
+    STRING("boucle", loop, 0),
+    NUMBER("workers", CONFIG_UNSIGNED, workers, 0),
+    NUMBER("historique", CONFIG_INT, history, 0),
+    NUMBER("historique_async", CONFIG_BOOL, history_async, 0),
+    NUMBER("tampons", CONFIG_UNSIGNED, pool, 0),
+    NUMBER("cache_langues", CONFIG_UNSIGNED, cache_bytes, 0),
+    STRING("cpu_reception", cpus[0], 0),
+    STRING("cpu_detection", cpus[1], 0),
+    STRING("cpu_index", cpus[2], 0),
+    STRING("journal", journal, 0),
+    STRING("relais", relay, 0),
+    STRING("profil", profile, 1),
+    NUMBER("delai_ack_masse_us", CONFIG_UNSIGNED, bulk_ack_delay_us, 1),
+    NUMBER("index_inactivite_ms", CONFIG_UNSIGNED, index_idle_ms, 1),
+    NUMBER("debit", CONFIG_UNSIGNED, rate, 1),
+    NUMBER("rafale", CONFIG_UNSIGNED, burst, 1),
+    NUMBER("quantum", CONFIG_UNSIGNED, quantum, 1),
+    NUMBER("delai_arret_ms", CONFIG_UNSIGNED, drain_timeout_ms, 1),
+};
+
+#define KEY_COUNT (sizeof(keys) / sizeof(keys[0]))
+
+/** @brief Retire les blancs au début et à la fin d'une chaîne */
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+    size_t length = strlen(s);
+    while (length > 0 && isspace((unsigned char)s[length - 1])) {
+        s[--length] = '\0';
+    }
+    return s;
+}
+
+/**
+ * @brief Range la valeur d'une clé dans les réglages
+ * @param seen Listes déjà rencontrées dans ce fichier (un bit par clé)
+ * @return 0 en cas de succès, -1 si la valeur est invalide
+ *
+ * La première occurrence d'une liste dans le fichier remplace ses éléments
+ * précédents.
+ */
+static int set_value(const struct config_key *key, struct config *config, const char *value,
+                     unsigned *seen) {
+    char *field = (char *)config + key->offset;
+    char *end;
+    errno = 0;
+    switch (key->type) {
+    case CONFIG_STRING:
+        if (strlen(value) >= key->size) {
+            return -1;
+        }
+        strcpy(field, value);
+        return 0;
+    case CONFIG_LIST: {
+        int *count = (int *)((char *)config + key->count_offset);
+        unsigned bit = 1u << (key - keys);
+        if (!(*seen & bit)) {
+            *seen |= bit;
+            *count = 0;
+        }
+        if (*count >= TRANSPORT_MAX || strlen(value) >= key->size || value[0] == '\0') {
+            return -1;
+        }
+        strcpy(field + *count * key->size, value);
+        (*count)++;
+        return 0;
+    }
+    case CONFIG_UNSIGNED: {
+        unsigned long n = strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || errno != 0 || value[0] == '-' || n > 0xFFFFFFFFul) {
+            return -1;
+        }
+        *(unsigned *)field = n;
+        return 0;
+    }
+    case CONFIG_INT: {
+        long n = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || errno != 0 || n < -0x7FFFFFFFL || n > 0x7FFFFFFFL) {
+            return -1;
+        }
+        *(int *)field = n;
+        return 0;
+    }
+    case CONFIG_BOOL:
+        if (strcmp(value, "oui") == 0 || strcmp(value, "1") == 0) {
+            *(int *)field = 1;
+        } else if (strcmp(value, "non") == 0 || strcmp(value, "0") == 0) {
+            *(int *)field = 0;
+        } else {
+            return -1;
+        }
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief Lit un fichier de configuration
+ * @param config Réglages, modifiés seulement si tout le fichier est valide
+ * @param errors Flux où décrire les erreurs
+ * @return 0 en cas de succès, -1 sinon (fichier illisible ou ligne invalide)
+ */
+int config_load(const char *path, struct config *config, FILE *errors) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        fprintf(errors, "%s : %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct config loaded = *config;
+    unsigned seen = 0;
+    char line[512];
+    int number = 0, error = 0;
+    while (!error && fgets(line, sizeof(line), in)) {
+        number++;
+        char *text = trim(line);
+        if (text[0] == '\0' || text[0] == '#') {
+            continue;
+        }
+        char *equal = strchr(text, '=');
+        if (!equal) {
+            fprintf(errors, "%s:%d : \"clé = valeur\" attendu\n", path, number);
+            error = 1;
+            break;
+        }
+        *equal = '\0';
+        char *name = trim(text);
+        char *value = trim(equal + 1);
+        const struct config_key *key = NULL;
+        for (size_t i = 0; i < KEY_COUNT && !key; i++) {
+            if (strcmp(keys[i].name, name) == 0) {
+                key = &keys[i];
+            }
+        }
+        if (!key) {
+            fprintf(errors, "%s:%d : clé inconnue : %s\n", path, number, name);
+            error = 1;
+        } else if (set_value(key, &loaded, value, &seen) != 0) {
+            fprintf(errors, "%s:%d : valeur invalide pour %s : %s\n", path, number, name, value);
+            error = 1;
+        }
+    }
+    fclose(in);
+    if (error) {
+        return -1;
+    }
+    *config = loaded;
+    return 0;
+}
+
+/**
+ * @brief Liste les réglages changés qui ne sont pris en compte qu'au
+ * redémarrage
+ * @param out Flux où écrire les clés concernées
+ * @return Nombre de clés concernées
+ */
+int config_restart_needed(const struct config *current, const struct config *loaded, FILE *out) {
+    int count = 0;
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+        const struct config_key *key = &keys[i];
+        if (key->reloadable) {
+            continue;
+        }
+        const char *a = (const char *)current + key->offset;
+        const char *b = (const char *)loaded + key->offset;
+        int changed;
+        if (key->type == CONFIG_LIST) {
+            int na = *(const int *)((const char *)current + key->count_offset);
+            int nb = *(const int *)((const char *)loaded + key->count_offset);
+            changed = na != nb;
+            for (int j = 0; j < na && !changed; j++) {
+                changed = strcmp(a + j * key->size, b + j * key->size) != 0;
+            }
+        } else if (key->type == CONFIG_STRING) {
+            changed = strcmp(a, b) != 0;
+        } else {
+            changed = memcmp(a, b, key->size) != 0;
+        }
+        if (changed) {
+            fprintf(out, "%s : pris en compte au redémarrage\n", key->name);
+            count++;
+        }
+    }
+    return count;
+}
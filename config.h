@@ -0,0 +1,74 @@
+/**
+ * @file config.h
+ * @brief Fichier de configuration du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Une ligne "clé = valeur" par réglage ; les lignes vides et commençant
+ * par '#' sont ignorées. Une clé absente du fichier garde sa valeur (par
+ * défaut, ou donnée en option de la ligne de commande). "socket" et
+ * "tube" peuvent être répétées.
+ *
+ * Pris en compte au démarrage seulement :
+ *   log, metriques, metriques_periode_ms, controle, shards (sans
+ *   workers, "" par défaut : le serveur ne se publie pas), capture,
+ *   socket, tube, boucle (io_uring ou epoll), workers, historique,
+ *   historique_async, tampons, cache_langues, cpu_reception,
+ *   cpu_detection, cpu_index (listes de CPU, "0-3,8" : voir placement.h),
+ *   journal (sessions en cours, "" : aucun), relais (socket des abonnés,
+ *   "" : aucun)
+ * Rechargés à chaud par la commande de contrôle "reload" :
+ *   profil, delai_ack_masse_us, index_inactivite_ms, debit, rafale, quantum,
+ *   delai_arret_ms
+ *
+ * Exemple : miniteams.conf.example
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdio.h>
+
+#include "transport.h"
+
+/** @brief Fichier lu au démarrage s'il existe (option -C pour un autre) */
+#define CONFIG_FILE "miniteams.conf"
+/** @brief Taille maximale d'un chemin */
+#define CONFIG_PATH_MAX 256
+
+/** @brief Réglages du serveur */
+struct config {
+    // Démarrage
+    char log[CONFIG_PATH_MAX];              /**< Log des messages */
+    char metrics[CONFIG_PATH_MAX];          /**< Fichier de métriques */
+    unsigned metrics_interval_ms;           /**< Période de réécriture des métriques */
+    char control[108];                      /**< Socket de contrôle ("" : chemin par défaut) */
+    char shards[CONFIG_PATH_MAX];           /**< PID des workers */
+    char capture[CONFIG_PATH_MAX];          /**< Capture des signaux ("" : aucune) */
+    char sockets[TRANSPORT_MAX][108];       /**< Sockets Unix écoutées */
+    int socket_count;
+    char fifos[TRANSPORT_MAX][108];         /**< Tubes nommés écoutés */
+    int fifo_count;
+    char loop[16];                          /**< Boucle d'événements : "io_uring" ou "epoll" */
+    unsigned workers;                       /**< Workers (0 : un seul processus) */
+    int history;                            /**< Messages de l'historique affichés (-1 : tous) */
+    int history_async;                      /**< Historique affiché par un thread */
+    unsigned pool;                          /**< Tampons de la réserve */
+    unsigned cache_bytes;                   /**< Taille du cache des langues */
+    char cpus[3][64];                       /**< CPU par rôle (enum placement_role, "" : non fixé) */
+    char journal[CONFIG_PATH_MAX];          /**< Journal des sessions en cours ("" : aucun) */
+    char relay[108];                        /**< Socket du relais vers les abonnés ("" : aucun) */
+    // À chaud
+    char profile[CONFIG_PATH_MAX];          /**< Profil de langues ("" : tables intégrées) */
+    unsigned bulk_ack_delay_us;             /**< Délai avant l'ACK d'un bit d'envoi de masse */
+    unsigned index_idle_ms;                 /**< Inactivité avant l'écriture du bloc d'index */
+    unsigned rate;                          /**< Débit par client (0 : sans limite) */
+    unsigned burst;                         /**< Rafale par client */
+    unsigned quantum;                       /**< Signaux servis par client et par tour */
+    unsigned drain_timeout_ms;              /**< Arrêt : délai laissé aux envois en cours */
+};
+
+int config_load(const char *path, struct config *config, FILE *errors);
+int config_restart_needed(const struct config *current, const struct config *loaded, FILE *out);
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file control.c
+ * @brief Socket de contrôle du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un thread dédié accepte les connexions une par une : les commandes sont
+ * rares et courtes, il n'y a pas besoin de plus. Le thread bloque tous les
+ * signaux pour ne jamais voler ceux destinés au thread principal.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "control.h"
+
+/** @brief Commande enregistrée */
+struct control_command {
+    const char *name;
+    const char *help;
+    control_handler fn;
+};
+
+static struct control_command commands[CONTROL_MAX_COMMANDS];
+static int command_count = 0;
+static char socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static int listen_fd = -1;
+
+/**
+ * @brief Enregistre une commande de contrôle
+ * @return 0 en cas de succès, -1 si la table est pleine
+ *
+ * À appeler avant control_start().
+ */
+int control_register(const char *name, const char *help, control_handler fn) {
+    if (command_count >= CONTROL_MAX_COMMANDS) {
+        return -1;
+    }
+    commands[command_count].name = name;
+    commands[command_count].help = help;
+    commands[command_count].fn = fn;
+    command_count++;
+    return 0;
+}
+
+/** @brief Commande intégrée : liste les commandes disponibles */
+static void help_command(int argc, char *argv[], FILE *reply) {
+    (void)argc;
+    (void)argv;
+    fprintf(reply, "Commandes disponibles :\n");
+    for (int i = 0; i < command_count; i++) {
+        fprintf(reply, "  %-10s %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+/** @brief Découpe une ligne de commande et exécute la commande */
+static void dispatch(char *line, FILE *reply) {
+    char *argv[16];
+    int argc = 0;
+    for (char *tok = strtok(line, " \t\r\n"); tok && argc < 16; tok = strtok(NULL, " \t\r\n")) {
+        argv[argc++] = tok;
+    }
+    if (argc == 0) {
+        return;
+    }
+    for (int i = 0; i < command_count; i++) {
+        if (strcmp(argv[0], commands[i].name) == 0) {
+            commands[i].fn(argc, argv, reply);
+            return;
+        }
+    }
+    fprintf(reply, "Commande inconnue : %s (voir \"help\")\n", argv[0]);
+}
+
+static void *control_thread(void *arg) {
+    (void)arg;
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        FILE *conn = fdopen(fd, "r+");
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        char line[4096];
+        if (fgets(line, sizeof(line), conn)) {
+            fseek(conn, 0, SEEK_CUR);  // Passage lecture -> écriture sur le flux
+            dispatch(line, conn);
+        }
+        fclose(conn);
+    }
+    return NULL;
+}
+
+static void remove_socket(void) {
+    if (socket_path[0]) {
+        unlink(socket_path);
+    }
+}
+
+/**
+ * @brief Ouvre la socket de contrôle et démarre le thread qui la sert
+ * @param path Chemin de la socket Unix
+ * @return 0 en cas de succès, -1 sinon
+ */
+int control_start(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 8) < 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    strcpy(socket_path, path);
+    atexit(remove_socket);
+    control_register("help", "liste les commandes", help_command);
+
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    pthread_t thread;
+    int err = pthread_create(&thread, NULL, control_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file control.h
+ * @brief Socket de contrôle du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Le serveur écoute sur une socket Unix locale des commandes texte d'une
+ * ligne (par exemple "trace fichier.bin" ou "stats"), envoyées avec l'outil
+ * ctl. Chaque commande écrit sa réponse sur la connexion puis la ferme.
+ */
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdio.h>
+
+/** @brief Chemin par défaut de la socket de contrôle (%d = PID du serveur) */
+#define CONTROL_PATH_FORMAT "/tmp/miniteams-%d.sock"
+
+/** @brief Nombre maximal de commandes enregistrées */
+#define CONTROL_MAX_COMMANDS 32
+
+/**
+ * @brief Fonction exécutant une commande
+ * @param argc Nombre de mots de la commande (nom compris)
+ * @param argv Mots de la commande
+ * @param reply Flux de réponse vers l'appelant
+ */
+typedef void (*control_handler)(int argc, char *argv[], FILE *reply);
+
+int control_register(const char *name, const char *help, control_handler fn);
+int control_start(const char *path);
+
+#endif
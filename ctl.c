@@ -0,0 +1,64 @@
+/**
+ * @file ctl.c
+ * @brief Envoi de commandes à la socket de contrôle du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Usage: ./ctl PID|SOCKET COMMANDE [ARGS...]
+ * - PID: PID du serveur (socket /tmp/miniteams-PID.sock)
+ * - SOCKET: chemin explicite de la socket de contrôle
+ *
+ * Exemples : ./ctl 1234 stats, ./ctl 1234 trace serveur.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "control.h"
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("Usage: %s PID|SOCKET COMMANDE [ARGS...]\n", argv[0]);
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (isdigit((unsigned char)argv[1][0])) {
+        snprintf(addr.sun_path, sizeof(addr.sun_path), CONTROL_PATH_FORMAT, atoi(argv[1]));
+    } else {
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", argv[1]);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror(addr.sun_path);
+        return 1;
+    }
+
+    // Commande sur une ligne : les mots sont séparés par des espaces
+    char line[4096] = "";
+    for (int i = 2; i < argc; i++) {
+        strncat(line, argv[i], sizeof(line) - strlen(line) - 2);
+        strcat(line, i + 1 < argc ? " " : "\n");
+    }
+    if (write(fd, line, strlen(line)) < 0) {
+        perror("write");
+        return 1;
+    }
+    shutdown(fd, SHUT_WR);
+
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        fwrite(buf, 1, n, stdout);
+    }
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file history.c
+ * @brief Relecture de l'historique des messages
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * En mode multi-processus chaque worker écrit son propre segment de log
+ * (server_log.N.txt). L'historique est reconstitué à la lecture par une
+ * fusion des segments selon l'horodatage en tête de chaque ligne.
+ *
+ * history_print_tail() n'affiche que les derniers messages : chaque segment
+ * est lu à reculons par blocs depuis sa fin, sans parcourir le début du
+ * fichier. Son coût ne dépend que du nombre de messages affichés.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glob.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "history.h"
+
+/** @brief Segment de log en cours de fusion */
+struct segment {
+    FILE *file;
+    char line[4096];
+    time_t stamp;
+    int has_line;
+};
+
+/**
+ * @brief Lit l'horodatage "[jj-mm-aaaa hh:mm:ss]" en tête d'une ligne
+ * @return 0 en cas de succès, -1 si la ligne n'en a pas
+ */
+static int parse_stamp(const char *line, time_t *stamp) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (sscanf(line, "[%d-%d-%d %d:%d:%d]", &tm.tm_mday, &tm.tm_mon, &tm.tm_year,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return -1;
+    }
+    tm.tm_mon -= 1;
+    tm.tm_year -= 1900;
+    tm.tm_isdst = -1;
+    *stamp = mktime(&tm);
+    return 0;
+}
+
+/**
+ * @brief Lit la ligne suivante d'un segment
+ *
+ * Une ligne sans horodatage (suite d'un message long ou multiligne)
+ * garde celui de la ligne précédente pour rester à sa place.
+ */
+static void advance(struct segment *seg) {
+    seg->has_line = fgets(seg->line, sizeof(seg->line), seg->file) != NULL;
+    if (seg->has_line) {
+        parse_stamp(seg->line, &seg->stamp);
+    }
+}
+
+/** @brief Message lu à la fin d'un segment (une ou plusieurs lignes) */
+struct tail_entry {
+    time_t stamp;
+    int segment;
+    long order;         /**< Rang dans le segment, pour départager */
+    char *text;
+};
+
+/**
+ * @brief Lit les derniers messages d'un segment en remontant depuis la fin
+ * @param fd Segment ouvert en lecture
+ * @param count Nombre de messages voulus
+ * @param entries Tableau à compléter (count places libres au moins)
+ * @return Nombre de messages lus, dans l'ordre du fichier
+ *
+ * Un message commence par une ligne horodatée ; les lignes qui la suivent
+ * sans horodatage (message multiligne) en font partie.
+ */
+static int read_tail(int fd, int segment, int count, struct tail_entry *entries) {
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        return 0;
+    }
+    char *block = malloc(HISTORY_BLOCK);
+    char *pending = NULL;       // Fin de ligne déjà lue (blocs suivants)
+    size_t pending_len = 0;
+    char *record = NULL;        // Lignes sans horodatage en attente de leur tête
+    size_t record_len = 0;
+    int found = 0;
+    off_t end = st.st_size;
+
+    while (block && end > 0 && found < count) {
+        off_t start = end > HISTORY_BLOCK ? end - HISTORY_BLOCK : 0;
+        ssize_t n = pread(fd, block, end - start, start);
+        if (n <= 0) {
+            break;
+        }
+        end = start;
+
+        // Découpe du bloc de la fin vers le début ; une ligne est complète
+        // quand on trouve le '\n' qui la précède (ou le début du fichier)
+        ssize_t line_end = n;
+        for (ssize_t i = n - 1; i >= -1 && found < count; i--) {
+            if (i >= 0 && block[i] != '\n') {
+                continue;
+            }
+            if (i == n - 1 && pending_len == 0 && start + n == st.st_size) {
+                line_end = i;   // '\n' final du fichier
+                continue;
+            }
+            if (i < 0 && start > 0) {
+                break;          // Début de ligne dans le bloc précédent
+            }
+            size_t len = line_end - (i + 1);
+            char *line = malloc(len + pending_len + record_len + 2);
+            memcpy(line, block + i + 1, len);
+            memcpy(line + len, pending, pending_len);
+            len += pending_len;
+            free(pending);
+            pending = NULL;
+            pending_len = 0;
+            line[len++] = '\n';
+
+            time_t stamp;
+            if (parse_stamp(line, &stamp) == 0) {
+                memcpy(line + len, record, record_len);
+                line[len + record_len] = '\0';
+                free(record);
+                record = NULL;
+                record_len = 0;
+                entries[count - 1 - found] = (struct tail_entry){stamp, segment, -found, line};
+                found++;
+            } else {
+                // Suite d'un message : accolée devant les lignes déjà vues
+                char *joined = malloc(len + record_len + 1);
+                memcpy(joined, line, len);
+                memcpy(joined + len, record, record_len);
+                free(line);
+                free(record);
+                record = joined;
+                record_len += len;
+                record[record_len] = '\0';
+            }
+            line_end = i;
+        }
+
+        // Début de ligne incomplet : gardé pour le bloc précédent
+        if (found < count && line_end > 0) {
+            char *joined = malloc(line_end + pending_len);
+            memcpy(joined, block, line_end);
+            memcpy(joined + line_end, pending, pending_len);
+            free(pending);
+            pending = joined;
+            pending_len += line_end;
+        }
+    }
+    free(block);
+    free(pending);
+    free(record);
+
+    // Les messages ont été rangés depuis la fin du tableau
+    memmove(entries, entries + count - found, found * sizeof(*entries));
+    return found;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const struct tail_entry *x = a, *y = b;
+    if (x->stamp != y->stamp) {
+        return x->stamp < y->stamp ? -1 : 1;
+    }
+    if (x->segment != y->segment) {
+        return x->segment - y->segment;
+    }
+    return x->order < y->order ? -1 : x->order > y->order;
+}
+
+/**
+ * @brief Affiche les derniers messages des segments, fusionnés par date
+ * @param pattern Motif glob des segments (ex. "server_log*.txt")
+ * @param count Nombre maximal de messages affichés
+ * @param out Flux de sortie
+ * @return Nombre de messages affichés
+ *
+ * Les count derniers messages de chaque segment sont lus depuis la fin,
+ * triés par date, et seuls les count plus récents sont affichés.
+ */
+int history_print_tail(const char *pattern, int count, FILE *out) {
+    glob_t files;
+    if (count <= 0 || glob(pattern, 0, NULL, &files) != 0) {
+        return 0;
+    }
+
+    struct tail_entry *entries = calloc((size_t)count * files.gl_pathc, sizeof(*entries));
+    int total = 0;
+    for (size_t i = 0; entries && i < files.gl_pathc; i++) {
+        int fd = open(files.gl_pathv[i], O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            total += read_tail(fd, i, count, entries + total);
+            close(fd);
+        }
+    }
+    qsort(entries, total, sizeof(*entries), compare_entries);
+
+    int first = total > count ? total - count : 0;
+    for (int i = 0; i < total; i++) {
+        if (i >= first) {
+            fputs(entries[i].text, out);
+        }
+        free(entries[i].text);
+    }
+    free(entries);
+    globfree(&files);
+    return total - first;
+}
+
+/**
+ * @brief Affiche les segments de log correspondant au motif, fusionnés par date
+ * @param pattern Motif glob des segments (ex. "server_log*.txt")
+ * @param out Flux de sortie
+ */
+void history_print(const char *pattern, FILE *out) {
+    glob_t files;
+    if (glob(pattern, 0, NULL, &files) != 0) {
+        return;
+    }
+
+    struct segment *segments = calloc(files.gl_pathc, sizeof(*segments));
+    int count = 0;
+    for (size_t i = 0; i < files.gl_pathc; i++) {
+        FILE *f = fopen(files.gl_pathv[i], "r");
+        if (f) {
+            segments[count].file = f;
+            advance(&segments[count]);
+            count++;
+        }
+    }
+
+    int last = -1;
+    while (1) {
+        int best = -1;
+        for (int i = 0; i < count; i++) {
+            if (!segments[i].has_line) {
+                continue;
+            }
+            if (best < 0 || segments[i].stamp < segments[best].stamp ||
+                (segments[i].stamp == segments[best].stamp && i == last)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        fputs(segments[best].line, out);
+        last = best;
+        advance(&segments[best]);
+    }
+
+    for (int i = 0; i < count; i++) {
+        fclose(segments[i].file);
+    }
+    free(segments);
+    globfree(&files);
+}
@@ -0,0 +1,19 @@
+/**
+ * @file history.h
+ * @brief Relecture de l'historique des messages
+ * @author silverhawks
+ * @date 06/01/25
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdio.h>
+
+/** @brief Taille des blocs lus depuis la fin d'un segment */
+#define HISTORY_BLOCK (64 * 1024)
+
+void history_print(const char *pattern, FILE *out);
+int history_print_tail(const char *pattern, int count, FILE *out);
+
+#endif
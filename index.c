@@ -0,0 +1,442 @@
+/**
+ * @file index.c
+ * @brief Index plein texte des messages du log
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Écriture : les termes d'un message sont ajoutés à une table de hachage
+ * en mémoire (une liste de positions par terme) ; l'écriture d'un bloc trie
+ * les termes et vide la table. Le coût par message est donc celui de son
+ * découpage en termes, l'écriture disque étant regroupée.
+ *
+ * Lecture : le fichier est projeté en mémoire ; dans chaque bloc, un terme
+ * (ou le premier terme d'un préfixe) est trouvé par dichotomie. Les blocs
+ * sont écrits dans l'ordre du log : leurs listes, mises bout à bout, sont
+ * déjà triées.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "index.h"
+#include "token.h"
+
+/** @brief Taille initiale de la table de hachage */
+#define INDEX_TABLE_INITIAL 4096
+
+/**
+ * @brief Chemin de l'index d'un segment de log
+ *
+ * server_log.txt donne server_log.idx, server_log.3.txt donne
+ * server_log.3.idx ; un autre nom reçoit le suffixe ".idx".
+ */
+void index_path_for(const char *log_path, char *path, size_t size) {
+    size_t length = strlen(log_path);
+    if (length > 4 && strcmp(log_path + length - 4, ".txt") == 0) {
+        snprintf(path, size, "%.*s.idx", (int)(length - 4), log_path);
+    } else {
+        snprintf(path, size, "%s.idx", log_path);
+    }
+}
+
+/**
+ * @brief Extrait le terme suivant d'un texte
+ * @param pos Position courante, avancée après le terme
+ * @param term Terme en minuscules (INDEX_TERM_MAX octets, sans terminateur)
+ * @return Longueur du terme, 0 s'il n'y en a plus
+ *
+ * Les termes sont les mots de token_next(). Ceux de moins de
+ * INDEX_TERM_MIN octets sont ignorés.
+ */
+size_t index_next_term(const char *text, size_t length, size_t *pos, char *term) {
+    struct token_span span;
+    while (token_next(text, length, pos, &span)) {
+        if (span.length >= INDEX_TERM_MIN) {
+            return token_lower(text, &span, term, INDEX_TERM_MAX);
+        }
+    }
+    return 0;
+}
+
+static uint32_t hash_term(const char *term, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h = (h ^ (unsigned char)term[i]) * 16777619u;
+    }
+    return h;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Écriture                                                                  */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief Ouvre le fichier d'index en ajout
+ * @return 0 en cas de succès, -1 sinon
+ */
+int index_writer_open(struct index_writer *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+    w->entries = calloc(INDEX_TABLE_INITIAL, sizeof(*w->entries));
+    if (!w->entries) {
+        return -1;
+    }
+    w->capacity = INDEX_TABLE_INITIAL;
+    w->file = fopen(path, "ab");
+    if (!w->file) {
+        free(w->entries);
+        return -1;
+    }
+    return 0;
+}
+
+/** @brief Double la table de hachage */
+static int grow(struct index_writer *w) {
+    uint32_t capacity = w->capacity * 2;
+    struct index_entry *entries = calloc(capacity, sizeof(*entries));
+    if (!entries) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < w->capacity; i++) {
+        struct index_entry *e = &w->entries[i];
+        if (e->length) {
+            uint32_t slot = hash_term(e->term, e->length) & (capacity - 1);
+            while (entries[slot].length) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            entries[slot] = *e;
+        }
+    }
+    free(w->entries);
+    w->entries = entries;
+    w->capacity = capacity;
+    return 0;
+}
+
+/** @brief Ajoute une position à la liste d'un terme (une fois par message) */
+static void add_posting(struct index_writer *w, const char *term, size_t length, uint64_t offset) {
+    if ((w->used + 1) * 10 > w->capacity * 7 && grow(w) != 0) {
+        return;
+    }
+    uint32_t slot = hash_term(term, length) & (w->capacity - 1);
+    struct index_entry *e;
+    while (1) {
+        e = &w->entries[slot];
+        if (!e->length) {
+            memcpy(e->term, term, length);
+            e->length = length;
+            w->used++;
+            break;
+        }
+        if (e->length == length && memcmp(e->term, term, length) == 0) {
+            if (e->count && e->last == offset) {
+                return;  // Terme déjà vu dans ce message
+            }
+            break;
+        }
+        slot = (slot + 1) & (w->capacity - 1);
+    }
+
+    if (e->used + 10 > e->capacity) {
+        uint32_t capacity = e->capacity ? e->capacity * 2 : 16;
+        unsigned char *postings = realloc(e->postings, capacity);
+        if (!postings) {
+            return;
+        }
+        e->postings = postings;
+        e->capacity = capacity;
+    }
+    uint64_t delta = e->count ? offset - e->last : offset;
+    do {
+        unsigned char byte = delta & 0x7F;
+        delta >>= 7;
+        e->postings[e->used++] = byte | (delta ? 0x80 : 0);
+    } while (delta);
+    e->last = offset;
+    e->count++;
+}
+
+/**
+ * @brief Indexe un message
+ * @param offset Position du message dans le log
+ *
+ * Les positions doivent être croissantes. Un bloc est écrit tous les
+ * INDEX_FLUSH_RECORDS messages.
+ */
+void index_writer_add(struct index_writer *w, uint64_t offset, const char *text, size_t length) {
+    char term[INDEX_TERM_MAX];
+    size_t pos = 0, n;
+    while ((n = index_next_term(text, length, &pos, term)) > 0) {
+        add_posting(w, term, n, offset);
+    }
+    if (++w->records >= INDEX_FLUSH_RECORDS) {
+        index_writer_flush(w);
+    }
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const struct index_entry *x = *(struct index_entry *const *)a;
+    const struct index_entry *y = *(struct index_entry *const *)b;
+    int c = memcmp(x->term, y->term, x->length < y->length ? x->length : y->length);
+    return c ? c : x->length - y->length;
+}
+
+/**
+ * @brief Écrit un bloc avec les termes accumulés et vide la table
+ * @return 0 en cas de succès, -1 sinon
+ */
+int index_writer_flush(struct index_writer *w) {
+    if (w->records == 0) {
+        return 0;
+    }
+    struct index_entry **sorted = malloc(w->used * sizeof(*sorted));
+    struct index_term *terms = malloc(w->used * sizeof(*terms));
+    if (!sorted || !terms) {
+        free(sorted);
+        free(terms);
+        return -1;
+    }
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < w->capacity; i++) {
+        if (w->entries[i].length) {
+            sorted[count++] = &w->entries[i];
+        }
+    }
+    qsort(sorted, count, sizeof(*sorted), compare_entries);
+
+    struct index_block_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.term_count = count;
+    header.records = w->records;
+    for (uint32_t i = 0; i < count; i++) {
+        terms[i] = (struct index_term){
+            .string = header.strings_bytes,
+            .length = sorted[i]->length,
+            .count = sorted[i]->count,
+            .postings_length = sorted[i]->used,
+            .postings = header.postings_bytes,
+        };
+        header.strings_bytes += sorted[i]->length;
+        header.postings_bytes += sorted[i]->used;
+    }
+
+    int result = 0;
+    if (fwrite(&header, sizeof(header), 1, w->file) != 1 ||
+        fwrite(terms, sizeof(*terms), count, w->file) != count) {
+        result = -1;
+    }
+    for (uint32_t i = 0; i < count && result == 0; i++) {
+        if (fwrite(sorted[i]->term, 1, sorted[i]->length, w->file) != sorted[i]->length) {
+            result = -1;
+        }
+    }
+    for (uint32_t i = 0; i < count && result == 0; i++) {
+        if (fwrite(sorted[i]->postings, 1, sorted[i]->used, w->file) != sorted[i]->used) {
+            result = -1;
+        }
+    }
+    if (fflush(w->file) != 0) {
+        result = -1;
+    }
+
+    // La table garde sa taille pour le bloc suivant
+    for (uint32_t i = 0; i < w->capacity; i++) {
+        free(w->entries[i].postings);
+    }
+    memset(w->entries, 0, w->capacity * sizeof(*w->entries));
+    w->used = 0;
+    w->records = 0;
+    free(sorted);
+    free(terms);
+    return result;
+}
+
+/** @brief Écrit le dernier bloc et ferme l'index */
+void index_writer_close(struct index_writer *w) {
+    if (!w->file) {
+        return;
+    }
+    index_writer_flush(w);
+    fclose(w->file);
+    free(w->entries);
+    w->file = NULL;
+    w->entries = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Lecture                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief Projette un fichier d'index en mémoire
+ * @return 0 en cas de succès, -1 sinon
+ */
+int index_reader_open(struct index_reader *r, const char *path) {
+    r->data = NULL;
+    r->size = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        r->data = data;
+        r->size = st.st_size;
+    }
+    close(fd);
+    return 0;
+}
+
+void index_reader_close(struct index_reader *r) {
+    if (r->data) {
+        munmap((void *)r->data, r->size);
+    }
+    r->data = NULL;
+    r->size = 0;
+}
+
+/** @brief Liste de positions en construction */
+struct offset_list {
+    uint64_t *items;
+    size_t count;
+    size_t capacity;
+};
+
+/** @brief Décode une liste de positions et l'ajoute à list */
+static void decode_postings(const unsigned char *p, uint32_t length, struct offset_list *list) {
+    const unsigned char *end = p + length;
+    uint64_t offset = 0;
+    int first = 1;
+    while (p < end) {
+        uint64_t delta = 0;
+        int shift = 0;
+        while (p < end) {
+            delta |= (uint64_t)(*p & 0x7F) << shift;
+            shift += 7;
+            if (!(*p++ & 0x80)) {
+                break;
+            }
+        }
+        offset = first ? delta : offset + delta;
+        first = 0;
+        if (list->count == list->capacity) {
+            size_t capacity = list->capacity ? list->capacity * 2 : 64;
+            uint64_t *items = realloc(list->items, capacity * sizeof(*items));
+            if (!items) {
+                return;
+            }
+            list->items = items;
+            list->capacity = capacity;
+        }
+        list->items[list->count++] = offset;
+    }
+}
+
+/** @brief Compare un terme du bloc à la clé (sur len octets si prefix) */
+static int compare_term(const char *strings, const struct index_term *t, const char *key,
+                        size_t length, int prefix) {
+    size_t n = t->length < length ? t->length : length;
+    int c = memcmp(strings + t->string, key, n);
+    if (c != 0) {
+        return c;
+    }
+    if (prefix && t->length >= length) {
+        return 0;
+    }
+    return (int)t->length - (int)length;
+}
+
+/**
+ * @brief Lit le terme i d'un bloc
+ *
+ * Les blocs se suivent sans remplissage : leur table des termes n'est pas
+ * alignée, elle est lue par memcpy comme l'en-tête.
+ */
+static struct index_term term_at(const unsigned char *terms, uint32_t i) {
+    struct index_term t;
+    memcpy(&t, terms + (size_t)i * sizeof(t), sizeof(t));
+    return t;
+}
+
+static int compare_offsets(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief Positions des messages contenant un terme
+ * @param term Terme (normalisé comme par index_next_term())
+ * @param prefix Accepte aussi les termes commençant par term
+ * @param offsets Tableau alloué des positions, croissantes et sans doublon
+ * @return Nombre de positions
+ *
+ * Un bloc tronqué (serveur arrêté pendant son écriture) termine la lecture.
+ */
+size_t index_lookup(const struct index_reader *r, const char *term, int prefix, uint64_t **offsets) {
+    struct offset_list list = {NULL, 0, 0};
+    size_t length = strlen(term);
+    size_t pos = 0;
+    int merged = 0;  // Plusieurs termes par bloc : tri nécessaire
+
+    while (pos + sizeof(struct index_block_header) <= r->size) {
+        struct index_block_header header;
+        memcpy(&header, r->data + pos, sizeof(header));
+        size_t terms_size = (size_t)header.term_count * sizeof(struct index_term);
+        size_t block_size = sizeof(header) + terms_size + header.strings_bytes + header.postings_bytes;
+        if (memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+            block_size > r->size - pos) {
+            break;
+        }
+        const unsigned char *terms = r->data + pos + sizeof(header);
+        const char *strings = (const char *)terms + terms_size;
+        const unsigned char *postings = (const unsigned char *)strings + header.strings_bytes;
+
+        // Premier terme >= clé
+        uint32_t low = 0, high = header.term_count;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            struct index_term t = term_at(terms, mid);
+            if (compare_term(strings, &t, term, length, 0) < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        for (uint32_t i = low; i < header.term_count; i++) {
+            struct index_term t = term_at(terms, i);
+            if (compare_term(strings, &t, term, length, prefix) != 0) {
+                break;
+            }
+            decode_postings(postings + t.postings, t.postings_length, &list);
+            merged |= i > low;
+        }
+        pos += block_size;
+    }
+
+    if (merged && list.count > 1) {
+        qsort(list.items, list.count, sizeof(*list.items), compare_offsets);
+        size_t unique = 1;
+        for (size_t i = 1; i < list.count; i++) {
+            if (list.items[i] != list.items[unique - 1]) {
+                list.items[unique++] = list.items[i];
+            }
+        }
+        list.count = unique;
+    }
+    *offsets = list.items;
+    return list.count;
+}
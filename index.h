@@ -0,0 +1,91 @@
+/**
+ * @file index.h
+ * @brief Index plein texte des messages du log
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * L'index associe chaque terme à la liste des positions (décalage en
+ * octets dans le log) des messages qui le contiennent. Il est construit
+ * par blocs : le serveur accumule les termes en mémoire et ajoute un bloc
+ * trié au fichier d'index tous les INDEX_FLUSH_RECORDS messages (ou après
+ * une seconde sans message). Un bloc n'est jamais réécrit.
+ *
+ * Format d'un bloc : struct index_block_header, puis term_count
+ * struct index_term triés par terme, la zone des chaînes et la zone des
+ * listes de positions. Une liste est une suite de varints (LEB128) : la
+ * première position, puis l'écart avec la précédente.
+ */
+
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define INDEX_MAGIC "MTINDEX1"
+/** @brief Longueur minimale d'un terme indexé */
+#define INDEX_TERM_MIN 2
+/** @brief Longueur maximale d'un terme indexé (au-delà, il est coupé) */
+#define INDEX_TERM_MAX 32
+/** @brief Nombre de messages accumulés avant l'écriture d'un bloc */
+#define INDEX_FLUSH_RECORDS 65536
+
+/** @brief En-tête d'un bloc */
+struct index_block_header {
+    char magic[8];              /**< "MTINDEX1" */
+    uint32_t term_count;        /**< Nombre de termes du bloc */
+    uint32_t strings_bytes;     /**< Taille de la zone des chaînes */
+    uint64_t postings_bytes;    /**< Taille de la zone des positions */
+    uint64_t records;           /**< Nombre de messages indexés dans le bloc */
+};
+
+/** @brief Terme d'un bloc */
+struct index_term {
+    uint32_t string;            /**< Position du terme dans la zone des chaînes */
+    uint16_t length;            /**< Longueur du terme */
+    uint16_t reserved;
+    uint32_t count;             /**< Nombre de messages contenant le terme */
+    uint32_t postings_length;   /**< Taille de sa liste de positions */
+    uint64_t postings;          /**< Position de la liste dans la zone des positions */
+};
+
+/** @brief Terme en cours d'accumulation */
+struct index_entry {
+    char term[INDEX_TERM_MAX];
+    uint8_t length;             /**< 0 si la case est libre */
+    uint32_t count;
+    uint64_t last;              /**< Dernière position ajoutée */
+    unsigned char *postings;
+    uint32_t used;
+    uint32_t capacity;
+};
+
+/** @brief Construction de l'index (un seul thread) */
+struct index_writer {
+    FILE *file;
+    struct index_entry *entries;    /**< Table de hachage à adressage ouvert */
+    uint32_t capacity;              /**< Taille de la table (puissance de 2) */
+    uint32_t used;
+    uint64_t records;               /**< Messages accumulés depuis le dernier bloc */
+};
+
+/** @brief Index chargé en lecture (projeté en mémoire) */
+struct index_reader {
+    const unsigned char *data;
+    size_t size;
+};
+
+void index_path_for(const char *log_path, char *path, size_t size);
+size_t index_next_term(const char *text, size_t length, size_t *pos, char *term);
+
+int index_writer_open(struct index_writer *w, const char *path);
+void index_writer_add(struct index_writer *w, uint64_t offset, const char *text, size_t length);
+int index_writer_flush(struct index_writer *w);
+void index_writer_close(struct index_writer *w);
+
+int index_reader_open(struct index_reader *r, const char *path);
+size_t index_lookup(const struct index_reader *r, const char *term, int prefix, uint64_t **offsets);
+void index_reader_close(struct index_reader *r);
+
+#endif
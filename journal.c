@@ -0,0 +1,79 @@
+/**
+ * @file journal.c
+ * @brief Journal des sessions en cours de réception, projeté en mémoire
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un fichier dont l'en-tête ne correspond pas (autre version, autre
+ * nombre de sessions) est remis à zéro : les sessions qu'il contenait
+ * sont perdues, comme sans journal.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+
+static void *mapping = NULL;
+static size_t mapping_size = 0;
+
+/**
+ * @brief Ouvre (ou crée) le journal et le projette en mémoire
+ * @param entries Nombre d'entrées
+ * @return Les entrées, ou NULL en cas d'erreur (errno)
+ */
+struct journal_entry *journal_open(const char *path, uint32_t entries) {
+    size_t size = sizeof(struct journal_header) + (size_t)entries * sizeof(struct journal_entry);
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct journal_header header;
+    ssize_t n = pread(fd, &header, sizeof(header), 0);
+    struct stat st;
+    int valid = n == (ssize_t)sizeof(header) && memcmp(header.magic, JOURNAL_MAGIC, 8) == 0 &&
+                header.entries == entries && header.entry_size == sizeof(struct journal_entry) &&
+                fstat(fd, &st) == 0 && (size_t)st.st_size == size;
+    if (!valid && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int saved_errno = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+        errno = saved_errno;
+        return NULL;
+    }
+    if (!valid) {
+        struct journal_header *h = p;
+        memcpy(h->magic, JOURNAL_MAGIC, 8);
+        h->entries = entries;
+        h->entry_size = sizeof(struct journal_entry);
+    }
+    mapping = p;
+    mapping_size = size;
+    return (struct journal_entry *)((char *)p + sizeof(struct journal_header));
+}
+
+/**
+ * @brief Écrit le journal sur le disque
+ * @return 0 en cas de succès (ou sans journal), -1 sinon
+ */
+int journal_sync(void) {
+    return mapping ? msync(mapping, mapping_size, MS_SYNC) : 0;
+}
+
+/** @brief Écrit puis ferme le journal */
+void journal_close(void) {
+    if (mapping) {
+        journal_sync();
+        munmap(mapping, mapping_size);
+        mapping = NULL;
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file journal.h
+ * @brief Journal des sessions en cours de réception, projeté en mémoire
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Le journal est un fichier projeté par mmap(MAP_SHARED) : une entrée par
+ * case de la table des sessions (session.h), tenue à jour à chaque bit
+ * reçu, avant son ACK. Les écritures vont directement dans le cache de
+ * pages du noyau : elles survivent à l'arrêt brutal du processus (kill -9,
+ * plantage) sans appel système. journal_sync() les force sur le disque,
+ * à l'arrêt propre du serveur.
+ *
+ * Un serveur relancé avec le même journal y retrouve les sessions
+ * interrompues, et les clients peuvent reprendre leur envoi au dernier bit
+ * acquitté (PROTO_FLAG_RESUME, voir protocole.h).
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "msgbuf.h"
+
+/** @brief Fichier du journal par défaut (suffixé par ".N" pour un worker) */
+#define JOURNAL_FILE "server_sessions.bin"
+/** @brief Signature du fichier */
+#define JOURNAL_MAGIC "MTJRNL01"
+
+/** @brief En-tête du fichier */
+struct journal_header {
+    char magic[8];
+    uint32_t entries;       /**< Nombre d'entrées (SESSIONS_MAX) */
+    uint32_t entry_size;    /**< sizeof(struct journal_entry) */
+};
+
+/**
+ * @brief Session journalisée
+ *
+ * received est écrit en dernier : une entrée est toujours cohérente avec
+ * lui, même si le processus meurt au milieu d'une mise à jour. L'octet en
+ * cours de réception est rangé, bits de poids fort d'abord, à sa place
+ * dans data.
+ */
+struct journal_entry {
+    _Atomic int32_t pid;            /**< PID du client, 0 si l'entrée est libre */
+    _Atomic uint32_t received;      /**< Bits reçus et acquittés */
+    int32_t lane;                   /**< Classe de priorité (enum msgbuf_lane) */
+    uint32_t reserved;
+    char data[MESSAGE_MAX];         /**< Octets reçus */
+};
+
+struct journal_entry *journal_open(const char *path, uint32_t entries);
+int journal_sync(void);
+void journal_close(void);
+
+#endif
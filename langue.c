@@ -0,0 +1,621 @@
+/**
+ * @file langue.c
+ * @brief Détection de la langue d'un message
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Ce module détermine la langue probable d'un message en combinant
+ * la fréquence des lettres et la présence de mots caractéristiques.
+ *
+ * La détection ne fait aucune allocation ni copie : le message est
+ * découpé en mots sur place (voir token.h) et chaque mot est cherché en une
+ * seule lecture dans la table des mots caractéristiques.
+ *
+ * Les tables peuvent être remplacées pendant que d'autres threads
+ * détectent, à la manière de RCU : le nouveau profil est publié par un
+ * échange de pointeur, et l'ancien n'est libéré qu'une fois terminées les
+ * détections qui l'utilisaient. La détection n'attend jamais ; seul le
+ * chargement attend la fin des détections en cours.
+ *
+ * Les messages courts (moins de LANGUE_SHORT_MAX octets) passent d'abord
+ * par le lexique intégré, qui ne dépend pas du profil chargé.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "langue.h"
+#include "token.h"
+
+/** @brief Tableau des langues supportées */
+char *languages[] = {"Français", "Anglais", "Allemand", "Espagnol"};
+
+/** @brief Codes courts des langues, dans le même ordre */
+const char *language_codes[] = {"fr", "en", "de", "es"};
+
+/**
+ * @brief Tableau des fréquences d'apparition des lettres pour chaque langue
+ * Source : https://fr.wikipedia.org/wiki/Fr%C3%A9quence_d%27apparition_des_lettres
+ */
+static const double default_probabilities[4][26] = {
+    // Français
+    {7.64, 0.90, 3.26, 3.67, 14.72, 1.06, 0.87, 0.74, 7.53, 0.61, 0.05, 5.45, 2.96, 7.09, 5.28, 3.02, 1.29, 6.69, 7.95, 7.24, 6.31, 1.83, 0.04, 0.42, 0.19, 0.21},
+    // Anglais
+    {8.17, 1.49, 2.78, 4.25, 12.70, 2.23, 2.02, 6.09, 6.97, 0.15, 0.77, 4.03, 2.41, 6.75, 7.51, 1.93, 0.10, 5.99, 6.33, 9.06, 2.76, 0.98, 2.36, 0.15, 1.97, 0.07},
+    // Allemand
+    {6.51, 1.89, 2.73, 5.08, 16.40, 1.66, 3.01, 4.57, 7.55, 0.27, 1.42, 3.44, 2.53, 9.78, 2.51, 0.79, 0.02, 7.00, 7.27, 6.15, 4.35, 0.67, 1.89, 0.03, 0.04, 1.13},
+    // Espagnol
+    {12.53, 1.42, 4.68, 5.86, 13.68, 0.69, 1.01, 0.70, 6.25, 0.44, 0.01, 4.97, 3.15, 6.71, 8.68, 2.51, 0.88, 6.87, 7.98, 4.63, 3.93, 0.90, 0.01, 0.22, 0.90, 0.52}
+};
+
+/**
+ * @brief Structure pour stocker les mots caractéristiques de chaque langue
+ */
+struct LanguageKeywords {
+    const char* lang;
+    const char* keywords[LANGUE_KEYWORDS];
+};
+
+/**
+ * @brief Mots caractéristiques pour chaque langue (en minuscules)
+ */
+static const struct LanguageKeywords default_keywords[] = {
+    {"Français", {"le", "la", "les", "un", "une", "des", "est", "et", "en", "dans"}},
+    {"Anglais", {"the", "is", "are", "and", "to", "of", "in", "for", "with", "on"}},
+    {"Allemand", {"der", "die", "das", "und", "ist", "in", "den", "von", "zu", "für"}},
+    {"Espagnol", {"el", "la", "los", "las", "un", "una", "es", "en", "de", "por"}}
+};
+
+/**
+ * @brief Mot du lexique des messages courts
+ *
+ * weights donne le poids du mot pour chaque langue, en
+ * LANGUE_LEXIQUE_UNIT par nat ; une case libre a une clé nulle.
+ */
+struct lexique_slot {
+    uint64_t key;
+    int8_t weights[LANGUE_COUNT];
+};
+
+#include "langue_lexique.h"
+
+/** @brief Taille de la table des mots caractéristiques (puissance de 2) */
+#define KEYWORD_TABLE_SIZE 128
+/** @brief Mots découpés par lot pendant la recherche des mots caractéristiques */
+#define KEYWORD_SPANS 64
+
+/**
+ * @brief Mot caractéristique, rangé par sa clé
+ *
+ * La clé est le mot en minuscules tassé dans un entier (un octet par
+ * caractère, jamais nul) ; bits a le bit langue * LANGUE_KEYWORDS + j pour
+ * chaque langue dont il est le j-ième mot caractéristique.
+ */
+struct keyword_slot {
+    uint64_t key;
+    uint64_t bits;
+};
+
+_Static_assert(LANGUE_COUNT * LANGUE_KEYWORDS <= 64, "un bit par mot caractéristique");
+_Static_assert(LANGUE_KEYWORD_MAX <= 8, "clé d'un mot sur 64 bits");
+
+/** @brief Tables utilisées par la détection */
+struct langue_profile {
+    double probabilities[LANGUE_COUNT][26];         /**< Fréquence des lettres (%) */
+    char keywords[LANGUE_COUNT][LANGUE_KEYWORDS][LANGUE_KEYWORD_MAX + 1];
+    struct keyword_slot table[KEYWORD_TABLE_SIZE];  /**< Mots caractéristiques par clé */
+};
+
+/** @brief Tables intégrées, utilisées tant qu'aucun profil n'est chargé */
+static struct langue_profile builtin_profile;
+static pthread_once_t builtin_once = PTHREAD_ONCE_INIT;
+/** @brief Tables courantes */
+static _Atomic(const struct langue_profile *) profile = &builtin_profile;
+/** @brief Nombre de profils publiés (voir langue_profile_generation()) */
+static _Atomic uint64_t profile_generation = 0;
+/** @brief Sérialise les chargements de profil */
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * @brief Détections en cours, par phase
+ *
+ * Une détection compte dans la phase courante à son début. Pour savoir
+ * qu'aucune détection ne lit plus l'ancien profil, le chargement change
+ * deux fois de phase en attendant chaque fois que l'ancienne soit vide.
+ */
+static _Atomic unsigned readers[2];
+static _Atomic unsigned reader_phase = 0;
+
+/** @brief Clé d'un mot : ses octets en minuscules, 0 s'il est trop long */
+static inline uint64_t keyword_key(const unsigned char *s, size_t length) {
+    if (length > LANGUE_KEYWORD_MAX) {
+        return 0;
+    }
+    uint64_t key = 0;
+    for (size_t i = 0; i < length; i++) {
+        key = key << 8 | token_fold(s, i);
+    }
+    return key;
+}
+
+static inline uint32_t keyword_slot_of(uint64_t key) {
+    return (key * 0x9E3779B97F4A7C15ull) >> 57;  // 7 bits : KEYWORD_TABLE_SIZE
+}
+
+/** @brief Range les mots caractéristiques d'un profil dans sa table */
+static void keyword_table_build(struct langue_profile *p) {
+    memset(p->table, 0, sizeof(p->table));
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        for (int j = 0; j < LANGUE_KEYWORDS; j++) {
+            const char *word = p->keywords[i][j];
+            uint64_t key = keyword_key((const unsigned char *)word, strlen(word));
+            if (key == 0) {
+                continue;
+            }
+            uint32_t slot = keyword_slot_of(key);
+            while (p->table[slot].key && p->table[slot].key != key) {
+                slot = (slot + 1) & (KEYWORD_TABLE_SIZE - 1);
+            }
+            p->table[slot].key = key;
+            p->table[slot].bits |= 1ull << (i * LANGUE_KEYWORDS + j);
+        }
+    }
+}
+
+/** @brief Remplit les tables intégrées (une fois) */
+static void builtin_profile_init(void) {
+    memcpy(builtin_profile.probabilities, default_probabilities, sizeof(default_probabilities));
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        for (int j = 0; j < LANGUE_KEYWORDS; j++) {
+            snprintf(builtin_profile.keywords[i][j], LANGUE_KEYWORD_MAX + 1, "%s",
+                     default_keywords[i].keywords[j]);
+        }
+    }
+    keyword_table_build(&builtin_profile);
+}
+
+/** @brief Bits des mots caractéristiques égaux au mot donné, 0 sinon */
+static inline uint64_t keyword_lookup(const struct langue_profile *p, const char *text,
+                                      const struct token_span *span) {
+    uint64_t key = keyword_key((const unsigned char *)text + span->start, span->length);
+    if (key == 0) {
+        return 0;
+    }
+    uint32_t slot = keyword_slot_of(key);
+    while (p->table[slot].key) {
+        if (p->table[slot].key == key) {
+            return p->table[slot].bits;
+        }
+        slot = (slot + 1) & (KEYWORD_TABLE_SIZE - 1);
+    }
+    return 0;
+}
+
+/** @brief Indice d'un code de langue dans language_codes[], -1 si inconnu */
+static int language_code_index(const char *code) {
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        if (strcmp(code, language_codes[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Attend la fin des détections commencées avant l'appel
+ */
+static void wait_readers(void) {
+    for (int i = 0; i < 2; i++) {
+        unsigned phase = atomic_fetch_add(&reader_phase, 1) & 1;
+        while (atomic_load(&readers[phase]) != 0) {
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @brief Remplace les tables courantes (profile_lock tenu)
+ *
+ * Les anciennes tables sont libérées après la fin des détections qui ont
+ * pu les prendre.
+ */
+static void publish(struct langue_profile *p) {
+    const struct langue_profile *old = atomic_exchange(&profile, p);
+    atomic_fetch_add(&profile_generation, 1);
+    if (old != &builtin_profile) {
+        wait_readers();
+        free((void *)old);
+    }
+}
+
+/**
+ * @brief Lit un profil de langues (écrit par l'outil train) sans l'utiliser
+ * @param path Fichier de profil
+ * @return Les tables lues, à passer à langue_profile_publish() ou
+ * langue_profile_discard() ; NULL en cas d'erreur (erreur affichée)
+ *
+ * Chaque ligne donne une table d'une langue :
+ *   CODE lettres F_a F_b ... F_z   (26 fréquences en %)
+ *   CODE mots MOT1 MOT2 ...        (au plus LANGUE_KEYWORDS mots)
+ * Les lignes vides et commençant par '#' sont ignorées ; une table absente
+ * du fichier garde sa valeur courante.
+ */
+struct langue_profile *langue_profile_read(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        return NULL;
+    }
+    pthread_once(&builtin_once, builtin_profile_init);
+    struct langue_profile *p = malloc(sizeof(*p));
+    if (!p) {
+        fclose(in);
+        return NULL;
+    }
+    pthread_mutex_lock(&profile_lock);
+    *p = *atomic_load(&profile);
+    pthread_mutex_unlock(&profile_lock);
+
+    char line[1024];
+    int number = 0, error = 0;
+    while (!error && fgets(line, sizeof(line), in)) {
+        number++;
+        char *save;
+        char *code = strtok_r(line, " \t\r\n", &save);
+        if (!code || code[0] == '#') {
+            continue;
+        }
+        char *kind = strtok_r(NULL, " \t\r\n", &save);
+        int lang = language_code_index(code);
+        if (lang < 0 || !kind) {
+            error = 1;
+        } else if (strcmp(kind, "lettres") == 0) {
+            int n = 0;
+            char *value;
+            while (n < 26 && (value = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+                p->probabilities[lang][n++] = atof(value);
+            }
+            error = n != 26;
+        } else if (strcmp(kind, "mots") == 0) {
+            int n = 0;
+            char *word;
+            memset(p->keywords[lang], 0, sizeof(p->keywords[lang]));
+            while (n < LANGUE_KEYWORDS && (word = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+                if (strlen(word) > LANGUE_KEYWORD_MAX) {
+                    error = 1;
+                    break;
+                }
+                strcpy(p->keywords[lang][n++], word);
+            }
+        } else {
+            error = 1;
+        }
+    }
+    fclose(in);
+    if (error) {
+        fprintf(stderr, "%s:%d : ligne de profil invalide\n", path, number);
+        free(p);
+        return NULL;
+    }
+    keyword_table_build(p);
+    return p;
+}
+
+/**
+ * @brief Utilise les tables lues par langue_profile_read()
+ *
+ * Peut être appelée pendant que d'autres threads détectent : les
+ * détections en cours finissent avec les anciennes tables, les suivantes
+ * utilisent les nouvelles.
+ */
+void langue_profile_publish(struct langue_profile *p) {
+    pthread_mutex_lock(&profile_lock);
+    publish(p);
+    pthread_mutex_unlock(&profile_lock);
+}
+
+/** @brief Abandonne des tables lues par langue_profile_read() */
+void langue_profile_discard(struct langue_profile *p) {
+    free(p);
+}
+
+/**
+ * @brief Charge un profil de langues et l'utilise aussitôt
+ * @return 0 en cas de succès, -1 sinon (erreur affichée, tables inchangées)
+ */
+int langue_load_profile(const char *path) {
+    struct langue_profile *p = langue_profile_read(path);
+    if (!p) {
+        return -1;
+    }
+    langue_profile_publish(p);
+    return 0;
+}
+
+/**
+ * @brief Recopie les tables courantes dans la mémoire du thread appelant
+ * @return 0 en cas de succès, -1 sinon (tables inchangées)
+ *
+ * Avec la politique du premier accès, la copie est sur le nœud NUMA où
+ * tourne l'appelant : à appeler par le thread de détection une fois fixé
+ * sur ses CPU. La copie est publiée comme un nouveau profil.
+ */
+int langue_profile_localize(void) {
+    pthread_once(&builtin_once, builtin_profile_init);
+    struct langue_profile *p = malloc(sizeof(*p));
+    if (!p) {
+        return -1;
+    }
+    pthread_mutex_lock(&profile_lock);
+    memcpy(p, atomic_load(&profile), sizeof(*p));
+    publish(p);
+    pthread_mutex_unlock(&profile_lock);
+    return 0;
+}
+
+/**
+ * @brief Numéro du profil courant
+ *
+ * Change à chaque chargement : un cache de résultats doit être vidé quand
+ * il change.
+ */
+uint64_t langue_profile_generation(void) {
+    return atomic_load_explicit(&profile_generation, memory_order_acquire);
+}
+
+/**
+ * @brief Vérifie si un mot est présent dans le message
+ * @param word Mot cherché, en minuscules
+ *
+ * Seuls les mots entiers comptent ("la" n'est pas trouvé dans "plage").
+ * Comparaison insensible à la casse faite sur place, sans copie.
+ */
+int contains_word(const char* message, const char* word) {
+    size_t n = strlen(word);
+    if (n == 0) {
+        return 1;
+    }
+    struct token_span span;
+    size_t length = strlen(message), pos = 0;
+    while (token_next(message, length, &pos, &span)) {
+        if (token_equal(message, &span, word, n)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Confiance dans la langue retenue, à partir des scores
+ * @param result Résultat dont scores[] et best sont remplis
+ * @return Probabilité de la langue retenue, entre 1/LANGUE_COUNT et 1
+ *
+ * Les scores sont passés dans un softmax dont la température vaut le
+ * bonus d'un mot caractéristique : un écart d'un mot entre les deux
+ * premières langues donne environ 0.73 sur deux langues, un écart nul
+ * donne une confiance de 1/LANGUE_COUNT.
+ */
+double langue_confidence(const struct langue_result *result) {
+    double sum = 0;
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        sum += exp((result->scores[i] - result->scores[result->best]) / LANGUE_KEYWORD_BONUS);
+    }
+    return 1.0 / sum;
+}
+
+/** @brief Détection avec les tables données */
+static int classify(const struct langue_profile *p, const char *message, size_t length,
+                    struct langue_result *result) {
+    int len = 0;
+    int letter_count[26] = {0};
+    double *scores = result->scores; // Scores pour chaque langue
+
+    memset(result, 0, sizeof(*result));
+
+    // Compter les lettres
+    for(size_t i = 0; i < length; i++) {
+        char c = message[i];
+        if(c >= 'a' && c <= 'z') {
+            letter_count[c - 'a']++;
+            len++;
+        } else if(c >= 'A' && c <= 'Z') {
+            letter_count[c - 'A']++;
+            len++;
+        }
+    }
+
+    if(len == 0) {
+        result->confidence = langue_confidence(result);
+        return 0;
+    }
+
+    // 1. Calcul basé sur la fréquence des lettres (50% du score final)
+    double observed_freq[26];
+    for(int i = 0; i < 26; i++) {
+        observed_freq[i] = (double)letter_count[i] / len * 100.0;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        double diff_sum = 0;
+        for (int j = 0; j < 26; j++) {
+            double diff = observed_freq[j] - p->probabilities[i][j];
+            diff_sum += diff * diff;
+        }
+        scores[i] = -diff_sum; // Score négatif car plus la différence est petite, meilleur est le score
+    }
+
+    // 2. Recherche de mots caractéristiques (50% du score final)
+    uint64_t found = 0;
+    struct token_span spans[KEYWORD_SPANS];
+    size_t pos = 0, count;
+    do {
+        count = token_split(message, length, &pos, spans, KEYWORD_SPANS);
+        for (size_t k = 0; k < count; k++) {
+            found |= keyword_lookup(p, message, &spans[k]);
+        }
+    } while (count == KEYWORD_SPANS);
+    for(int i = 0; i < 4; i++) {
+        int word_matches = __builtin_popcountll((found >> (i * LANGUE_KEYWORDS)) &
+                                                ((1ull << LANGUE_KEYWORDS) - 1));
+        result->matches[i] = word_matches;
+        scores[i] += word_matches * LANGUE_KEYWORD_BONUS; // Bonus pour chaque mot trouvé
+    }
+
+    // Trouver la langue avec le meilleur score
+    double max_score = scores[0];
+    int best_index = 0;
+    //printf("\nScores par langue:\n");
+    for(int i = 0; i < 4; i++) {
+        //printf("%s: %.2f\n", languages[i], scores[i]);
+        if(scores[i] > max_score) {
+            max_score = scores[i];
+            best_index = i;
+        }
+    }
+
+    result->best = best_index;
+    result->confidence = langue_confidence(result);
+    return best_index;
+}
+
+/** @brief Case du lexique du mot donné, NULL s'il n'y est pas */
+static inline const struct lexique_slot *lexique_lookup(const char *text,
+                                                        const struct token_span *span) {
+    uint64_t key = keyword_key((const unsigned char *)text + span->start, span->length);
+    if (key == 0) {
+        return NULL;
+    }
+    uint8_t seed = lexique_seeds[langue_lexique_bucket(key, LEXIQUE_BUCKET_BITS)];
+    const struct lexique_slot *slot = &lexique_table[langue_lexique_slot(key, seed, LEXIQUE_SLOT_BITS)];
+    return slot->key == key ? slot : NULL;
+}
+
+/**
+ * @brief Détection d'un message court par le lexique seul
+ * @param message Le message à analyser
+ * @param length Longueur du message (moins de LANGUE_SHORT_MAX octets)
+ * @param result Résultat rempli par la fonction (fourni par l'appelant)
+ * @return L'indice de la langue retenue, ou -1 si le lexique ne conclut
+ * pas (message trop long, aucun mot connu ou confiance sous
+ * LANGUE_SHORT_CONFIDENCE) : result est alors à ignorer
+ *
+ * Seuls les LANGUE_SHORT_WORDS premiers mots sont cherchés, chacun en une
+ * lecture de la table à hachage parfait. Les scores sont les sommes des
+ * poids des mots trouvés, ramenées à l'échelle de LANGUE_KEYWORD_BONUS :
+ * la confiance est alors la probabilité de la langue selon le lexique.
+ * matches[] compte les mots trouvés de poids positif pour chaque langue.
+ */
+int langue_classify_short(const char *message, size_t length, struct langue_result *result) {
+    if (length >= LANGUE_SHORT_MAX) {
+        return -1;
+    }
+    struct token_span spans[LANGUE_SHORT_WORDS];
+    size_t pos = 0;
+    size_t count = token_split(message, length, &pos, spans, LANGUE_SHORT_WORDS);
+    int sums[LANGUE_COUNT] = {0};
+    int found = 0;
+
+    memset(result, 0, sizeof(*result));
+    for (size_t k = 0; k < count; k++) {
+        const struct lexique_slot *w = lexique_lookup(message, &spans[k]);
+        if (!w) {
+            continue;
+        }
+        found++;
+        for (int i = 0; i < LANGUE_COUNT; i++) {
+            sums[i] += w->weights[i];
+            result->matches[i] += w->weights[i] > 0;
+        }
+    }
+    if (found == 0) {
+        return -1;
+    }
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        result->scores[i] = sums[i] * LANGUE_KEYWORD_BONUS / LANGUE_LEXIQUE_UNIT;
+        if (sums[i] > sums[result->best]) {
+            result->best = i;
+        }
+    }
+    result->confidence = langue_confidence(result);
+    return result->confidence >= LANGUE_SHORT_CONFIDENCE ? result->best : -1;
+}
+
+/**
+ * @brief Détection par le modèle de fréquences seul, sans le lexique
+ *
+ * Mêmes paramètres et résultat que langue_classify_buf().
+ */
+int langue_classify_model(const char *message, size_t length, struct langue_result *result) {
+    pthread_once(&builtin_once, builtin_profile_init);
+    unsigned phase = atomic_load(&reader_phase) & 1;
+    atomic_fetch_add(&readers[phase], 1);
+    int best = classify(atomic_load(&profile), message, length, result);
+    atomic_fetch_sub_explicit(&readers[phase], 1, memory_order_release);
+    return best;
+}
+
+/**
+ * @brief Analyse complète d'un message de longueur connue
+ * @param message Le message à analyser
+ * @param length Longueur du message
+ * @param result Résultat rempli par la fonction (fourni par l'appelant)
+ * @return L'indice de la langue retenue dans languages[]
+ *
+ * Cette fonction analyse la fréquence des lettres dans le message
+ * et la compare aux fréquences connues de différentes langues,
+ * puis ajoute un bonus pour chaque mot caractéristique trouvé comme mot
+ * entier (chaque mot compte une fois, quel que soit son nombre
+ * d'occurrences).
+ * Le résultat contient les scores de chaque langue, le nombre de mots
+ * caractéristiques trouvés et la confiance dans la langue retenue.
+ * Les tables utilisées sont celles du profil courant au début de l'appel.
+ *
+ * Un message de moins de LANGUE_SHORT_MAX octets est d'abord soumis au
+ * lexique (langue_classify_short()) : le modèle de fréquences n'est
+ * calculé que si le lexique ne conclut pas.
+ */
+int langue_classify_buf(const char *message, size_t length, struct langue_result *result) {
+    int best = langue_classify_short(message, length, result);
+    if (best >= 0) {
+        return best;
+    }
+    return langue_classify_model(message, length, result);
+}
+
+/**
+ * @brief Analyse complète d'un message : scores de toutes les langues
+ * @param message Le message à analyser
+ * @param result Résultat rempli par la fonction (fourni par l'appelant)
+ * @return L'indice de la langue retenue dans languages[]
+ */
+int langue_classify(char *message, struct langue_result *result) {
+    return langue_classify_buf(message, strlen(message), result);
+}
+
+/**
+ * @brief Détermine la langue probable d'un message et son score
+ * @param message Le message à analyser
+ * @param score Reçoit le score de la langue retenue (peut être NULL)
+ * @return L'indice de la langue dans languages[]
+ */
+int langue_detect(char *message, double *score) {
+    struct langue_result result;
+    int best = langue_classify(message, &result);
+    if (score) {
+        *score = result.scores[best];
+    }
+    return best;
+}
+
+/**
+ * @brief Détermine la langue probable d'un message
+ * @param message Le message à analyser
+ * @return Un pointeur vers la chaîne contenant le nom de la langue
+ */
+char* getlangue(char *message) {
+    return languages[langue_detect(message, NULL)];
+}
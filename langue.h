@@ -0,0 +1,96 @@
+/**
+ * @file langue.h
+ * @brief Détection de la langue d'un message
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Interface du classifieur utilisé par le serveur et par les outils de mesure.
+ */
+
+#ifndef LANGUE_H
+#define LANGUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Nombre de langues supportées */
+#define LANGUE_COUNT 4
+
+/** @brief Nombre de mots caractéristiques par langue */
+#define LANGUE_KEYWORDS 10
+/** @brief Longueur maximale d'un mot caractéristique (octets) */
+#define LANGUE_KEYWORD_MAX 8
+/** @brief Profil de langues écrit par défaut par l'outil train */
+#define LANGUE_PROFILE_FILE "langue_profile.txt"
+
+/** @brief Bonus de score pour chaque mot caractéristique trouvé */
+#define LANGUE_KEYWORD_BONUS 50.0
+
+/**
+ * @brief Messages plus courts (octets) détectés d'abord par le lexique
+ *
+ * Sous cette longueur, les fréquences de lettres sont trop bruitées : les
+ * mots du message sont cherchés dans un lexique intégré (langue_lexique.h,
+ * généré par ./train -x) et le modèle de fréquences n'est utilisé que si
+ * le lexique ne conclut pas.
+ */
+#define LANGUE_SHORT_MAX 64
+/** @brief Mots au plus cherchés dans le lexique (coût borné) */
+#define LANGUE_SHORT_WORDS 12
+/** @brief Confiance minimale pour que le lexique conclue seul */
+#define LANGUE_SHORT_CONFIDENCE 0.9
+/** @brief Poids du lexique par unité de log-vraisemblance (nat) */
+#define LANGUE_LEXIQUE_UNIT 16
+/** @brief Nombre maximal de mots du lexique */
+#define LANGUE_LEXIQUE_MAX 512
+/** @brief Fichier du lexique intégré, écrit par ./train -x */
+#define LANGUE_LEXIQUE_FILE "langue_lexique.h"
+
+/**
+ * @brief Résultat complet d'une détection, rempli sans allocation
+ */
+struct langue_result {
+    double scores[LANGUE_COUNT];    /**< Score de chaque langue (plus haut = meilleur) */
+    int matches[LANGUE_COUNT];      /**< Mots caractéristiques trouvés par langue */
+    int best;                       /**< Indice de la langue retenue */
+    double confidence;              /**< Probabilité de la langue retenue (0 à 1) */
+};
+
+/**
+ * @brief Case du lexique (hachage parfait) d'une clé de mot
+ *
+ * Hachage et déplacement : la clé choisit un seau, dont la graine
+ * (trouvée par ./train -x) envoie chaque mot du lexique dans une case
+ * distincte. Deux multiplications et une lecture par mot, sans sondage ;
+ * un mot absent tombe sur une case dont la clé diffère.
+ */
+static inline uint32_t langue_lexique_bucket(uint64_t key, int bits) {
+    return (key * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+}
+
+static inline uint32_t langue_lexique_slot(uint64_t key, uint8_t seed, int bits) {
+    return ((key ^ (seed * 0xC2B2AE3D27D4EB4Full)) * 0xFF51AFD7ED558CCDull) >> (64 - bits);
+}
+
+/** @brief Noms des langues supportées (indexés comme les tables de fréquences) */
+extern char *languages[];
+/** @brief Codes courts des langues (noms des dossiers du corpus) */
+extern const char *language_codes[];
+
+int contains_word(const char* message, const char* word);
+int langue_classify_buf(const char *message, size_t length, struct langue_result *result);
+int langue_classify_short(const char *message, size_t length, struct langue_result *result);
+int langue_classify_model(const char *message, size_t length, struct langue_result *result);
+int langue_classify(char *message, struct langue_result *result);
+double langue_confidence(const struct langue_result *result);
+int langue_detect(char *message, double *score);
+char* getlangue(char *message);
+struct langue_profile;
+struct langue_profile *langue_profile_read(const char *path);
+void langue_profile_publish(struct langue_profile *p);
+void langue_profile_discard(struct langue_profile *p);
+int langue_load_profile(const char *path);
+uint64_t langue_profile_generation(void);
+int langue_profile_localize(void);
+
+#endif
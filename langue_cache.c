@@ -0,0 +1,201 @@
+/**
+ * @file langue_cache.c
+ * @brief Cache des résultats de la détection de langue
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Le cache est associatif par ensembles de LANGUE_CACHE_WAYS entrées :
+ * une recherche lit au plus une ligne de cache. Le remplacement dans un
+ * ensemble suit l'algorithme CLOCK (seconde chance) avec une aiguille par
+ * ensemble.
+ *
+ * L'empreinte est un hachage de type wyhash qui traite 8 octets à la fois
+ * et les passe en minuscules au vol (SWAR) : pour un message de 16 octets,
+ * une consultation coûte quelques nanosecondes, contre plusieurs
+ * microsecondes pour la détection complète.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "langue.h"
+#include "langue_cache.h"
+
+_Static_assert(LANGUE_COUNT * 4 <= 16, "matches ne tient plus sur 16 bits");
+_Static_assert(sizeof(struct langue_cache_entry) == 32, "entrée du cache de 32 octets attendue");
+
+static const uint64_t P0 = 0xa0761d6478bd642full;
+static const uint64_t P1 = 0xe7037ed1a0b428dbull;
+static const uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+
+/** @brief Multiplication 64x64 -> 128 bits repliée sur 64 bits */
+static inline uint64_t mum(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+/**
+ * @brief Passe en minuscules les lettres ASCII de 8 octets à la fois
+ *
+ * Pour chaque octet < 0x80, le bit de poids fort de (b + 0x80 - 'A') vaut 1
+ * si b >= 'A', celui de (b + 0x80 - 'Z' - 1) si b > 'Z' : leur ou exclusif
+ * désigne les majuscules, auxquelles on ajoute 0x20. Les octets UTF-8
+ * (>= 0x80) sont laissés tels quels, comme le fait tolower() en locale C.
+ */
+static inline uint64_t lower8(uint64_t x) {
+    const uint64_t ones = 0x0101010101010101ull;
+    uint64_t low7 = x & (0x7F * ones);
+    uint64_t ge_a = low7 + (0x80 - 'A') * ones;
+    uint64_t gt_z = low7 + (0x80 - 'Z' - 1) * ones;
+    uint64_t upper = (ge_a ^ gt_z) & ~x & (0x80 * ones);
+    return x | (upper >> 2);
+}
+
+static inline uint64_t load8(const char *p, size_t n) {
+    uint64_t v = 0;
+    memcpy(&v, p, n);
+    return v;
+}
+
+/**
+ * @brief Empreinte 64 bits d'un message normalisé en minuscules ASCII
+ * @return L'empreinte, jamais 0 (réservé aux entrées vides)
+ */
+uint64_t langue_hash(const char *message, size_t length) {
+    uint64_t h = P0 ^ length;
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        h = mum(lower8(load8(message + i, 8)) ^ P1, lower8(load8(message + i + 8, 8)) ^ h);
+    }
+    size_t rest = length - i;
+    uint64_t a = 0, b = 0;
+    if (rest > 8) {
+        a = lower8(load8(message + i, 8));
+        b = lower8(load8(message + i + 8, rest - 8));
+    } else if (rest > 0) {
+        a = lower8(load8(message + i, rest));
+    }
+    h = mum(a ^ P1, b ^ h);
+    h = mum(h ^ P2, length ^ P0);
+    return h ? h : 1;
+}
+
+/**
+ * @brief Crée un cache occupant au plus bytes octets
+ * @return 0 en cas de succès, -1 sinon
+ */
+int langue_cache_init(struct langue_cache *cache, size_t bytes) {
+    size_t sets = 1;
+    while (sets * 2 * (LANGUE_CACHE_WAYS * sizeof(struct langue_cache_entry) + 1) <= bytes) {
+        sets *= 2;
+    }
+    memset(cache, 0, sizeof(*cache));
+    cache->entries = calloc(sets * LANGUE_CACHE_WAYS, sizeof(struct langue_cache_entry));
+    cache->hands = calloc(sets, 1);
+    if (!cache->entries || !cache->hands) {
+        langue_cache_free(cache);
+        return -1;
+    }
+    cache->set_mask = sets - 1;
+    return 0;
+}
+
+void langue_cache_free(struct langue_cache *cache) {
+    free(cache->entries);
+    free(cache->hands);
+    cache->entries = NULL;
+    cache->hands = NULL;
+}
+
+/**
+ * @brief Cherche un message dans le cache
+ * @param result Reçoit le résultat mémorisé en cas de succès
+ * @return L'indice de la langue, -1 en cas d'absence
+ */
+int langue_cache_lookup(struct langue_cache *cache, uint64_t hash, size_t length,
+                        struct langue_result *result) {
+    struct langue_cache_entry *set = &cache->entries[(hash & cache->set_mask) * LANGUE_CACHE_WAYS];
+    for (int w = 0; w < LANGUE_CACHE_WAYS; w++) {
+        if (set[w].hash == hash && set[w].length == (uint16_t)length) {
+            set[w].referenced = 1;
+            cache->hits++;
+            for (int i = 0; i < LANGUE_COUNT; i++) {
+                result->scores[i] = set[w].scores[i];
+                result->matches[i] = (set[w].matches >> (4 * i)) & 0xF;
+            }
+            result->best = set[w].lang;
+            result->confidence = set[w].confidence / 65535.0;
+            return set[w].lang;
+        }
+    }
+    cache->misses++;
+    return -1;
+}
+
+/**
+ * @brief Ajoute un résultat, en évinçant si besoin une entrée de l'ensemble
+ *
+ * Une entrée libre est prise en priorité. Sinon l'aiguille de l'ensemble
+ * avance en retirant leur bit de référence aux entrées utilisées depuis
+ * son dernier passage, et s'arrête sur la première qui ne l'est pas.
+ */
+void langue_cache_insert(struct langue_cache *cache, uint64_t hash, size_t length,
+                         const struct langue_result *result) {
+    size_t index = hash & cache->set_mask;
+    struct langue_cache_entry *set = &cache->entries[index * LANGUE_CACHE_WAYS];
+    int hand = cache->hands[index];
+    int victim = -1;
+
+    for (int w = 0; w < LANGUE_CACHE_WAYS && victim < 0; w++) {
+        if (set[w].hash == 0) {
+            victim = w;
+        }
+    }
+    while (victim < 0) {
+        if (set[hand].referenced) {
+            set[hand].referenced = 0;
+        } else {
+            victim = hand;
+        }
+        hand = (hand + 1) % LANGUE_CACHE_WAYS;
+    }
+
+    set[victim].hash = hash;
+    set[victim].length = (uint16_t)length;
+    set[victim].lang = (uint8_t)result->best;
+    set[victim].matches = 0;
+    for (int i = 0; i < LANGUE_COUNT; i++) {
+        set[victim].scores[i] = (float)result->scores[i];
+        set[victim].matches |= (result->matches[i] > 15 ? 15 : result->matches[i]) << (4 * i);
+    }
+    set[victim].confidence = (uint16_t)(result->confidence * 65535.0 + 0.5);
+    set[victim].referenced = 0;
+    cache->hands[index] = (uint8_t)hand;
+}
+
+/**
+ * @brief Détecte la langue d'un message en passant par le cache
+ * @param cache Cache du thread appelant
+ * @param message Message terminé par '\0'
+ * @param length Longueur du message
+ * @param result Reçoit le résultat complet de la détection
+ * @return L'indice de la langue dans languages[]
+ *
+ * Le cache est vidé quand un nouveau profil de langues a été chargé : ses
+ * résultats ont été calculés avec les anciennes tables.
+ */
+int langue_cache_detect(struct langue_cache *cache, char *message, size_t length,
+                        struct langue_result *result) {
+    uint64_t generation = langue_profile_generation();
+    if (generation != cache->generation) {
+        memset(cache->entries, 0, (cache->set_mask + 1) * LANGUE_CACHE_WAYS * sizeof(struct langue_cache_entry));
+        cache->generation = generation;
+    }
+    uint64_t hash = langue_hash(message, length);
+    int lang = langue_cache_lookup(cache, hash, length, result);
+    if (lang < 0) {
+        lang = langue_classify_buf(message, length, result);
+        langue_cache_insert(cache, hash, length, result);
+    }
+    return lang;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file langue_cache.h
+ * @brief Cache des résultats de la détection de langue
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Une bonne partie du trafic est faite de messages courts répétés
+ * ("ok", "merci", messages d'état...). Le cache associe l'empreinte du
+ * message normalisé (minuscules ASCII, comme la détection elle-même) au
+ * résultat complet de la détection (scores et mots trouvés par langue).
+ *
+ * Le cache n'est pas partagé entre threads : chaque classifieur a le sien.
+ */
+
+#ifndef LANGUE_CACHE_H
+#define LANGUE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "langue.h"
+
+/** @brief Nombre d'entrées par ensemble (associativité) */
+#define LANGUE_CACHE_WAYS 4
+
+/** @brief Entrée du cache (32 octets, deux par ligne de cache) */
+struct langue_cache_entry {
+    uint64_t hash;      /**< Empreinte du message normalisé, 0 = entrée vide */
+    float scores[LANGUE_COUNT]; /**< Score de chaque langue */
+    uint16_t matches;   /**< Mots trouvés par langue, 4 bits par langue (plafonné à 15) */
+    uint16_t confidence; /**< Confiance * 65535 (évite de recalculer le softmax) */
+    uint16_t length;    /**< Longueur du message (modulo 65536), vérifiée en plus */
+    uint8_t lang;       /**< Indice de la langue dans languages[] */
+    uint8_t referenced; /**< Bit de référence de l'algorithme CLOCK */
+};
+
+struct langue_cache {
+    struct langue_cache_entry *entries;
+    uint8_t *hands;     /**< Aiguille CLOCK de chaque ensemble */
+    size_t set_mask;    /**< Nombre d'ensembles - 1 (puissance de 2) */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t generation; /**< Profil de langues des résultats (langue_profile_generation()) */
+};
+
+uint64_t langue_hash(const char *message, size_t length);
+int langue_cache_init(struct langue_cache *cache, size_t bytes);
+void langue_cache_free(struct langue_cache *cache);
+int langue_cache_lookup(struct langue_cache *cache, uint64_t hash, size_t length,
+                        struct langue_result *result);
+void langue_cache_insert(struct langue_cache *cache, uint64_t hash, size_t length,
+                         const struct langue_result *result);
+int langue_cache_detect(struct langue_cache *cache, char *message, size_t length,
+                        struct langue_result *result);
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ * @file langue_lexique.h
+ * @brief Lexique des messages courts, généré par ./train -x (ne pas modifier)
+ *
+ * Corpus : corpus. Poids de chaque mot par langue (fr, en, de, es), en
+ * LANGUE_LEXIQUE_UNIT par nat ; inclus par langue.c seulement.
+ */
+
+#ifndef LANGUE_LEXIQUE_H
+#define LANGUE_LEXIQUE_H
+
+#define LEXIQUE_WORDS 140
+#define LEXIQUE_SLOT_BITS 8
+#define LEXIQUE_BUCKET_BITS 7
+
+static const uint8_t lexique_seeds[1 << LEXIQUE_BUCKET_BITS] = {
+    0, 0, 0, 0, 0, 3, 3, 0, 0, 2, 3, 0, 0, 3, 0, 5,
+    0, 0, 0, 1, 1, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 0,
+    0, 2, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0,
+    0, 0, 0, 1, 0, 2, 0, 0, 0, 1, 0, 1, 1, 1, 0, 1,
+    0, 0, 2, 0, 0, 2, 0, 0, 0, 3, 1, 0, 0, 0, 0, 0,
+    5, 0, 0, 1, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1,
+    0, 0, 1, 1, 2, 0, 5, 1, 0, 1, 0, 0, 0, 0, 1, 0,
+};
+
+static const struct lexique_slot lexique_table[1 << LEXIQUE_SLOT_BITS] = {
+    [0] = {0x6265ull, {-9, 26, -9, -9}},  /* be */
+    [6] = {0x6e6f7576656c6c65ull, {19, -6, -6, -6}},  /* nouvelle */
+    [7] = {0x66696eull, {22, -13, -13, 4}},  /* fin */
+    [8] = {0x736f6e74ull, {19, -6, -6, -6}},  /* sont */
+    [10] = {0x756eull, {21, -17, -17, 14}},  /* un */
+    [11] = {0x63616eull, {-6, 19, -6, -6}},  /* can */
+    [12] = {0x706f72ull, {-9, -9, -9, 26}},  /* por */
+    [13] = {0x72657669736172ull, {-6, -6, -6, 19}},  /* revisar */
+    [14] = {0x73696e6365ull, {-6, 19, -6, -6}},  /* since */
+    [16] = {0x686179ull, {-6, -6, -6, 19}},  /* hay */
+    [17] = {0x64616e73ull, {31, -10, -10, -10}},  /* dans */
+    [18] = {0x706f7576657aull, {19, -6, -6, -6}},  /* pouvez */
+    [20] = {0x6d79ull, {-6, 19, -6, -6}},  /* my */
+    [21] = {0x7665727369c3b36eull, {-6, -6, -6, 19}},  /* versión */
+    [27] = {0x6c6173ull, {-10, -10, -10, 31}},  /* las */
+    [29] = {0x766f73ull, {19, -6, -6, -6}},  /* vos */
+    [30] = {0x6e69636874ull, {-6, -6, 19, -6}},  /* nicht */
+    [31] = {0x6e6f7573ull, {26, -9, -9, -9}},  /* nous */
+    [32] = {0x6f6eull, {-9, 26, -9, -9}},  /* on */
+    [33] = {0x776972ull, {-10, -10, 31, -10}},  /* wir */
+    [34] = {0x7765ull, {-10, 29, -10, -10}},  /* we */
+    [35] = {0x6e657874ull, {-6, 19, -6, -6}},  /* next */
+    [36] = {0x65696e65ull, {-8, -8, 23, -8}},  /* eine */
+    [37] = {0x6f66ull, {-11, 34, -11, -11}},  /* of */
+    [42] = {0x6c6full, {-6, -6, -6, 19}},  /* lo */
+    [43] = {0x766f72ull, {-10, -10, 29, -10}},  /* vor */
+    [44] = {0x66c3bc72ull, {-9, -9, 26, -9}},  /* für */
+    [45] = {0x666f72ull, {-11, 32, -11, -11}},  /* for */
+    [49] = {0x6c6f73ull, {-10, -10, -10, 29}},  /* los */
+    [50] = {0x756e65ull, {26, -9, -9, -9}},  /* une */
+    [53] = {0x656e64ull, {-9, 26, -9, -9}},  /* end */
+    [54] = {0x696eull, {-18, 23, 13, -18}},  /* in */
+    [55] = {0x696cull, {26, -9, -9, -9}},  /* il */
+    [56] = {0x6e657565ull, {-6, -6, 19, -6}},  /* neue */
+    [63] = {0x7265756e69c3b36eull, {-6, -6, -6, 19}},  /* reunión */
+    [65] = {0x66696e616cull, {-8, -8, -8, 23}},  /* final */
+    [68] = {0x617566ull, {-6, -6, 19, -6}},  /* auf */
+    [70] = {0x73ull, {-6, 19, -6, -6}},  /* s */
+    [71] = {0x746f757465ull, {19, -6, -6, -6}},  /* toute */
+    [75] = {0x726576696577ull, {-6, 19, -6, -6}},  /* review */
+    [76] = {0x6d65ull, {7, 15, -11, -11}},  /* me */
+    [79] = {0x6d6f7267656eull, {-6, -6, 19, -6}},  /* morgen */
+    [81] = {0x70727565626173ull, {-6, -6, -6, 19}},  /* pruebas */
+    [84] = {0x61ull, {4, 14, -27, 8}},  /* a */
+    [85] = {0x646173ull, {-10, -10, 31, -10}},  /* das */
+    [87] = {0x79656172ull, {-6, 19, -6, -6}},  /* year */
+    [89] = {0x7175656c7175ull, {19, -6, -6, -6}},  /* quelqu */
+    [90] = {0x69ull, {-9, 26, -9, -9}},  /* i */
+    [91] = {0x70617261ull, {-8, -8, -8, 23}},  /* para */
+    [93] = {0x746f646full, {-6, -6, -6, 19}},  /* todo */
+    [95] = {0x696dull, {-9, -9, 26, -9}},  /* im */
+    [97] = {0x6d6f6973ull, {19, -6, -6, -6}},  /* mois */
+    [98] = {0x6c6573ull, {34, -11, -11, -11}},  /* les */
+    [99] = {0x6d656574696e67ull, {-8, 23, -8, -8}},  /* meeting */
+    [100] = {0x776f636865ull, {-8, -8, 23, -8}},  /* woche */
+    [103] = {0x6a656d616e64ull, {-6, -6, 19, -6}},  /* jemand */
+    [108] = {0x6c61ull, {30, -28, -28, 27}},  /* la */
+    [109] = {0x7365ull, {5, -12, -12, 19}},  /* se */
+    [110] = {0x6c65ull, {40, -13, -13, -13}},  /* le */
+    [111] = {0x6e75657661ull, {-6, -6, -6, 19}},  /* nueva */
+    [112] = {0x6573746172c3a1ull, {-6, -6, -6, 19}},  /* estará */
+    [115] = {0x6d61c3b1616e61ull, {-8, -8, -8, 23}},  /* mañana */
+    [117] = {0x616e746573ull, {-10, -10, -10, 29}},  /* antes */
+    [118] = {0x6d6f726e696e67ull, {-6, 19, -6, -6}},  /* morning */
+    [120] = {0x6e6577ull, {-8, 23, -8, -8}},  /* new */
+    [121] = {0x73656d616e61ull, {-8, -8, -8, 23}},  /* semana */
+    [122] = {0x74686973ull, {-6, 19, -6, -6}},  /* this */
+    [123] = {0x7465616dull, {-11, 15, 7, -11}},  /* team */
+    [126] = {0x73657261ull, {19, -6, -6, -6}},  /* sera */
+    [128] = {0x6d69ull, {-6, -6, -6, 19}},  /* mi */
+    [130] = {0x697374ull, {-10, -10, 29, -10}},  /* ist */
+    [131] = {0x72656d656d626572ull, {-6, 19, -6, -6}},  /* remember */
+    [132] = {0x72c3a9756e696f6eull, {19, -6, -6, -6}},  /* réunion */
+    [135] = {0x726f6f6dull, {-8, 23, -8, -8}},  /* room */
+    [137] = {0x6c65747a74656eull, {-6, -6, 19, -6}},  /* letzten */
+    [141] = {0x64617373ull, {-6, -6, 19, -6}},  /* dass */
+    [142] = {0x6a65ull, {29, -10, -10, -10}},  /* je */
+    [145] = {0x73656974ull, {-6, -6, 19, -6}},  /* seit */
+    [150] = {0x76657273696f6eull, {6, 6, 6, -19}},  /* version */
+    [152] = {0x746865ull, {-16, 48, -16, -16}},  /* the */
+    [153] = {0x6475ull, {30, -16, 2, -16}},  /* du */
+    [156] = {0x646573ull, {11, -15, 20, -15}},  /* des */
+    [158] = {0x7a75ull, {-8, -8, 23, -8}},  /* zu */
+    [159] = {0x6465766f6e73ull, {19, -6, -6, -6}},  /* devons */
+    [160] = {0x64656dull, {-8, -8, 23, -8}},  /* dem */
+    [161] = {0x646570756973ull, {19, -6, -6, -6}},  /* depuis */
+    [163] = {0x6465ull, {29, -29, -29, 29}},  /* de */
+    [164] = {0x796f75ull, {-6, 19, -6, -6}},  /* you */
+    [166] = {0x617072c3a873ull, {19, -6, -6, -6}},  /* après */
+    [169] = {0x616dull, {-9, -9, 26, -9}},  /* am */
+    [171] = {0x77696c6cull, {-11, 32, -11, -11}},  /* will */
+    [173] = {0x616c677569656eull, {-6, -6, -6, 19}},  /* alguien */
+    [174] = {0x717565ull, {19, -20, -20, 21}},  /* que */
+    [175] = {0x756e61ull, {-9, -9, -9, 26}},  /* una */
+    [176] = {0x656eull, {1, -17, -17, 32}},  /* en */
+    [177] = {0x7765656bull, {-8, 23, -8, -8}},  /* week */
+    [179] = {0x73656d61696e65ull, {23, -8, -8, -8}},  /* semaine */
+    [182] = {0x6cull, {23, -8, -8, -8}},  /* l */
+    [184] = {0x746full, {-12, 35, -12, -12}},  /* to */
+    [187] = {0x64ull, {19, -6, -6, -6}},  /* d */
+    [188] = {0x617265ull, {-8, 23, -8, -8}},  /* are */
+    [189] = {0x74656e656d6f73ull, {-6, -6, -6, 19}},  /* tenemos */
+    [190] = {0x706f7572ull, {29, -10, -10, -10}},  /* pour */
+    [192] = {0x6365ull, {19, -6, -6, -6}},  /* ce */
+    [194] = {0x6d6174696eull, {19, -6, -6, -6}},  /* matin */
+    [195] = {0x657374ull, {31, -10, -10, -10}},  /* est */
+    [196] = {0xc3a97175697065ull, {19, -6, -6, -6}},  /* équipe */
+    [197] = {0x6265666f7265ull, {-9, 26, -9, -9}},  /* before */
+    [198] = {0x616e6ec3a965ull, {19, -6, -6, -6}},  /* année */
+    [201] = {0x636c6f736564ull, {-6, 19, -6, -6}},  /* closed */
+    [202] = {0x6973ull, {-10, 31, -10, -10}},  /* is */
+    [203] = {0xc3a0ull, {29, -10, -10, -10}},  /* à */
+    [205] = {0x766f7573ull, {23, -8, -8, -8}},  /* vous */
+    [206] = {0x73616c6c65ull, {23, -8, -8, -8}},  /* salle */
+    [207] = {0x707265766973746full, {-6, -6, -6, 19}},  /* previsto */
+    [210] = {0x64656cull, {-11, -11, -11, 32}},  /* del */
+    [211] = {0x64656eull, {-10, -10, 29, -10}},  /* den */
+    [212] = {0x73616c61ull, {-8, -8, -8, 23}},  /* sala */
+    [214] = {0x796f7572ull, {-8, 23, -8, -8}},  /* your */
+    [216] = {0x6465736465ull, {-6, -6, -6, 19}},  /* desde */
+    [219] = {0x686174ull, {-6, -6, 19, -6}},  /* hat */
+    [221] = {0x657374c3a1ull, {-8, -8, -8, 23}},  /* está */
+    [222] = {0x686173ull, {-6, 19, -6, -6}},  /* has */
+    [224] = {0x6176616e74ull, {26, -9, -9, -9}},  /* avant */
+    [226] = {0x6c617374ull, {-8, 23, -8, -8}},  /* last */
+    [227] = {0x646572ull, {-13, -13, 38, -13}},  /* der */
+    [229] = {0x68617665ull, {-9, 26, -9, -9}},  /* have */
+    [230] = {0x656e6465ull, {-6, -6, 19, -6}},  /* ende */
+    [232] = {0x65717569706full, {-6, -6, -6, 19}},  /* equipo */
+    [235] = {0x706c65617365ull, {-6, 19, -6, -6}},  /* please */
+    [236] = {0x646965ull, {-13, -13, 40, -13}},  /* die */
+    [237] = {0x6861ull, {-8, -8, -8, 23}},  /* ha */
+    [239] = {0x6dc3bc7373656eull, {-6, -6, 19, -6}},  /* müssen */
+    [240] = {0x656cull, {-13, -13, -13, 40}},  /* el */
+    [241] = {0x61c3b16full, {-6, -6, -6, 19}},  /* año */
+    [243] = {0x6265656eull, {-6, 19, -6, -6}},  /* been */
+    [244] = {0x7775726465ull, {-6, -6, 19, -6}},  /* wurde */
+    [246] = {0x696368ull, {-10, -10, 29, -10}},  /* ich */
+    [248] = {0x74686174ull, {-8, 23, -8, -8}},  /* that */
+    [251] = {0xc3ba6c74696d6full, {-6, -6, -6, 19}},  /* último */
+};
+
+#endif
@@ -0,0 +1,257 @@
+/**
+ * @file metrics.c
+ * @brief Compteurs et histogrammes du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Les métriques sont réparties en cases par thread alignées sur une ligne de
+ * cache. Un événement coûte un accès TLS et un ajout atomique relâché sur une
+ * ligne que personne d'autre n'écrit. La lecture additionne toutes les cases
+ * et produit un texte au format Prometheus, réécrit périodiquement dans un
+ * fichier par un thread dédié.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+/** @brief Case de métriques d'un thread */
+struct metric_slot {
+    atomic_int used;
+    _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    _Atomic uint64_t buckets[METRIC_HISTOGRAM_COUNT][METRIC_BUCKETS];
+    _Atomic uint64_t sums[METRIC_HISTOGRAM_COUNT];
+} __attribute__((aligned(64)));
+
+static struct metric_slot slots[METRICS_MAX_THREADS];
+static __thread struct metric_slot *thread_slot;
+
+/** @brief Noms et étiquettes Prometheus des compteurs */
+static const struct {
+    const char *name;
+    const char *labels;
+    const char *help;
+} counter_info[METRIC_COUNTER_COUNT] = {
+    [METRIC_SIGUSR1] = {"miniteams_signals_total", "{type=\"SIGUSR1\"}", "Signaux reçus par type"},
+    [METRIC_SIGUSR2] = {"miniteams_signals_total", "{type=\"SIGUSR2\"}", NULL},
+    [METRIC_SIGQUIT] = {"miniteams_signals_total", "{type=\"SIGQUIT\"}", NULL},
+    [METRIC_BYTES_REASSEMBLED] = {"miniteams_bytes_reassembled_total", "", "Octets reconstitués"},
+    [METRIC_MESSAGES] = {"miniteams_messages_total", "", "Messages complets traités"},
+    [METRIC_TRUNCATIONS] = {"miniteams_truncations_total", "", "Messages tronqués"},
+    [METRIC_SIGNALS_DROPPED] = {"miniteams_signals_dropped_total", "", "Signaux perdus faute de place"},
+    [METRIC_CACHE_HITS] = {"miniteams_langue_cache_total", "{result=\"hit\"}", "Consultations du cache des langues"},
+    [METRIC_CACHE_MISSES] = {"miniteams_langue_cache_total", "{result=\"miss\"}", NULL},
+    [METRIC_LOOP_WAKEUPS] = {"miniteams_loop_wakeups_total", "", "Réveils de la boucle d'événements"},
+    [METRIC_LOG_FLUSHES] = {"miniteams_log_flushes_total", "", "Lots écrits dans le log (écriture + fdatasync)"},
+    [METRIC_POOL_EXHAUSTED] = {"miniteams_message_pool_exhausted_total", "", "Messages refusés faute de tampon libre"},
+    [METRIC_BUSY_ACKS] = {"miniteams_busy_acks_total", "", "ACK de refus envoyés (serveur saturé)"},
+    [METRIC_RATE_LIMITED] = {"miniteams_rate_limited_total", "", "Clients retenus faute de jeton (limite de débit)"},
+    [METRIC_SESSIONS_RECOVERED] = {"miniteams_sessions_recovered_total", "", "Sessions interrompues retrouvées dans le journal"},
+    [METRIC_RESUMES] = {"miniteams_resumes_total", "", "Demandes de reprise reçues des clients"},
+    [METRIC_RELAYED] = {"miniteams_relayed_total", "", "Messages envoyés aux abonnés du relais"},
+    [METRIC_RELAY_DROPPED] = {"miniteams_relay_dropped_total", "", "Messages abandonnés dans la file d'un abonné lent"},
+};
+
+/** @brief Noms et descriptions Prometheus des jauges */
+static const struct {
+    const char *name;
+    const char *help;
+} gauge_info[METRIC_GAUGE_COUNT] = {
+    [METRIC_POOL_FREE] = {"miniteams_message_pool_free", "Tampons libres dans la réserve"},
+    [METRIC_CLASSIFY_QUEUE] = {"miniteams_classify_queue_depth", "Messages en attente de détection de langue"},
+    [METRIC_LOG_QUEUE] = {"miniteams_log_queue_depth", "Messages en attente d'écriture dans le log"},
+    [METRIC_SCHED_QUEUE] = {"miniteams_sched_queue_depth", "Signaux en attente dans les files des clients"},
+    [METRIC_SUBSCRIBERS] = {"miniteams_subscribers", "Abonnés connectés au relais"},
+};
+
+/** @brief Fonctions de lecture des jauges (NULL : jauge non exportée) */
+static uint64_t (*gauge_read[METRIC_GAUGE_COUNT])(void);
+
+/** @brief Noms et descriptions Prometheus des histogrammes */
+static const struct {
+    const char *name;
+    const char *help;
+} histogram_info[METRIC_HISTOGRAM_COUNT] = {
+    [METRIC_ACK_LATENCY] = {"miniteams_ack_latency_seconds", "Délai entre réception d'un bit et envoi de l'ACK"},
+    [METRIC_CLASSIFY_TIME] = {"miniteams_classify_seconds", "Durée de la détection de langue"},
+    [METRIC_LOG_WRITE] = {"miniteams_log_write_seconds", "Durée d'écriture d'un message dans le log"},
+    [METRIC_INTERACTIVE_LATENCY] = {"miniteams_interactive_latency_seconds", "Message interactif : remise par le transport jusqu'au log"},
+    [METRIC_BULK_LATENCY] = {"miniteams_bulk_latency_seconds", "Envoi de masse : remise par le transport jusqu'au log"},
+    [METRIC_RELAY_LATENCY] = {"miniteams_relay_latency_seconds", "Remise par le transport jusqu'à l'envoi à un abonné"},
+};
+
+/**
+ * @brief Renvoie la case du thread courant, en la réservant au premier appel
+ *
+ * Si toutes les cases sont prises, la dernière est partagée : les ajouts
+ * restent corrects puisqu'ils sont atomiques.
+ */
+static struct metric_slot *get_slot(void) {
+    struct metric_slot *slot = thread_slot;
+    if (slot) {
+        return slot;
+    }
+    for (int i = 0; i < METRICS_MAX_THREADS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&slots[i].used, &expected, 1)) {
+            thread_slot = &slots[i];
+            return thread_slot;
+        }
+    }
+    thread_slot = &slots[METRICS_MAX_THREADS - 1];
+    return thread_slot;
+}
+
+/** @brief Horloge monotone en nanosecondes (utilisable dans un handler) */
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void metrics_add(enum metric_counter counter, uint64_t value) {
+    atomic_fetch_add_explicit(&get_slot()->counters[counter], value, memory_order_relaxed);
+}
+
+/**
+ * @brief Enregistre une durée dans un histogramme
+ *
+ * La classe i contient les durées de [2^i, 2^(i+1)[ nanosecondes.
+ */
+void metrics_observe(enum metric_histogram histogram, uint64_t ns) {
+    struct metric_slot *slot = get_slot();
+    int bucket = ns ? 63 - __builtin_clzll(ns) : 0;
+    if (bucket >= METRIC_BUCKETS) {
+        bucket = METRIC_BUCKETS - 1;
+    }
+    atomic_fetch_add_explicit(&slot->buckets[histogram][bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&slot->sums[histogram], ns, memory_order_relaxed);
+}
+
+/**
+ * @brief Déclare la fonction qui donne la valeur courante d'une jauge
+ *
+ * La fonction est appelée par le thread qui exporte les métriques : elle
+ * doit se contenter de lectures atomiques.
+ */
+void metrics_gauge(enum metric_gauge gauge, uint64_t (*read)(void)) {
+    gauge_read[gauge] = read;
+}
+
+/**
+ * @brief Écrit la somme de toutes les cases au format texte Prometheus
+ */
+void metrics_write_prometheus(FILE *out) {
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        uint64_t total = 0;
+        for (int i = 0; i < METRICS_MAX_THREADS; i++) {
+            total += atomic_load_explicit(&slots[i].counters[c], memory_order_relaxed);
+        }
+        if (counter_info[c].help) {
+            fprintf(out, "# HELP %s %s\n", counter_info[c].name, counter_info[c].help);
+            fprintf(out, "# TYPE %s counter\n", counter_info[c].name);
+        }
+        fprintf(out, "%s%s %llu\n", counter_info[c].name, counter_info[c].labels,
+                (unsigned long long)total);
+    }
+
+    for (int g = 0; g < METRIC_GAUGE_COUNT; g++) {
+        if (gauge_read[g]) {
+            fprintf(out, "# HELP %s %s\n", gauge_info[g].name, gauge_info[g].help);
+            fprintf(out, "# TYPE %s gauge\n", gauge_info[g].name);
+            fprintf(out, "%s %llu\n", gauge_info[g].name, (unsigned long long)gauge_read[g]());
+        }
+    }
+
+    for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        uint64_t buckets[METRIC_BUCKETS] = {0};
+        uint64_t sum = 0;
+        for (int i = 0; i < METRICS_MAX_THREADS; i++) {
+            for (int b = 0; b < METRIC_BUCKETS; b++) {
+                buckets[b] += atomic_load_explicit(&slots[i].buckets[h][b], memory_order_relaxed);
+            }
+            sum += atomic_load_explicit(&slots[i].sums[h], memory_order_relaxed);
+        }
+
+        const char *name = histogram_info[h].name;
+        fprintf(out, "# HELP %s %s\n", name, histogram_info[h].help);
+        fprintf(out, "# TYPE %s histogram\n", name);
+        uint64_t cumulative = 0;
+        for (int b = 0; b < METRIC_BUCKETS; b++) {
+            cumulative += buckets[b];
+            fprintf(out, "%s_bucket{le=\"%g\"} %llu\n", name, (double)(2ull << b) / 1e9,
+                    (unsigned long long)cumulative);
+        }
+        fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)cumulative);
+        fprintf(out, "%s_sum %g\n", name, sum / 1e9);
+        fprintf(out, "%s_count %llu\n", name, (unsigned long long)cumulative);
+    }
+}
+
+/** @brief Paramètres du thread d'export */
+struct exporter_args {
+    char *path;
+    unsigned interval_ms;
+};
+
+/**
+ * @brief Réécrit périodiquement le fichier de métriques
+ *
+ * Le fichier est écrit sous un nom temporaire puis renommé pour que les
+ * lecteurs ne voient jamais un fichier à moitié écrit.
+ */
+static void *exporter_thread(void *arg) {
+    struct exporter_args *args = arg;
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", args->path);
+
+    while (1) {
+        FILE *out = fopen(tmp_path, "w");
+        if (out) {
+            metrics_write_prometheus(out);
+            fclose(out);
+            rename(tmp_path, args->path);
+        }
+        usleep(args->interval_ms * 1000);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Démarre le thread qui exporte les métriques dans un fichier
+ * @param path Chemin du fichier de métriques
+ * @param interval_ms Période de réécriture en millisecondes
+ * @return 0 en cas de succès, -1 sinon
+ *
+ * Le thread bloque tous les signaux pour qu'ils restent traités par le
+ * thread principal.
+ */
+int metrics_start_exporter(const char *path, unsigned interval_ms) {
+    struct exporter_args *args = malloc(sizeof(*args));
+    if (!args) {
+        return -1;
+    }
+    args->path = strdup(path);
+    args->interval_ms = interval_ms;
+
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    pthread_t thread;
+    int err = pthread_create(&thread, NULL, exporter_thread, args);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        free(args->path);
+        free(args);
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file metrics.h
+ * @brief Compteurs et histogrammes du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Chaque thread écrit dans sa propre case (pas de partage de ligne de cache),
+ * les cases sont additionnées à la lecture. Les mises à jour n'utilisent que
+ * des opérations atomiques et peuvent donc être faites depuis un gestionnaire
+ * de signal.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** @brief Compteurs exportés */
+enum metric_counter {
+    METRIC_SIGUSR1,             /**< Bits à 1 reçus */
+    METRIC_SIGUSR2,             /**< Bits à 0 reçus */
+    METRIC_SIGQUIT,             /**< Signaux de fin de message reçus */
+    METRIC_BYTES_REASSEMBLED,   /**< Octets reconstitués à partir des bits */
+    METRIC_MESSAGES,            /**< Messages complets traités */
+    METRIC_TRUNCATIONS,         /**< Messages tronqués faute de place */
+    METRIC_SIGNALS_DROPPED,     /**< Signaux perdus (file ou table des sessions pleine) */
+    METRIC_CACHE_HITS,          /**< Langues trouvées dans le cache */
+    METRIC_CACHE_MISSES,        /**< Langues absentes du cache (détection complète) */
+    METRIC_LOOP_WAKEUPS,        /**< Réveils de la boucle d'événements (lots traités) */
+    METRIC_LOG_FLUSHES,         /**< Lots de lignes écrits dans le log */
+    METRIC_POOL_EXHAUSTED,      /**< Messages refusés faute de tampon libre */
+    METRIC_BUSY_ACKS,           /**< ACK de refus envoyés aux clients (serveur saturé) */
+    METRIC_RATE_LIMITED,        /**< Clients retenus faute de jeton (limite de débit) */
+    METRIC_SESSIONS_RECOVERED,  /**< Sessions interrompues retrouvées dans le journal au démarrage */
+    METRIC_RESUMES,             /**< Demandes de reprise reçues des clients */
+    METRIC_RELAYED,             /**< Messages envoyés aux abonnés du relais */
+    METRIC_RELAY_DROPPED,       /**< Messages abandonnés dans la file d'un abonné lent */
+    METRIC_COUNTER_COUNT
+};
+
+/** @brief Histogrammes de durées exportés (en nanosecondes) */
+enum metric_histogram {
+    METRIC_ACK_LATENCY,         /**< Réception d'un bit -> envoi de l'ACK */
+    METRIC_CLASSIFY_TIME,       /**< Durée de la détection (cache compris) */
+    METRIC_LOG_WRITE,           /**< Durée de save_message() */
+    METRIC_INTERACTIVE_LATENCY, /**< Message interactif : remise par le transport -> log */
+    METRIC_BULK_LATENCY,        /**< Envoi de masse : remise par le transport -> log */
+    METRIC_RELAY_LATENCY,       /**< Remise par le transport -> envoi à un abonné */
+    METRIC_HISTOGRAM_COUNT
+};
+
+/** @brief Jauges exportées, lues au moment de l'export */
+enum metric_gauge {
+    METRIC_POOL_FREE,           /**< Tampons libres dans la réserve */
+    METRIC_CLASSIFY_QUEUE,      /**< Messages en attente de détection de langue */
+    METRIC_LOG_QUEUE,           /**< Messages en attente d'écriture dans le log */
+    METRIC_SCHED_QUEUE,         /**< Signaux en attente dans les files des clients */
+    METRIC_SUBSCRIBERS,         /**< Abonnés connectés au relais */
+    METRIC_GAUGE_COUNT
+};
+
+/** @brief Nombre de classes des histogrammes (puissances de 2 en ns) */
+#define METRIC_BUCKETS 40
+
+/** @brief Nombre maximal de threads pouvant publier des métriques */
+#define METRICS_MAX_THREADS 64
+
+uint64_t metrics_now_ns(void);
+void metrics_add(enum metric_counter counter, uint64_t value);
+void metrics_observe(enum metric_histogram histogram, uint64_t ns);
+void metrics_gauge(enum metric_gauge gauge, uint64_t (*read)(void));
+void metrics_write_prometheus(FILE *out);
+int metrics_start_exporter(const char *path, unsigned interval_ms);
+
+/** @brief Incrémente un compteur de 1 */
+static inline void metrics_inc(enum metric_counter counter) {
+    metrics_add(counter, 1);
+}
+
+#endif
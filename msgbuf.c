@@ -0,0 +1,117 @@
+/**
+ * @file msgbuf.c
+ * @brief Réserve de tampons de messages à compteur de références
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Les tampons libres forment une pile sans verrou (Treiber). La tête
+ * porte, à côté de l'indice du sommet, un compteur de modifications qui
+ * empêche le problème ABA : un tampon peut être rendu par n'importe quel
+ * thread de la chaîne de traitement.
+ */
+
+#include <stdlib.h>
+
+#include "msgbuf.h"
+
+#define MSGBUF_NONE 0xFFFFFFFFu
+
+static struct message_buffer *pool;
+/** @brief Sommet de la pile libre (32 bits bas) et compteur (32 bits hauts) */
+static _Atomic uint64_t free_top;
+static _Atomic unsigned available;
+static unsigned capacity = 0;
+
+/**
+ * @brief Alloue la réserve, une fois au démarrage
+ * @param count Nombre de tampons (1 à MSGBUF_POOL_SIZE)
+ * @return 0 en cas de succès, -1 sinon
+ */
+int msgbuf_pool_init(unsigned count) {
+    if (count == 0 || count > MSGBUF_POOL_SIZE) {
+        return -1;
+    }
+    pool = aligned_alloc(64, count * sizeof(struct message_buffer));
+    if (!pool) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        atomic_init(&pool[i].refs, 0);
+        pool[i].next = i + 1 < count ? i + 1 : MSGBUF_NONE;
+    }
+    atomic_store(&free_top, 0);
+    atomic_store(&available, count);
+    capacity = count;
+    return 0;
+}
+
+/**
+ * @brief Prend un tampon libre, avec une référence
+ * @return Le tampon, ou NULL si la réserve est vide
+ *
+ * Seuls les champs de description sont remis à zéro, pas les octets du
+ * message.
+ */
+struct message_buffer *msgbuf_get(void) {
+    uint64_t top = atomic_load_explicit(&free_top, memory_order_acquire);
+    struct message_buffer *b;
+    do {
+        uint32_t index = (uint32_t)top;
+        if (index == MSGBUF_NONE) {
+            return NULL;
+        }
+        b = &pool[index];
+        uint64_t next = ((top >> 32) + 1) << 32 | b->next;
+        if (atomic_compare_exchange_weak_explicit(&free_top, &top, next,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            break;
+        }
+    } while (1);
+
+    atomic_fetch_sub_explicit(&available, 1, memory_order_relaxed);
+    atomic_store_explicit(&b->refs, 1, memory_order_relaxed);
+    b->pid = 0;
+    b->length = 0;
+    b->truncated = 0;
+    b->transport = NULL;
+    b->lane = LANE_INTERACTIVE;
+    b->received_ns = 0;
+    b->data[0] = '\0';
+    return b;
+}
+
+/** @brief Rend une référence ; la dernière remet le tampon dans la réserve */
+void msgbuf_put(struct message_buffer *b) {
+    if (atomic_fetch_sub_explicit(&b->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    uint32_t index = b - pool;
+    uint64_t top = atomic_load_explicit(&free_top, memory_order_relaxed);
+    uint64_t next;
+    do {
+        b->next = (uint32_t)top;
+        next = ((top >> 32) + 1) << 32 | index;
+    } while (!atomic_compare_exchange_weak_explicit(&free_top, &top, next,
+                                                    memory_order_release, memory_order_relaxed));
+    atomic_fetch_add_explicit(&available, 1, memory_order_relaxed);
+}
+
+/** @brief Indice d'un tampon dans la réserve */
+uint32_t msgbuf_index(const struct message_buffer *b) {
+    return b - pool;
+}
+
+/** @brief Tampon d'indice donné */
+struct message_buffer *msgbuf_at(uint32_t index) {
+    return &pool[index];
+}
+
+/** @brief Nombre de tampons libres (indicatif) */
+unsigned msgbuf_available(void) {
+    return atomic_load_explicit(&available, memory_order_relaxed);
+}
+
+/** @brief Nombre de tampons de la réserve */
+unsigned msgbuf_capacity(void) {
+    return capacity;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file msgbuf.h
+ * @brief Réserve de tampons de messages à compteur de références
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un message est reçu une fois dans un tampon de la réserve, puis passe
+ * sans copie de la boucle d'événements au thread de détection de langue et
+ * enfin au log. Chaque étape qui garde le tampon détient une référence ;
+ * le tampon revient à la réserve quand la dernière est rendue.
+ *
+ * La réserve a une capacité fixe : quand elle est vide, les transports
+ * refusent les nouveaux messages au lieu d'allouer.
+ */
+
+#ifndef MSGBUF_H
+#define MSGBUF_H
+
+#include <stdint.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+#include "langue.h"
+
+/** @brief Taille maximale d'un message (terminateur compris) */
+#define MESSAGE_MAX 1024
+/** @brief Nombre maximal de tampons de la réserve, capacité des files (puissance de 2) */
+#define MSGBUF_POOL_SIZE 1024
+/** @brief Taille au-delà de laquelle un message est traité comme envoi de masse */
+#define LANE_INTERACTIVE_MAX 256
+
+/**
+ * @brief Classe de priorité d'un message
+ *
+ * Les messages interactifs passent avant les envois de masse à chaque
+ * étape (ACK, détection de langue, log) ; les envois de masse utilisent la
+ * capacité restante.
+ */
+enum msgbuf_lane {
+    LANE_INTERACTIVE,           /**< Message court : latence minimale */
+    LANE_BULK,                  /**< Gros envoi : capacité restante */
+    LANE_COUNT
+};
+
+/** @brief Message et son état dans la chaîne de traitement */
+struct message_buffer {
+    _Atomic int refs;           /**< Références détenues */
+    uint32_t next;              /**< Suivant dans la liste libre */
+    pid_t pid;                  /**< PID de l'émetteur */
+    uint32_t length;            /**< Longueur du message */
+    int truncated;              /**< Une partie du message a été perdue */
+    const char *transport;      /**< Nom du transport d'arrivée */
+    int lane;                   /**< Classe de priorité (enum msgbuf_lane) */
+    uint64_t received_ns;       /**< Remise par le transport (CLOCK_MONOTONIC) */
+    struct langue_result result;/**< Langue, remplie par la détection */
+    uint64_t log_offset;        /**< Position de la ligne dans le log, remplie par son écriture */
+    char data[MESSAGE_MAX];     /**< Octets du message, terminés par '\0' */
+};
+
+/**
+ * @brief File sans verrou de tampons, un producteur et un consommateur
+ *
+ * Un tampon n'est jamais dans deux files à la fois : une capacité égale
+ * à celle de la réserve suffit pour que l'ajout n'échoue jamais.
+ */
+struct msgbuf_queue {
+    alignas(64) _Atomic uint32_t head;
+    alignas(64) _Atomic uint32_t tail;
+    alignas(64) struct message_buffer *items[MSGBUF_POOL_SIZE];
+};
+
+int msgbuf_pool_init(unsigned count);
+struct message_buffer *msgbuf_get(void);
+void msgbuf_put(struct message_buffer *b);
+unsigned msgbuf_available(void);
+unsigned msgbuf_capacity(void);
+uint32_t msgbuf_index(const struct message_buffer *b);
+struct message_buffer *msgbuf_at(uint32_t index);
+
+/** @brief Prend une référence supplémentaire sur un tampon */
+static inline struct message_buffer *msgbuf_ref(struct message_buffer *b) {
+    atomic_fetch_add_explicit(&b->refs, 1, memory_order_relaxed);
+    return b;
+}
+
+/** @brief Ajoute un tampon à la file (côté producteur) */
+static inline void msgbuf_queue_push(struct msgbuf_queue *q, struct message_buffer *b) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    q->items[head & (MSGBUF_POOL_SIZE - 1)] = b;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+}
+
+/** @brief Retire un tampon de la file (côté consommateur), NULL si vide */
+static inline struct message_buffer *msgbuf_queue_pop(struct msgbuf_queue *q) {
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&q->head, memory_order_acquire)) {
+        return NULL;
+    }
+    struct message_buffer *b = q->items[tail & (MSGBUF_POOL_SIZE - 1)];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return b;
+}
+
+/** @brief Nombre de tampons dans la file */
+static inline uint32_t msgbuf_queue_depth(struct msgbuf_queue *q) {
+    return atomic_load_explicit(&q->head, memory_order_acquire) -
+           atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+#endif
@@ -0,0 +1,293 @@
+/**
+ * @file placement.c
+ * @brief Placement des threads du serveur sur les CPU et les nœuds NUMA
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Les threads sont fixés par pthread_setaffinity_np() et notés dans une
+ * table pour le rapport de placement. Un thread dont le rôle n'a pas
+ * d'ensemble de CPU reprend les CPU du processus au démarrage : il
+ * n'hérite pas de ceux du thread principal, fixé sur ceux de la réception.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "placement.h"
+
+/** @brief Nombre maximal de threads notés pour le rapport */
+#define PLACEMENT_THREADS_MAX 16
+
+static const char *role_names[PLACEMENT_ROLE_COUNT] = {
+    [PLACEMENT_RECEPTION] = "réception",
+    [PLACEMENT_CLASSIFIER] = "détection",
+    [PLACEMENT_INDEX] = "index",
+};
+
+/** @brief CPU demandés par rôle */
+static cpu_set_t role_cpus[PLACEMENT_ROLE_COUNT];
+static int role_pinned[PLACEMENT_ROLE_COUNT];
+
+/** @brief Thread placé */
+struct placed_thread {
+    const char *name;
+    enum placement_role role;
+    pid_t tid;
+};
+
+static struct placed_thread threads[PLACEMENT_THREADS_MAX];
+static int thread_count = 0;
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief CPU du processus au démarrage */
+static cpu_set_t process_cpus;
+/** @brief Nœud NUMA de chaque CPU (-1 : inconnu) */
+static short cpu_nodes[CPU_SETSIZE];
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Lit la liste des CPU de chaque nœud et les CPU du processus
+ *
+ * À faire avant de fixer le premier thread : process_cpus doit être
+ * l'ensemble d'origine.
+ */
+static void placement_init(void) {
+    memset(cpu_nodes, 0xFF, sizeof(cpu_nodes));
+    if (sched_getaffinity(0, sizeof(process_cpus), &process_cpus) != 0) {
+        CPU_ZERO(&process_cpus);
+    }
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int node;
+        char rest;
+        if (sscanf(entry->d_name, "node%d%c", &node, &rest) != 1 || node < 0) {
+            continue;
+        }
+        char path[300], list[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+        FILE *in = fopen(path, "r");
+        if (!in) {
+            continue;
+        }
+        cpu_set_t set;
+        if (fgets(list, sizeof(list), in) && placement_parse(list, &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpu_nodes[cpu] = node;
+                }
+            }
+        }
+        fclose(in);
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Lit une liste de CPU ("0-3,8,10-11")
+ * @return 0 en cas de succès, -1 si la liste est invalide ou vide
+ */
+int placement_parse(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p) {
+            return -1;
+        }
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return -1;
+            }
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE) {
+            return -1;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p && *p != '\n') {
+            return -1;
+        }
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+/** @brief Nœud NUMA d'un CPU (0 si la machine n'en déclare pas) */
+int placement_cpu_node(int cpu) {
+    pthread_once(&init_once, placement_init);
+    if (cpu < 0 || cpu >= CPU_SETSIZE || cpu_nodes[cpu] < 0) {
+        return 0;
+    }
+    return cpu_nodes[cpu];
+}
+
+/**
+ * @brief Donne les CPU d'un rôle
+ * @param list Liste de CPU, ou NULL / "" pour ne pas fixer le rôle
+ * @return 0 en cas de succès, -1 si la liste est invalide ou sans CPU
+ * disponible pour le processus
+ */
+int placement_set(enum placement_role role, const char *list) {
+    pthread_once(&init_once, placement_init);
+    if (!list || !list[0]) {
+        role_pinned[role] = 0;
+        return 0;
+    }
+    cpu_set_t set;
+    if (placement_parse(list, &set) != 0) {
+        return -1;
+    }
+    CPU_AND(&set, &set, &process_cpus);
+    if (CPU_COUNT(&set) == 0) {
+        return -1;
+    }
+    role_cpus[role] = set;
+    role_pinned[role] = 1;
+    return 0;
+}
+
+/**
+ * @brief Fixe le thread appelant sur les CPU de son rôle et le note
+ * @param name Nom du thread dans le rapport
+ * @return 0 en cas de succès, -1 si l'affinité n'a pu être changée
+ *
+ * À appeler au début du thread, avant ses allocations : elles seront
+ * faites sur le nœud de ses CPU.
+ */
+int placement_apply(enum placement_role role, const char *name) {
+    pthread_once(&init_once, placement_init);
+    const cpu_set_t *set = role_pinned[role] ? &role_cpus[role] : &process_cpus;
+    int status = 0;
+    if (CPU_COUNT(set) > 0) {
+        status = pthread_setaffinity_np(pthread_self(), sizeof(*set), set);
+        if (status != 0) {
+            errno = status;
+            status = -1;
+        }
+    }
+    pthread_mutex_lock(&threads_lock);
+    if (thread_count < PLACEMENT_THREADS_MAX) {
+        threads[thread_count].name = name;
+        threads[thread_count].role = role;
+        threads[thread_count].tid = syscall(SYS_gettid);
+        thread_count++;
+    }
+    pthread_mutex_unlock(&threads_lock);
+    return status;
+}
+
+/** @brief Écrit un ensemble de CPU sous forme de liste ("0-3,8") */
+static void format_cpus(const cpu_set_t *set, char *out, size_t size) {
+    size_t used = 0;
+    out[0] = '\0';
+    for (int cpu = 0; cpu < CPU_SETSIZE && used < size; cpu++) {
+        if (!CPU_ISSET(cpu, set)) {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) {
+            last++;
+        }
+        int n = last > cpu ? snprintf(out + used, size - used, "%s%d-%d", used ? "," : "", cpu, last)
+                           : snprintf(out + used, size - used, "%s%d", used ? "," : "", cpu);
+        used += n > 0 ? (size_t)n : 0;
+        cpu = last;
+    }
+}
+
+/** @brief CPU où un thread a tourné en dernier (/proc, champ 39 de stat) */
+static int last_cpu(pid_t tid) {
+    char path[64], stat[1024];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        return -1;
+    }
+    size_t n = fread(stat, 1, sizeof(stat) - 1, in);
+    fclose(in);
+    stat[n] = '\0';
+    char *p = strrchr(stat, ')');
+    if (!p) {
+        return -1;
+    }
+    // Après le nom : champs 3 (état) à 39 (processeur)
+    for (int field = 2; field < 39 && p; field++) {
+        p = strchr(p + 1, ' ');
+    }
+    return p ? atoi(p + 1) : -1;
+}
+
+/** @brief Écrit un texte UTF-8 complété par des espaces jusqu'à width caractères */
+static void print_padded(FILE *out, const char *text, int width) {
+    int chars = 0;
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        chars += (*p & 0xC0) != 0x80;
+    }
+    fprintf(out, "%s%*s", text, width > chars ? width - chars : 0, "");
+}
+
+/**
+ * @brief Rapport de placement : CPU autorisés, dernier CPU et nœuds de
+ * chaque thread noté
+ */
+void placement_report(FILE *out) {
+    pthread_once(&init_once, placement_init);
+    pthread_mutex_lock(&threads_lock);
+    for (int i = 0; i < thread_count; i++) {
+        cpu_set_t set;
+        char cpus[256] = "?";
+        uint64_t nodes = 0;
+        if (sched_getaffinity(threads[i].tid, sizeof(set), &set) == 0) {
+            format_cpus(&set, cpus, sizeof(cpus));
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set) && placement_cpu_node(cpu) < PLACEMENT_NODES_MAX) {
+                    nodes |= 1ull << placement_cpu_node(cpu);
+                }
+            }
+        }
+        char node_list[128] = "";
+        size_t used = 0;
+        for (int node = 0; node < PLACEMENT_NODES_MAX && used < sizeof(node_list); node++) {
+            if (nodes & (1ull << node)) {
+                used += snprintf(node_list + used, sizeof(node_list) - used, "%s%d", used ? "," : "", node);
+            }
+        }
+        print_padded(out, threads[i].name, 11);
+        print_padded(out, role_names[threads[i].role], 11);
+        fprintf(out, "TID %-7d CPU %-12s %-6s nœud %-6s dernier CPU %d\n", threads[i].tid, cpus,
+                role_pinned[threads[i].role] ? "(fixé)" : "", node_list, last_cpu(threads[i].tid));
+    }
+    pthread_mutex_unlock(&threads_lock);
+}
+
+/**
+ * @brief Nœud NUMA de la page d'une adresse
+ * @return Le nœud, ou -1 si la page n'est pas encore en mémoire ou si le
+ * noyau ne le dit pas
+ */
+int placement_memory_node(const void *address) {
+    void *page = (void *)((uintptr_t)address & ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1));
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, NULL, &status, 0) != 0) {
+        return -1;
+    }
+    return status >= 0 ? status : -1;
+}
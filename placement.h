@@ -0,0 +1,40 @@
+/**
+ * @file placement.h
+ * @brief Placement des threads du serveur sur les CPU et les nœuds NUMA
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Chaque thread de la chaîne de traitement a un rôle (réception,
+ * détection de langue, index) ; un ensemble de CPU peut être donné pour
+ * chaque rôle ("0-3,8"). Un thread fixé alloue ensuite lui-même ses
+ * tampons et ses tables : avec la politique du premier accès de Linux, la
+ * mémoire est prise sur le nœud NUMA de ses CPU.
+ *
+ * Le nœud de chaque CPU est lu dans /sys/devices/system/node.
+ */
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stdio.h>
+#include <sched.h>     // cpu_set_t : _GNU_SOURCE doit être défini avant
+
+/** @brief Rôle d'un thread */
+enum placement_role {
+    PLACEMENT_RECEPTION,        /**< Gestionnaire de signaux et boucle d'événements (log compris) */
+    PLACEMENT_CLASSIFIER,       /**< Détection de langue */
+    PLACEMENT_INDEX,            /**< Index plein texte */
+    PLACEMENT_ROLE_COUNT
+};
+
+/** @brief Nombre maximal de nœuds NUMA reconnus */
+#define PLACEMENT_NODES_MAX 64
+
+int placement_parse(const char *list, cpu_set_t *set);
+int placement_cpu_node(int cpu);
+int placement_set(enum placement_role role, const char *list);
+int placement_apply(enum placement_role role, const char *name);
+void placement_report(FILE *out);
+int placement_memory_node(const void *address);
+
+#endif
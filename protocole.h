@@ -0,0 +1,87 @@
+/**
+ * @file protocole.h
+ * @brief Constantes du protocole par signaux partagées par le client et le serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Protocole de base : SIGUSR1 pour un bit à 1, SIGUSR2 pour un bit à 0,
+ * SIGQUIT en fin de message ; le serveur accuse réception de chaque bit par
+ * SIGUSR1.
+ *
+ * Un client peut envoyer ses bits avec sigqueue() pour passer des drapeaux
+ * dans si_value. Les signaux classiques ne sont pas mis en file : deux ACK
+ * SIGUSR1 venant de serveurs différents peuvent fusionner. Le drapeau
+ * PROTO_FLAG_RT_ACK demande donc au serveur de répondre avec un signal
+ * temps réel, mis en file et identifiable par si_pid.
+ *
+ * Contrôle de flux : un client qui envoie PROTO_FLAG_CREDIT reçoit ses ACK
+ * par sigqueue(). Leur si_value reprend ses drapeaux et y ajoute le crédit
+ * du serveur (nombre de messages qu'il peut encore accepter sans attendre,
+ * PROTO_ACK_CREDIT()) et éventuellement PROTO_ACK_BUSY : le serveur est
+ * saturé et le bit n'a pas été enregistré. Le client fait alors une pause et
+ * renvoie le même bit au lieu d'attendre l'expiration. Un client sans ce
+ * drapeau n'est jamais acquitté quand le serveur est saturé.
+ *
+ * Priorité : le premier bit d'une session envoyé avec PROTO_FLAG_BULK la
+ * classe en envoi de masse ; ses ACK, sa détection de langue et son
+ * écriture dans le log passent après ceux des sessions interactives.
+ *
+ * Reprise : un SIGUSR1 envoyé avec PROTO_FLAG_RESUME n'est pas un bit mais
+ * une question. Le serveur répond par un ACK dont si_value porte le nombre
+ * de bits de la session du client qu'il a déjà (PROTO_ACK_OFFSET(), 0 s'il
+ * ne la connaît pas) ; le client reprend l'envoi à ce bit. Un serveur
+ * relancé retrouve les sessions interrompues dans son journal (session.h).
+ */
+
+#ifndef PROTOCOLE_H
+#define PROTOCOLE_H
+
+#include <signal.h>
+
+/** @brief Le client veut ses ACK sur SIG_ACK_RT plutôt que SIGUSR1 */
+#define PROTO_FLAG_RT_ACK 0x1
+
+/** @brief Le client lit le crédit et le refus dans si_value des ACK */
+#define PROTO_FLAG_CREDIT 0x2
+
+/** @brief Session d'envoi de masse (lu sur le premier bit de la session) */
+#define PROTO_FLAG_BULK 0x4
+
+/** @brief Demande de la position de reprise (pas un bit) */
+#define PROTO_FLAG_RESUME 0x8
+
+/** @brief ACK de refus : serveur saturé, bit à renvoyer après une pause */
+#define PROTO_ACK_BUSY 0x100
+/** @brief Position du crédit dans si_value d'un ACK */
+#define PROTO_CREDIT_SHIFT 16
+/** @brief Crédit maximal annoncé */
+#define PROTO_CREDIT_MAX 0x7FFF
+/** @brief Crédit annoncé par un ACK */
+#define PROTO_ACK_CREDIT(value) (((unsigned)(value) >> PROTO_CREDIT_SHIFT) & PROTO_CREDIT_MAX)
+
+/** @brief Position de la reprise dans si_value de la réponse à PROTO_FLAG_RESUME */
+#define PROTO_OFFSET_SHIFT 9
+/** @brief Position de reprise maximale (en bits) */
+#define PROTO_OFFSET_MAX 0x7FFFFF
+/** @brief Position de reprise portée par la réponse */
+#define PROTO_ACK_OFFSET(value) (((unsigned)(value) >> PROTO_OFFSET_SHIFT) & PROTO_OFFSET_MAX)
+
+/** @brief Signal temps réel utilisé pour les ACK mis en file */
+#define SIG_ACK_RT (SIGRTMIN)
+
+/** @brief Délai maximal d'attente d'un ACK par le client (µs) */
+#define ACK_TIMEOUT_US 100000
+
+/** @brief Première pause après un refus, doublée à chaque refus suivant (µs) */
+#define FLOW_PAUSE_MIN_US 1000
+/** @brief Pause maximale entre deux tentatives (µs) */
+#define FLOW_PAUSE_MAX_US 64000
+/** @brief Durée cumulée des pauses au-delà de laquelle le client abandonne (µs) */
+#define FLOW_WAIT_MAX_US 30000000
+
+/** @brief Intervalle entre deux demandes de reprise à un serveur absent (µs) */
+#define RESUME_RETRY_US 200000
+/** @brief Attente maximale du retour du serveur avant d'abandonner la reprise (µs) */
+#define RESUME_WAIT_MAX_US 30000000
+
+#endif
@@ -0,0 +1,614 @@
+/**
+ * @file relay.c
+ * @brief Relais des messages reçus vers les clients abonnés à un canal
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un thread dédié, avec sa propre boucle epoll, sert la socket de relais :
+ * il accepte les abonnés, lit leur demande et leur envoie les messages
+ * publiés par l'étape du log. Il bloque tous les signaux, comme les autres
+ * threads de traitement.
+ *
+ * Chaque abonné a une file de références de tampons. Tant qu'elle est
+ * vide, un message lui est envoyé directement ; sinon (ou si l'envoi
+ * bloquerait) il rejoint la file et EPOLLOUT est surveillé sur son
+ * descripteur d'envoi jusqu'à ce qu'elle soit vidée. Un envoi est un seul
+ * appel système sur deux ou trois morceaux (en-tête, texte du tampon, fin
+ * de ligne) : ni copie du message ni envoi partiel, un paquet SEQPACKET
+ * et une écriture de moins de PIPE_BUF octets dans un tube étant atomiques.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "relay.h"
+#include "metrics.h"
+#include "placement.h"
+
+/** @brief Identifiants epoll de la socket d'écoute et de l'eventfd de réveil */
+#define ID_LISTEN 0xFFFFFFFFu
+#define ID_WAKE 0xFFFFFFFEu
+/** @brief Marque du tube d'un abonné (sinon : sa connexion) */
+#define ID_PIPE 0x80000000u
+
+/** @brief Canal d'un abonné dont la demande n'est pas encore lue */
+#define CHANNEL_PENDING -1
+/** @brief Canal d'un abonné à tous les canaux */
+#define CHANNEL_ALL -2
+
+_Static_assert((RELAY_QUEUE & (RELAY_QUEUE - 1)) == 0, "RELAY_QUEUE puissance de 2");
+
+/** @brief Abonné au relais */
+struct subscriber {
+    int fd;                     /**< Connexion d'abonnement, -1 si la case est libre */
+    int pipe;                   /**< Tube de l'abonné, -1 : envoi sur la connexion */
+    int channel;                /**< Indice du canal, CHANNEL_PENDING ou CHANNEL_ALL */
+    pid_t pid;                  /**< PID de l'abonné (SO_PEERCRED) */
+    int waiting;                /**< EPOLLOUT surveillé : la file attend */
+    uint32_t head;
+    uint32_t tail;
+    struct message_buffer *queue[RELAY_QUEUE];
+    _Atomic uint64_t sent;      /**< Lu par relay_report() */
+    _Atomic uint64_t dropped;
+};
+
+static struct subscriber subscribers[RELAY_SUBSCRIBERS_MAX];
+/** @brief Cases utilisées au moins une fois (parcours des abonnés) */
+static int subscriber_slots = 0;
+static atomic_uint subscriber_count = 0;
+/** @brief Noms des canaux connus (jamais retirés) */
+static char channels[RELAY_CHANNELS_MAX][RELAY_CHANNEL_MAX];
+static int channel_count = 0;
+/** @brief Protège les cases des abonnés et les canaux contre relay_report() */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief Messages publiés (boucle d'événements -> thread du relais) */
+static struct msgbuf_queue published;
+/** @brief Un message a été publié depuis le dernier réveil (boucle seulement) */
+static int publish_pending = 0;
+
+static int listen_fd = -1;
+static int wake_fd = -1;
+static int epoll_fd = -1;
+static char socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static pthread_t thread;
+static int started = 0;
+static atomic_int stop_requested = 0;
+/** @brief Le thread est placé (rapport de placement au démarrage) */
+static sem_t ready;
+
+/**
+ * @brief Canal d'un message
+ * @param name Reçoit le nom du canal
+ * @return Nombre d'octets du préfixe "#canal " à ne pas relayer
+ */
+static size_t channel_of(const struct message_buffer *b, char name[RELAY_CHANNEL_MAX]) {
+    size_t n = 1;
+    if (b->length > 1 && b->data[0] == '#') {
+        while (n < b->length && n < RELAY_CHANNEL_MAX && b->data[n] != ' ' && b->data[n] != '\n') {
+            n++;
+        }
+        if (n > 1 && n < RELAY_CHANNEL_MAX && (n == b->length || b->data[n] == ' ' || b->data[n] == '\n')) {
+            memcpy(name, b->data + 1, n - 1);
+            name[n - 1] = '\0';
+            return n < b->length ? n + 1 : n;
+        }
+    }
+    strcpy(name, RELAY_DEFAULT_CHANNEL);
+    return 0;
+}
+
+/**
+ * @brief Indice d'un canal
+ * @param create Ajoute le canal s'il est inconnu (lock tenu)
+ * @return L'indice, -1 si le canal est inconnu ou la table pleine
+ */
+static int channel_index(const char *name, int create) {
+    for (int i = 0; i < channel_count; i++) {
+        if (strcmp(channels[i], name) == 0) {
+            return i;
+        }
+    }
+    if (!create || channel_count >= RELAY_CHANNELS_MAX) {
+        return -1;
+    }
+    snprintf(channels[channel_count], RELAY_CHANNEL_MAX, "%s", name);
+    return channel_count++;
+}
+
+/**
+ * @brief En-tête d'un message relayé : "[canal] PID langue (confiance) : "
+ * @param skip Reçoit la longueur du préfixe "#canal " du message
+ * @return Longueur de l'en-tête
+ */
+static size_t format_header(const struct message_buffer *b, char *header, size_t size, size_t *skip) {
+    char name[RELAY_CHANNEL_MAX];
+    *skip = channel_of(b, name);
+    int n = snprintf(header, size, "[%s] PID %d %s (%.2f) : ", name, b->pid,
+                     languages[b->result.best], b->result.confidence);
+    return n < (int)size ? (size_t)n : size - 1;
+}
+
+/**
+ * @brief Envoie un message à un abonné sans bloquer
+ * @return 1 si le message est envoyé, 0 si l'envoi bloquerait, -1 si
+ * l'abonné est parti
+ */
+static int send_one(struct subscriber *s, const struct message_buffer *b, const char *header,
+                    size_t header_length, size_t skip) {
+    struct iovec iov[3] = {
+        {(void *)header, header_length},
+        {(void *)(b->data + skip), b->length - skip},
+        {"\n", 1},
+    };
+    ssize_t n;
+    do {
+        if (s->pipe < 0) {
+            struct msghdr msg = {.msg_iov = iov, .msg_iovlen = 2};
+            n = sendmsg(s->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        } else {
+            n = writev(s->pipe, iov, 3);
+        }
+    } while (n < 0 && errno == EINTR);
+    if (n >= 0) {
+        atomic_fetch_add_explicit(&s->sent, 1, memory_order_relaxed);
+        metrics_inc(METRIC_RELAYED);
+        metrics_observe(METRIC_RELAY_LATENCY, metrics_now_ns() - b->received_ns);
+        return 1;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ? 0 : -1;
+}
+
+/** @brief Surveille ou non EPOLLOUT sur le descripteur d'envoi d'un abonné */
+static void watch_output(struct subscriber *s, int on) {
+    if (s->waiting == on) {
+        return;
+    }
+    uint32_t slot = s - subscribers;
+    struct epoll_event ev;
+    if (s->pipe < 0) {
+        ev.events = EPOLLIN | (on ? EPOLLOUT : 0);
+        ev.data.u32 = slot;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s->fd, &ev);
+    } else {
+        ev.events = on ? EPOLLOUT : 0;  // EPOLLERR (lecteur parti) reste signalé
+        ev.data.u32 = slot | ID_PIPE;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, s->pipe, &ev);
+    }
+    s->waiting = on;
+}
+
+/** @brief Ferme un abonnement et rend les tampons de sa file */
+static void remove_subscriber(struct subscriber *s) {
+    pthread_mutex_lock(&lock);
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    if (s->pipe >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->pipe, NULL);
+        close(s->pipe);
+    }
+    for (; s->tail != s->head; s->tail++) {
+        msgbuf_put(s->queue[s->tail & (RELAY_QUEUE - 1)]);
+    }
+    s->fd = -1;
+    s->pipe = -1;
+    pthread_mutex_unlock(&lock);
+    atomic_fetch_sub_explicit(&subscriber_count, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Ajoute un message à la file d'un abonné
+ *
+ * File pleine : le plus ancien message est abandonné pour cet abonné.
+ */
+static void enqueue(struct subscriber *s, struct message_buffer *b) {
+    if (s->head - s->tail == RELAY_QUEUE) {
+        msgbuf_put(s->queue[s->tail++ & (RELAY_QUEUE - 1)]);
+        atomic_fetch_add_explicit(&s->dropped, 1, memory_order_relaxed);
+        metrics_inc(METRIC_RELAY_DROPPED);
+    }
+    s->queue[s->head++ & (RELAY_QUEUE - 1)] = msgbuf_ref(b);
+    watch_output(s, 1);
+}
+
+/**
+ * @brief Envoie la file d'un abonné jusqu'à ce qu'elle soit vide ou que
+ * l'envoi bloque
+ * @return 0, ou -1 si l'abonné est parti (retiré)
+ */
+static int flush(struct subscriber *s) {
+    while (s->tail != s->head) {
+        struct message_buffer *b = s->queue[s->tail & (RELAY_QUEUE - 1)];
+        char header[RELAY_CHANNEL_MAX + 96];
+        size_t skip, length = format_header(b, header, sizeof(header), &skip);
+        int status = send_one(s, b, header, length, skip);
+        if (status < 0) {
+            remove_subscriber(s);
+            return -1;
+        }
+        if (status == 0) {
+            return 0;
+        }
+        msgbuf_put(b);
+        s->tail++;
+    }
+    watch_output(s, 0);
+    return 0;
+}
+
+/**
+ * @brief Relaie un message publié à tous les abonnés de son canal
+ *
+ * L'en-tête est formaté une fois pour tous les abonnés. La référence
+ * passée par relay_publish() est rendue à la fin ; chaque file qui garde
+ * le message prend la sienne.
+ */
+static void dispatch(struct message_buffer *b) {
+    char header[RELAY_CHANNEL_MAX + 96], name[RELAY_CHANNEL_MAX];
+    size_t skip, length = format_header(b, header, sizeof(header), &skip);
+    channel_of(b, name);
+    int channel = channel_index(name, 0);
+    for (int i = 0; i < subscriber_slots; i++) {
+        struct subscriber *s = &subscribers[i];
+        if (s->fd < 0 || (s->channel != CHANNEL_ALL && (channel < 0 || s->channel != channel))) {
+            continue;
+        }
+        if (s->tail != s->head) {
+            enqueue(s, b);  // Les messages d'un abonné partent dans l'ordre
+            continue;
+        }
+        int status = send_one(s, b, header, length, skip);
+        if (status == 0) {
+            enqueue(s, b);
+        } else if (status < 0) {
+            remove_subscriber(s);
+        }
+    }
+    msgbuf_put(b);
+}
+
+/** @brief Accepte les abonnés en attente ; leur demande sera lue ensuite */
+static void accept_subscribers(void) {
+    int fd;
+    while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        pthread_mutex_lock(&lock);
+        int slot = 0;
+        while (slot < subscriber_slots && subscribers[slot].fd >= 0) {
+            slot++;
+        }
+        if (slot >= RELAY_SUBSCRIBERS_MAX) {
+            pthread_mutex_unlock(&lock);
+            const char *full = "erreur trop d'abonnés";
+            send(fd, full, strlen(full), MSG_NOSIGNAL | MSG_DONTWAIT);
+            close(fd);
+            continue;
+        }
+        struct subscriber *s = &subscribers[slot];
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        s->fd = fd;
+        s->pipe = -1;
+        s->channel = CHANNEL_PENDING;
+        s->pid = getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 ? cred.pid : 0;
+        s->waiting = 0;
+        s->head = s->tail = 0;
+        atomic_store_explicit(&s->sent, 0, memory_order_relaxed);
+        atomic_store_explicit(&s->dropped, 0, memory_order_relaxed);
+        if (slot == subscriber_slots) {
+            subscriber_slots++;
+        }
+        pthread_mutex_unlock(&lock);
+        atomic_fetch_add_explicit(&subscriber_count, 1, memory_order_relaxed);
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = slot};
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            remove_subscriber(s);
+        }
+    }
+}
+
+/** @brief Répond à un abonné */
+static void reply(struct subscriber *s, const char *text) {
+    send(s->fd, text, strlen(text), MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+/**
+ * @brief Choisit le transport d'un abonné parmi ceux qu'il propose
+ * @param offers Mots de la demande qui suivent le canal
+ * @return 0 en cas de succès, -1 sinon (raison écrite dans error)
+ *
+ * La connexion d'abonnement (unix) passe avant un tube : un paquet par
+ * message, sans ouverture supplémentaire.
+ */
+static int choose_transport(struct subscriber *s, char *offers, char **save, char *error, size_t size) {
+    int offered = 0, unix_ok = 0;
+    const char *fifo = NULL;
+    for (char *word = offers; word; word = strtok_r(NULL, " \t\r\n", save)) {
+        offered = 1;
+        if (strcmp(word, "unix") == 0) {
+            unix_ok = 1;
+        } else if (strncmp(word, "fifo:", 5) == 0 && word[5]) {
+            fifo = word + 5;
+        }
+    }
+    if (unix_ok || !offered) {
+        return 0;
+    }
+    if (!fifo) {
+        snprintf(error, size, "erreur aucun transport connu (unix, fifo:CHEMIN)");
+        return -1;
+    }
+    s->pipe = open(fifo, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (s->pipe < 0) {
+        snprintf(error, size, "erreur tube %s : %s", fifo, strerror(errno));
+        return -1;
+    }
+    struct epoll_event ev = {.events = 0, .data.u32 = (uint32_t)(s - subscribers) | ID_PIPE};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s->pipe, &ev);
+    return 0;
+}
+
+/**
+ * @brief Lit un paquet d'un abonné : sa demande d'abonnement, ou la fin
+ * de la connexion
+ *
+ * Les paquets qui suivent la demande sont ignorés. Une demande refusée
+ * reçoit sa raison, puis la connexion est fermée.
+ */
+static void read_request(struct subscriber *s) {
+    char request[256], answer[256];
+    ssize_t n;
+    while ((n = recv(s->fd, request, sizeof(request) - 1, 0)) > 0) {
+        if (s->channel != CHANNEL_PENDING) {
+            continue;
+        }
+        request[n] = '\0';
+        char *save;
+        char *name = strtok_r(request, " \t\r\n", &save);
+        int status = 0;
+        if (!name || strlen(name) >= RELAY_CHANNEL_MAX) {
+            snprintf(answer, sizeof(answer), "erreur canal invalide");
+            status = -1;
+        } else {
+            status = choose_transport(s, strtok_r(NULL, " \t\r\n", &save), &save, answer, sizeof(answer));
+        }
+        if (status == 0) {
+            pthread_mutex_lock(&lock);
+            s->channel = strcmp(name, RELAY_ALL_CHANNELS) == 0 ? CHANNEL_ALL : channel_index(name, 1);
+            pthread_mutex_unlock(&lock);
+            if (s->channel == CHANNEL_PENDING) {
+                snprintf(answer, sizeof(answer), "erreur trop de canaux");
+                status = -1;
+            } else {
+                snprintf(answer, sizeof(answer), "ok %s %s", name, s->pipe < 0 ? "unix" : "fifo");
+            }
+        }
+        reply(s, answer);
+        if (status != 0) {
+            remove_subscriber(s);
+            return;
+        }
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+        remove_subscriber(s);  // Abonné parti
+    }
+}
+
+/** @brief Relaie les messages publiés en attente */
+static void dispatch_published(void) {
+    struct message_buffer *b;
+    while ((b = msgbuf_queue_pop(&published)) != NULL) {
+        dispatch(b);
+    }
+}
+
+static void *relay_thread(void *arg) {
+    (void)arg;
+    placement_apply(PLACEMENT_RECEPTION, "relais");
+    sem_post(&ready);
+    struct epoll_event events[64];
+    while (!atomic_load(&stop_requested)) {
+        int n = epoll_wait(epoll_fd, events, 64, -1);
+        for (int i = 0; i < n; i++) {
+            uint32_t id = events[i].data.u32;
+            if (id == ID_WAKE) {
+                uint64_t count;
+                if (read(wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                    perror("Réveil du relais");
+                }
+                dispatch_published();
+                continue;
+            }
+            if (id == ID_LISTEN) {
+                accept_subscribers();
+                continue;
+            }
+            struct subscriber *s = &subscribers[id & ~ID_PIPE];
+            if (s->fd < 0) {
+                continue;  // Retiré plus tôt dans ce lot
+            }
+            if (id & ID_PIPE) {
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    remove_subscriber(s);  // Plus de lecteur sur le tube
+                } else {
+                    flush(s);
+                }
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                read_request(s);
+            }
+            if (s->fd >= 0 && (events[i].events & EPOLLOUT)) {
+                flush(s);
+            }
+        }
+    }
+
+    // Arrêt : derniers messages publiés, un dernier essai par abonné
+    dispatch_published();
+    for (int i = 0; i < subscriber_slots; i++) {
+        if (subscribers[i].fd >= 0) {
+            if (flush(&subscribers[i]) == 0) {
+                remove_subscriber(&subscribers[i]);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void remove_socket(void) {
+    if (socket_path[0]) {
+        unlink(socket_path);
+    }
+}
+
+/**
+ * @brief Ouvre la socket de relais et démarre le thread qui la sert
+ * @param path Chemin de la socket Unix
+ * @return 0 en cas de succès, -1 sinon (errno)
+ *
+ * Revient une fois le thread placé sur ses CPU (voir placement.h).
+ */
+int relay_start(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    for (int i = 0; i < RELAY_SUBSCRIBERS_MAX; i++) {
+        subscribers[i].fd = -1;
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 128) < 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    strcpy(socket_path, path);
+    atexit(remove_socket);
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listen_ev = {.events = EPOLLIN, .data.u32 = ID_LISTEN};
+    struct epoll_event wake_ev = {.events = EPOLLIN, .data.u32 = ID_WAKE};
+    if (wake_fd < 0 || epoll_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_ev) != 0 ||
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &wake_ev) != 0) {
+        return -1;
+    }
+
+    sem_init(&ready, 0, 0);
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    int err = pthread_create(&thread, NULL, relay_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    started = 1;
+    sem_wait(&ready);
+    return 0;
+}
+
+/**
+ * @brief Publie un message écrit dans le log
+ *
+ * Appelée par la boucle d'événements (seul producteur de la file) : le
+ * relais prend une référence sur le tampon. Sans relais, ne fait rien.
+ * Le thread du relais n'est réveillé que par relay_wake().
+ */
+void relay_publish(struct message_buffer *b) {
+    if (!started) {
+        return;
+    }
+    msgbuf_queue_push(&published, msgbuf_ref(b));
+    publish_pending = 1;
+}
+
+/** @brief Réveille le relais s'il a des messages publiés (une fois par lot) */
+void relay_wake(void) {
+    if (publish_pending) {
+        publish_pending = 0;
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {
+            perror("Réveil du relais");
+        }
+    }
+}
+
+/**
+ * @brief Arrête le relais
+ *
+ * À appeler une fois la boucle d'événements arrêtée : les messages déjà
+ * publiés sont relayés, chaque abonné reçoit ce qui peut partir sans
+ * attendre, puis les abonnements sont fermés et la socket supprimée.
+ */
+void relay_stop(void) {
+    if (!started) {
+        return;
+    }
+    atomic_store(&stop_requested, 1);
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        perror("Réveil du relais");
+    }
+    pthread_join(thread, NULL);
+    started = 0;
+    close(listen_fd);
+    close(wake_fd);
+    close(epoll_fd);
+    remove_socket();
+    socket_path[0] = '\0';
+}
+
+/** @brief Nombre d'abonnés connectés (jauge des métriques) */
+uint64_t relay_subscribers(void) {
+    return atomic_load_explicit(&subscriber_count, memory_order_relaxed);
+}
+
+/** @brief Liste les abonnés : canal, transport, file et compteurs */
+void relay_report(FILE *out) {
+    if (!started) {
+        fprintf(out, "Relais désactivé (option -l ou clé \"relais\")\n");
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    fprintf(out, "Relais %s : %llu abonnés, %d canaux\n", socket_path,
+            (unsigned long long)relay_subscribers(), channel_count);
+    for (int i = 0; i < subscriber_slots; i++) {
+        struct subscriber *s = &subscribers[i];
+        if (s->fd < 0) {
+            continue;
+        }
+        const char *channel = s->channel == CHANNEL_ALL ? RELAY_ALL_CHANNELS
+                              : s->channel == CHANNEL_PENDING ? "(demande)" : channels[s->channel];
+        fprintf(out, "PID %-7d canal %-16s %-5s en attente %-3u envoyés %-8llu perdus %llu\n", s->pid,
+                channel, s->pipe < 0 ? "unix" : "fifo", s->head - s->tail,
+                (unsigned long long)atomic_load_explicit(&s->sent, memory_order_relaxed),
+                (unsigned long long)atomic_load_explicit(&s->dropped, memory_order_relaxed));
+    }
+    pthread_mutex_unlock(&lock);
+}
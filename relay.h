@@ -0,0 +1,64 @@
+/**
+ * @file relay.h
+ * @brief Relais des messages reçus vers les clients abonnés à un canal
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un client s'abonne en se connectant à la socket de relais (SOCK_SEQPACKET)
+ * et en y envoyant un paquet "CANAL [TRANSPORT...]" :
+ * - CANAL : nom du canal, "*" pour tous les canaux ;
+ * - TRANSPORT : "unix" (la connexion d'abonnement elle-même) ou
+ *   "fifo:CHEMIN" (tube nommé ouvert en lecture par l'abonné). Le serveur
+ *   prend le plus rapide de ceux proposés, unix d'abord ; sans transport,
+ *   unix.
+ * Le serveur répond "ok CANAL TRANSPORT" ou "erreur RAISON". L'abonnement
+ * dure tant que la connexion reste ouverte.
+ *
+ * Un message commençant par "#canal " est publié sur ce canal (le préfixe
+ * n'est pas relayé), les autres sur RELAY_DEFAULT_CHANNEL. Chaque abonné
+ * reçoit "[canal] PID langue (confiance) : texte" : un paquet par message
+ * sur la socket, une ligne terminée par '\n' dans un tube.
+ *
+ * Le relais a son propre thread : l'étape du log lui passe une référence
+ * sur chaque tampon écrit, sans copie. Les envois ne bloquent jamais : un
+ * abonné qui ne lit pas assez vite garde des références dans sa file
+ * (RELAY_QUEUE au plus, les plus anciennes sont abandonnées quand elle est
+ * pleine) et sera servi quand son descripteur redeviendra prêt. Les autres
+ * abonnés ne l'attendent pas.
+ */
+
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "msgbuf.h"
+
+/** @brief Canal des messages sans préfixe "#canal " */
+#define RELAY_DEFAULT_CHANNEL "general"
+/** @brief Abonnement à tous les canaux */
+#define RELAY_ALL_CHANNELS "*"
+/** @brief Longueur maximale d'un nom de canal (terminateur compris) */
+#define RELAY_CHANNEL_MAX 32
+/** @brief Nombre maximal de canaux distincts */
+#define RELAY_CHANNELS_MAX 16
+/** @brief Nombre maximal d'abonnés */
+#define RELAY_SUBSCRIBERS_MAX 1024
+/**
+ * @brief Messages en attente par abonné (puissance de 2)
+ *
+ * Un abonné lent ne garde que les derniers messages de son canal : les
+ * tampons retenus par tous les abonnés sont au plus RELAY_QUEUE par canal
+ * (plus RELAY_QUEUE pour "*"), pris sur la réserve de la réception.
+ */
+#define RELAY_QUEUE 16
+
+int relay_start(const char *path);
+void relay_publish(struct message_buffer *b);
+void relay_wake(void);
+void relay_stop(void);
+uint64_t relay_subscribers(void);
+void relay_report(FILE *out);
+
+#endif
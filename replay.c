@@ -0,0 +1,271 @@
+/**
+ * @file replay.c
+ * @brief Rejeu d'une capture de signaux et génération de charge
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Usage: ./replay [-m | -x FACTEUR] [-n CLIENTS] FICHIER_CAPTURE PID
+ * - FICHIER_CAPTURE: fichier écrit par le serveur lancé avec -c (ou par la
+ *   commande de contrôle "capture")
+ * - PID: serveur à rejouer
+ * - -m: vitesse maximale (seule l'attente des ACK rythme l'envoi)
+ * - -x FACTEUR: rejeu FACTEUR fois plus rapide que l'original
+ * - -n CLIENTS: chaque client enregistré est simulé par CLIENTS processus
+ *
+ * Chaque client enregistré est rejoué par un processus fils qui envoie ses
+ * signaux dans l'ordre d'origine, à l'instant d'origine (ramené au début du
+ * rejeu) et avec les mêmes drapeaux sigqueue(). Comme un vrai client, il
+ * attend l'ACK de chaque bit avant le suivant et renvoie un bit refusé
+ * (PROTO_ACK_BUSY) après une pause. Tous les fils partent en même temps ;
+ * le bilan (signaux envoyés, refus, expirations, débit) est affiché à la
+ * fin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "capture.h"
+#include "protocole.h"
+
+/** @brief Nombre maximal de processus de rejeu */
+#define REPLAY_MAX_CLIENTS 1024
+/** @brief Délai laissé aux fils pour démarrer avant le premier envoi (µs) */
+#define REPLAY_START_DELAY_US 200000
+
+/** @brief Signal enregistré, avec son instant depuis le début de la capture */
+struct replay_event {
+    uint64_t at_us;
+    struct capture_record record;
+};
+
+/** @brief Bilan d'un processus de rejeu, partagé avec le parent */
+struct replay_stats {
+    _Atomic uint64_t sent;
+    _Atomic uint64_t busy;
+    _Atomic uint64_t timeouts;
+};
+
+static volatile sig_atomic_t ack_received = 0;
+static volatile sig_atomic_t ack_busy = 0;
+
+static void ack_handler(int signo, siginfo_t *info, void *context) {
+    (void)signo;
+    (void)context;
+    ack_busy = info->si_code == SI_QUEUE && (info->si_value.sival_int & PROTO_FLAG_CREDIT) &&
+               (info->si_value.sival_int & PROTO_ACK_BUSY);
+    ack_received = 1;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Charge une capture
+ * @return Nombre d'événements, -1 en cas d'erreur
+ */
+static long load(const char *path, struct replay_event **events) {
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return -1;
+    }
+    struct capture_header header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s : fichier de capture invalide\n", path);
+        fclose(in);
+        return -1;
+    }
+
+    long count = 0, capacity = 4096;
+    uint64_t at_us = 0;
+    struct capture_record record;
+    *events = malloc(capacity * sizeof(**events));
+    while (*events && fread(&record, sizeof(record), 1, in) == 1) {
+        if (count == capacity) {
+            capacity *= 2;
+            *events = realloc(*events, capacity * sizeof(**events));
+            if (!*events) {
+                break;
+            }
+        }
+        at_us += record.delta_us;
+        (*events)[count].at_us = at_us;
+        (*events)[count].record = record;
+        count++;
+    }
+    fclose(in);
+    if (!*events) {
+        fprintf(stderr, "Mémoire insuffisante\n");
+        return -1;
+    }
+    return count;
+}
+
+/** @brief Envoie un bit et attend son ACK, en renvoyant les bits refusés */
+static void send_bit(pid_t server, const struct capture_record *r, struct replay_stats *stats) {
+    int sig = r->type == CAPTURE_BIT1 ? SIGUSR1 : SIGUSR2;
+    unsigned pause_us = FLOW_PAUSE_MIN_US;
+    unsigned waited_us = 0;
+    while (1) {
+        ack_received = 0;
+        ack_busy = 0;
+        if (r->flags & CAPTURE_QUEUED) {
+            union sigval value = {.sival_int = r->flags & ~CAPTURE_QUEUED};
+            sigqueue(server, sig, value);
+        } else {
+            kill(server, sig);
+        }
+        atomic_fetch_add(&stats->sent, 1);
+
+        uint64_t deadline = now_us() + ACK_TIMEOUT_US;
+        while (!ack_received && now_us() < deadline) {
+            usleep(50);
+        }
+        if (!ack_received) {
+            atomic_fetch_add(&stats->timeouts, 1);
+            return;
+        }
+        if (!ack_busy || waited_us >= FLOW_WAIT_MAX_US) {
+            return;
+        }
+        atomic_fetch_add(&stats->busy, 1);
+        usleep(pause_us);
+        waited_us += pause_us;
+        pause_us = pause_us * 2 < FLOW_PAUSE_MAX_US ? pause_us * 2 : FLOW_PAUSE_MAX_US;
+    }
+}
+
+/**
+ * @brief Rejoue les signaux d'un client enregistré (processus fils)
+ * @param speed Facteur de vitesse, 0 pour la vitesse maximale
+ */
+static void replay_client(pid_t server, int32_t pid, const struct replay_event *events, long count,
+                          uint64_t start_us, double speed, struct replay_stats *stats) {
+    struct sigaction sa;
+    sa.sa_sigaction = ack_handler;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIG_ACK_RT, &sa, NULL);
+
+    uint64_t first_us = events[0].at_us;
+    for (long i = 0; i < count; i++) {
+        if (events[i].record.pid != pid) {
+            continue;
+        }
+        uint64_t due = speed > 0 ? start_us + (uint64_t)((events[i].at_us - first_us) / speed) : start_us;
+        uint64_t now = now_us();
+        if (due > now) {
+            usleep(due - now);
+        }
+        if (events[i].record.type == CAPTURE_END) {
+            kill(server, SIGQUIT);
+            atomic_fetch_add(&stats->sent, 1);
+        } else {
+            send_bit(server, &events[i].record, stats);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    double speed = 1.0;
+    int copies = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "mx:n:")) != -1) {
+        if (opt == 'm') {
+            speed = 0;
+        } else if (opt == 'x') {
+            speed = atof(optarg);
+        } else if (opt == 'n') {
+            copies = atoi(optarg);
+        } else {
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (argc - optind != 2 || copies < 1 || speed < 0) {
+        printf("Usage: %s [-m | -x FACTEUR] [-n CLIENTS] FICHIER_CAPTURE PID\n", argv[0]);
+        return 1;
+    }
+    pid_t server = atoi(argv[optind + 1]);
+
+    struct replay_event *events;
+    long count = load(argv[optind], &events);
+    if (count <= 0) {
+        if (count == 0) {
+            fprintf(stderr, "Capture vide\n");
+        }
+        return 1;
+    }
+
+    // Clients enregistrés, dans l'ordre de leur premier signal
+    int32_t pids[REPLAY_MAX_CLIENTS];
+    int client_count = 0;
+    for (long i = 0; i < count; i++) {
+        int known = 0;
+        for (int c = 0; c < client_count && !known; c++) {
+            known = pids[c] == events[i].record.pid;
+        }
+        if (!known && client_count < REPLAY_MAX_CLIENTS) {
+            pids[client_count++] = events[i].record.pid;
+        }
+    }
+    int processes = client_count * copies;
+    if (processes > REPLAY_MAX_CLIENTS) {
+        fprintf(stderr, "Trop de clients simulés (%d, maximum %d)\n", processes, REPLAY_MAX_CLIENTS);
+        return 1;
+    }
+
+    struct replay_stats *stats = mmap(NULL, processes * sizeof(*stats), PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (stats == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    if (speed > 0) {
+        printf("Rejeu de %ld signaux de %d clients (x%d) vers le serveur %d, vitesse x%g\n",
+               count, client_count, copies, server, speed);
+    } else {
+        printf("Rejeu de %ld signaux de %d clients (x%d) vers le serveur %d, vitesse maximale\n",
+               count, client_count, copies, server);
+    }
+
+    uint64_t start_us = now_us() + REPLAY_START_DELAY_US;
+    for (int p = 0; p < processes; p++) {
+        pid_t child = fork();
+        if (child < 0) {
+            perror("fork");
+            processes = p;
+            break;
+        }
+        if (child == 0) {
+            replay_client(server, pids[p % client_count], events, count, start_us, speed, &stats[p]);
+            _exit(0);
+        }
+    }
+    while (wait(NULL) > 0) {
+    }
+
+    double elapsed = (now_us() - start_us) / 1e6;
+    uint64_t sent = 0, busy = 0, timeouts = 0;
+    for (int p = 0; p < processes; p++) {
+        sent += stats[p].sent;
+        busy += stats[p].busy;
+        timeouts += stats[p].timeouts;
+    }
+    printf("%llu signaux envoyés en %.3f s (%.0f signaux/s), %llu refus, %llu expirations\n",
+           (unsigned long long)sent, elapsed, elapsed > 0 ? sent / elapsed : 0.0,
+           (unsigned long long)busy, (unsigned long long)timeouts);
+    return timeouts > 0;
+}
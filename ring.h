@@ -0,0 +1,79 @@
+/**
+ * @file ring.h
+ * @brief File circulaire sans verrou à un producteur et un consommateur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Le gestionnaire de signal du serveur (producteur) y dépose les signaux
+ * reçus, le thread de traitement (consommateur) les en retire. Seules des
+ * opérations atomiques sont utilisées côté producteur : l'ajout est
+ * utilisable depuis un gestionnaire de signal.
+ *
+ * Il ne doit y avoir qu'un seul producteur : les signaux concernés ne sont
+ * reçus que par un thread et sont masqués pendant l'exécution du
+ * gestionnaire.
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+/** @brief Signal reçu, tel que vu par le gestionnaire */
+struct signal_event {
+    uint64_t ns;        /**< Horodatage de réception (CLOCK_MONOTONIC) */
+    pid_t pid;          /**< si_pid */
+    int signo;          /**< Numéro du signal */
+    int code;           /**< si_code (SI_QUEUE si envoyé par sigqueue) */
+    int value;          /**< si_value.sival_int */
+};
+
+/** @brief Capacité de la file (puissance de 2) */
+#define SIGNAL_RING_SIZE 4096
+
+struct signal_ring {
+    alignas(64) _Atomic uint32_t head;   /**< Prochaine case écrite (producteur) */
+    alignas(64) _Atomic uint32_t tail;   /**< Prochaine case lue (consommateur) */
+    alignas(64) struct signal_event events[SIGNAL_RING_SIZE];
+};
+
+/**
+ * @brief Ajoute un événement (côté producteur)
+ * @return 1 en cas de succès, 0 si la file est pleine
+ */
+static inline int signal_ring_push(struct signal_ring *ring, const struct signal_event *ev) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == SIGNAL_RING_SIZE) {
+        return 0;
+    }
+    ring->events[head & (SIGNAL_RING_SIZE - 1)] = *ev;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief Retire un événement (côté consommateur)
+ * @return 1 si un événement a été lu, 0 si la file est vide
+ */
+static inline int signal_ring_pop(struct signal_ring *ring, struct signal_event *ev) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+        return 0;
+    }
+    *ev = ring->events[tail & (SIGNAL_RING_SIZE - 1)];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/** @brief Nombre d'événements en attente */
+static inline uint32_t signal_ring_depth(struct signal_ring *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+#endif
@@ -0,0 +1,326 @@
+/**
+ * @file scheduler.c
+ * @brief Ordonnancement équitable des signaux reçus
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Chaque client actif a une file de signaux en attente. Les clients ayant
+ * des signaux à traiter sont rangés dans la liste de leur voie (interactive
+ * ou masse) et servis à tour de rôle. Un client dont le seau est vide
+ * quitte la liste jusqu'à ce qu'un jeton soit disponible.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+
+#include "scheduler.h"
+#include "msgbuf.h"
+#include "metrics.h"
+
+/** @brief Signaux en attente d'un client */
+struct flow {
+    pid_t pid;                                  /**< 0 : case libre */
+    int lane;                                   /**< Voie de la liste où attend le client */
+    struct signal_event queue[SCHED_FLOW_QUEUE];
+    unsigned head;                              /**< Prochain signal servi */
+    unsigned count;                             /**< Signaux en attente */
+    unsigned deficit;                           /**< Signaux restant à servir dans ce tour */
+    double tokens;                              /**< Jetons du seau */
+    uint64_t refill_ns;                         /**< Dernier remplissage du seau */
+    int held;                                   /**< Hors liste, en attente d'un jeton */
+    int next;                                   /**< Client suivant dans la liste (-1 : aucun) */
+};
+
+/** @brief Liste des clients à servir d'une voie */
+struct flow_list {
+    int head;
+    int tail;
+};
+
+static struct flow flows[SCHED_FLOWS_MAX];
+static struct flow_list lists[LANE_COUNT] = {{-1, -1}, {-1, -1}};
+/** @brief Clients retenus faute de jeton */
+static int held_count = 0;
+/** @brief Premier instant où un client retenu peut être servi */
+static uint64_t held_wakeup_ns = 0;
+/** @brief Signaux en attente, tous clients confondus */
+static _Atomic uint64_t pending = 0;
+
+// Réglages, modifiés par la commande de contrôle
+static _Atomic unsigned limit_rate = SCHED_RATE;
+static _Atomic unsigned limit_burst = SCHED_BURST;
+static _Atomic unsigned limit_quantum = SCHED_QUANTUM;
+
+static void list_push(int lane, int index) {
+    struct flow_list *l = &lists[lane];
+    flows[index].next = -1;
+    flows[index].lane = lane;
+    if (l->tail < 0) {
+        l->head = index;
+    } else {
+        flows[l->tail].next = index;
+    }
+    l->tail = index;
+}
+
+static int list_pop(int lane) {
+    struct flow_list *l = &lists[lane];
+    int index = l->head;
+    if (index >= 0) {
+        l->head = flows[index].next;
+        if (l->head < 0) {
+            l->tail = -1;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief Remplit le seau d'un client jusqu'à l'instant donné
+ * @return Les jetons disponibles
+ */
+static double refill(struct flow *f, uint64_t now_ns, unsigned rate, unsigned burst) {
+    if (now_ns > f->refill_ns) {
+        f->tokens += (double)(now_ns - f->refill_ns) * rate / 1e9;
+        f->refill_ns = now_ns;
+    }
+    if (f->tokens > burst) {
+        f->tokens = burst;
+    }
+    return f->tokens;
+}
+
+/** @brief Instant où le seau d'un client aura de nouveau un jeton */
+static uint64_t token_ready_ns(const struct flow *f, unsigned rate) {
+    return f->refill_ns + (uint64_t)((1.0 - f->tokens) * 1e9 / rate) + 1;
+}
+
+/**
+ * @brief Indique si la case d'un client peut être réutilisée
+ *
+ * Un client sans signal en attente et dont le seau serait plein n'a plus
+ * d'état utile : l'oublier ne lui donne aucun jeton de plus.
+ */
+static int flow_idle(struct flow *f, uint64_t now_ns) {
+    if (f->count > 0) {
+        return 0;
+    }
+    unsigned rate = atomic_load_explicit(&limit_rate, memory_order_relaxed);
+    unsigned burst = atomic_load_explicit(&limit_burst, memory_order_relaxed);
+    return rate == 0 || refill(f, now_ns, rate, burst) >= burst;
+}
+
+/**
+ * @brief Cherche la file d'un client, ou en crée une
+ * @return La file, ou NULL si la table est pleine
+ *
+ * Même adressage que session_find() ; une case libre ou inactive est
+ * reprise.
+ */
+static struct flow *flow_find(pid_t pid, uint64_t now_ns) {
+    struct flow *free_slot = NULL;
+    for (int i = 0; i < SCHED_FLOWS_MAX; i++) {
+        struct flow *f = &flows[(unsigned)(pid + i) % SCHED_FLOWS_MAX];
+        if (f->pid == pid) {
+            return f;
+        }
+        if (!free_slot && (f->pid == 0 || flow_idle(f, now_ns))) {
+            free_slot = f;
+        }
+    }
+    if (free_slot) {
+        free_slot->pid = pid;
+        free_slot->head = 0;
+        free_slot->count = 0;
+        free_slot->deficit = 0;
+        free_slot->tokens = atomic_load_explicit(&limit_burst, memory_order_relaxed);
+        free_slot->refill_ns = now_ns;
+        free_slot->held = 0;
+    }
+    return free_slot;
+}
+
+/**
+ * @brief Met un signal en attente dans la file de son client
+ * @param lane Voie du client (LANE_INTERACTIVE ou LANE_BULK)
+ * @return 0 si le signal est en attente, 1 si la table des clients est
+ * pleine (le signal est à traiter tout de suite), -1 si la file du client
+ * est pleine
+ *
+ * La voie d'un client est fixée quand il devient actif.
+ */
+int sched_enqueue(const struct signal_event *ev, int lane) {
+    struct flow *f = flow_find(ev->pid, ev->ns);
+    if (!f) {
+        return 1;
+    }
+    if (f->count == SCHED_FLOW_QUEUE) {
+        return -1;
+    }
+    f->queue[(f->head + f->count) % SCHED_FLOW_QUEUE] = *ev;
+    if (f->count++ == 0 && !f->held) {
+        f->deficit = 0;
+        list_push(lane, f - flows);
+    }
+    atomic_fetch_add_explicit(&pending, 1, memory_order_relaxed);
+    return 0;
+}
+
+/** @brief Remet dans leur liste les clients retenus qui ont un jeton */
+static void release_held(uint64_t now_ns, unsigned rate, unsigned burst) {
+    uint64_t wakeup = 0;
+    for (int i = 0; i < SCHED_FLOWS_MAX && held_count > 0; i++) {
+        struct flow *f = &flows[i];
+        if (!f->held) {
+            continue;
+        }
+        if (rate == 0 || refill(f, now_ns, rate, burst) >= 1.0) {
+            f->held = 0;
+            held_count--;
+            list_push(f->lane, i);
+        } else {
+            uint64_t ready = token_ready_ns(f, rate);
+            if (wakeup == 0 || ready < wakeup) {
+                wakeup = ready;
+            }
+        }
+    }
+    held_wakeup_ns = wakeup;
+}
+
+/**
+ * @brief Choisit le prochain signal à traiter
+ * @param now_ns Instant présent (CLOCK_MONOTONIC)
+ * @param ev Signal choisi
+ * @return 1 si un signal a été choisi, 0 si aucun ne peut l'être
+ *
+ * Tourniquet à déficit : le client en tête de liste reçoit "quantum"
+ * signaux par tour, puis passe en fin de liste. La voie interactive est
+ * toujours servie avant la voie de masse. Un bit consomme un jeton ; la fin
+ * de message n'en consomme pas, pour ne pas retenir un tampon complet.
+ */
+int sched_next(uint64_t now_ns, struct signal_event *ev) {
+    unsigned rate = atomic_load_explicit(&limit_rate, memory_order_relaxed);
+    unsigned burst = atomic_load_explicit(&limit_burst, memory_order_relaxed);
+    if (held_count > 0 && (rate == 0 || now_ns >= held_wakeup_ns)) {
+        release_held(now_ns, rate, burst);
+    }
+
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        int index;
+        while ((index = lists[lane].head) >= 0) {
+            struct flow *f = &flows[index];
+            if (f->deficit == 0) {
+                f->deficit = atomic_load_explicit(&limit_quantum, memory_order_relaxed);
+            }
+
+            struct signal_event *head = &f->queue[f->head];
+            if (head->signo != SIGQUIT && rate > 0) {
+                if (refill(f, now_ns, rate, burst) < 1.0) {
+                    // Seau vide : le client attend hors de la liste
+                    list_pop(lane);
+                    f->held = 1;
+                    held_count++;
+                    uint64_t ready = token_ready_ns(f, rate);
+                    if (held_count == 1 || ready < held_wakeup_ns) {
+                        held_wakeup_ns = ready;
+                    }
+                    metrics_inc(METRIC_RATE_LIMITED);
+                    continue;
+                }
+                f->tokens -= 1.0;
+            }
+
+            *ev = *head;
+            f->head = (f->head + 1) % SCHED_FLOW_QUEUE;
+            f->count--;
+            f->deficit--;
+            atomic_fetch_sub_explicit(&pending, 1, memory_order_relaxed);
+            if (f->count == 0 || f->deficit == 0) {
+                list_pop(lane);
+                if (f->count > 0) {
+                    list_push(lane, index);
+                } else {
+                    f->deficit = 0;
+                }
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Instant où un client retenu pourra être servi
+ * @return L'instant (CLOCK_MONOTONIC), ou 0 si aucun client n'est retenu
+ */
+uint64_t sched_wakeup_ns(void) {
+    return held_count > 0 ? held_wakeup_ns : 0;
+}
+
+/** @brief Signaux en attente dans les files des clients */
+uint64_t sched_pending(void) {
+    return atomic_load_explicit(&pending, memory_order_relaxed);
+}
+
+/** @brief Les limites sont acceptables par sched_set_limit() */
+int sched_limit_valid(unsigned rate, unsigned burst, unsigned quantum) {
+    return (rate == 0 || rate >= SCHED_RATE_MIN) && burst > 0 && quantum > 0;
+}
+
+/**
+ * @brief Change les limites appliquées à chaque client
+ * @param rate Signaux par seconde (0 : sans limite)
+ * @param burst Jetons du seau plein
+ * @param quantum Signaux servis par tour
+ * @return 0 en cas de succès, -1 si une valeur est invalide
+ */
+int sched_set_limit(unsigned rate, unsigned burst, unsigned quantum) {
+    if (!sched_limit_valid(rate, burst, quantum)) {
+        return -1;
+    }
+    atomic_store_explicit(&limit_burst, burst, memory_order_relaxed);
+    atomic_store_explicit(&limit_quantum, quantum, memory_order_relaxed);
+    atomic_store_explicit(&limit_rate, rate, memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * @brief Commande de contrôle "limit [DÉBIT [RAFALE [QUANTUM]]]"
+ *
+ * Sans argument, affiche les limites. Les valeurs omises sont gardées.
+ * Les nouvelles limites s'appliquent au signal suivant ; un client retenu
+ * est réexaminé à son réveil.
+ */
+void sched_command(int argc, char *argv[], FILE *reply) {
+    unsigned rate = atomic_load_explicit(&limit_rate, memory_order_relaxed);
+    unsigned burst = atomic_load_explicit(&limit_burst, memory_order_relaxed);
+    unsigned quantum = atomic_load_explicit(&limit_quantum, memory_order_relaxed);
+    if (argc > 1) {
+        char *end;
+        unsigned long values[3] = {rate, burst, quantum};
+        for (int i = 1; i < argc && i <= 3; i++) {
+            values[i - 1] = strtoul(argv[i], &end, 10);
+            if (*end != '\0' || end == argv[i]) {
+                fprintf(reply, "Erreur: valeur invalide : %s\n", argv[i]);
+                return;
+            }
+        }
+        if (sched_set_limit(values[0], values[1], values[2]) != 0) {
+            fprintf(reply, "Erreur: débit minimal %d signaux/s, rafale et quantum non nuls\n", SCHED_RATE_MIN);
+            return;
+        }
+        rate = values[0];
+        burst = values[1];
+        quantum = values[2];
+    }
+    if (rate == 0) {
+        fprintf(reply, "Débit par client : sans limite\n");
+    } else {
+        fprintf(reply, "Débit par client : %u signaux/s (rafale %u)\n", rate, burst);
+    }
+    fprintf(reply, "Quantum : %u signaux par tour\n", quantum);
+    fprintf(reply, "Signaux en attente : %llu\n", (unsigned long long)sched_pending());
+}
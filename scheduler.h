@@ -0,0 +1,54 @@
+/**
+ * @file scheduler.h
+ * @brief Ordonnancement équitable des signaux reçus
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Les signaux sortis de la file du gestionnaire sont rangés par client
+ * (si_pid) puis servis par tourniquet à déficit (DRR) : à chaque tour, un
+ * client peut faire traiter jusqu'à "quantum" signaux, les clients
+ * interactifs passant avant les envois de masse. Un client rapide ne
+ * retarde donc les autres que d'un quantum.
+ *
+ * Chaque client a en plus un seau à jetons : un bit n'est traité (et
+ * acquitté) que s'il reste un jeton ; sinon il attend dans la file du
+ * client, et le client, qui attend l'ACK, est ralenti au débit fixé. Les
+ * limites se règlent à chaud par la commande de contrôle "limit".
+ *
+ * Utilisé uniquement par la boucle d'événements (sauf la commande de
+ * contrôle, qui ne touche qu'aux réglages).
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ring.h"
+
+/** @brief Nombre maximal de clients suivis */
+#define SCHED_FLOWS_MAX 256
+/** @brief Signaux en attente par client */
+#define SCHED_FLOW_QUEUE 64
+/** @brief Signaux servis par client et par tour, par défaut */
+#define SCHED_QUANTUM 8
+/** @brief Débit par client par défaut (signaux/s, 0 : sans limite) */
+#define SCHED_RATE 0
+/** @brief Rafale par défaut (jetons du seau plein) */
+#define SCHED_BURST 64
+/**
+ * @brief Débit minimal accepté : un bit retenu doit être acquitté avant
+ * que le client n'abandonne (ACK_TIMEOUT_US)
+ */
+#define SCHED_RATE_MIN 20
+
+int sched_enqueue(const struct signal_event *ev, int lane);
+int sched_next(uint64_t now_ns, struct signal_event *ev);
+uint64_t sched_wakeup_ns(void);
+uint64_t sched_pending(void);
+int sched_limit_valid(unsigned rate, unsigned burst, unsigned quantum);
+int sched_set_limit(unsigned rate, unsigned burst, unsigned quantum);
+void sched_command(int argc, char *argv[], FILE *reply);
+
+#endif
@@ -0,0 +1,318 @@
+/**
+ * @file search.c
+ * @brief Recherche plein texte dans le log du serveur
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Usage: ./search [-c] [-n MAX] LOG TERME... [OU TERME...]...
+ *        ./search -b LOG
+ * - LOG: segment de log (server_log.txt, server_log.N.txt) ; son index
+ *   (server_log.idx, server_log.N.idx) est écrit par le serveur
+ * - Les termes consécutifs doivent tous être présents (ET) ; OU sépare
+ *   des alternatives. "term*" accepte tous les termes commençant par term
+ * - -c: affiche seulement le nombre de messages trouvés
+ * - -n MAX: affiche au plus MAX messages (les plus récents)
+ * - -b: reconstruit l'index à partir du log (log écrit avant l'index, ou
+ *   index perdu) ; à lancer serveur arrêté
+ *
+ * Exemple : ./search server_log.txt bonjour monde OU salut*
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "index.h"
+
+/** @brief Séparateur des lignes de message dans le log */
+#define RECORD_MARKER "Message complet reçu : "
+/** @brief Nombre maximal de termes d'une requête */
+#define SEARCH_MAX_TERMS 64
+
+/** @brief Liste de positions triée */
+struct offsets {
+    uint64_t *items;
+    size_t count;
+};
+
+/** @brief Log projeté en mémoire */
+struct log_map {
+    const char *data;
+    size_t size;
+};
+
+static int map_log(const char *path, struct log_map *log) {
+    log->data = NULL;
+    log->size = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        log->data = data;
+        log->size = st.st_size;
+    }
+    close(fd);
+    return 0;
+}
+
+/**
+ * @brief Indique si une ligne commence un message
+ * @param text Position du texte du message, si c'en est un
+ */
+static int is_record(const char *line, const char *end, const char **text) {
+    if (line >= end || *line != '[') {
+        return 0;
+    }
+    const char *eol = memchr(line, '\n', end - line);
+    if (!eol) {
+        eol = end;
+    }
+    size_t marker = strlen(RECORD_MARKER);
+    for (const char *p = line; p + marker <= eol; p++) {
+        if (*p == RECORD_MARKER[0] && memcmp(p, RECORD_MARKER, marker) == 0) {
+            *text = p + marker;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** @brief Fin d'un message : début du message suivant ou fin du log */
+static const char *record_end(const char *text, const char *end) {
+    const char *p = text;
+    const char *ignored;
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        p++;
+        if (is_record(p, end, &ignored)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+/**
+ * @brief Reconstruit l'index d'un log
+ * @return 0 en cas de succès, -1 sinon
+ */
+static int rebuild(const char *log_path) {
+    struct log_map log;
+    if (map_log(log_path, &log) != 0) {
+        perror(log_path);
+        return -1;
+    }
+    char path[256];
+    index_path_for(log_path, path, sizeof(path));
+    if (truncate(path, 0) != 0 && errno != ENOENT) {
+        perror(path);
+        return -1;
+    }
+    struct index_writer w;
+    if (index_writer_open(&w, path) != 0) {
+        perror(path);
+        return -1;
+    }
+    const char *end = log.data + log.size;
+    const char *line = log.data;
+    const char *text;
+    uint64_t count = 0;
+    while (line && line < end) {
+        if (is_record(line, end, &text)) {
+            const char *next = record_end(text, end);
+            size_t length = next - text;
+            if (length > 0 && text[length - 1] == '\n') {
+                length--;
+            }
+            index_writer_add(&w, line - log.data, text, length);
+            count++;
+            line = next;
+        } else {
+            line = memchr(line, '\n', end - line);
+            line = line ? line + 1 : NULL;
+        }
+    }
+    index_writer_close(&w);
+    printf("%llu messages indexés dans %s\n", (unsigned long long)count, path);
+    return 0;
+}
+
+/** @brief Intersection de deux listes triées, dans a */
+static void intersect(struct offsets *a, const struct offsets *b) {
+    size_t i = 0, j = 0, n = 0;
+    while (i < a->count && j < b->count) {
+        if (a->items[i] < b->items[j]) {
+            i++;
+        } else if (a->items[i] > b->items[j]) {
+            j++;
+        } else {
+            a->items[n++] = a->items[i];
+            i++;
+            j++;
+        }
+    }
+    a->count = n;
+}
+
+/** @brief Union de deux listes triées, dans a */
+static void unite(struct offsets *a, const struct offsets *b) {
+    if (b->count == 0) {
+        return;
+    }
+    uint64_t *items = malloc((a->count + b->count) * sizeof(*items));
+    if (!items) {
+        return;
+    }
+    size_t i = 0, j = 0, n = 0;
+    while (i < a->count || j < b->count) {
+        if (j == b->count || (i < a->count && a->items[i] < b->items[j])) {
+            items[n++] = a->items[i++];
+        } else if (i == a->count || b->items[j] < a->items[i]) {
+            items[n++] = b->items[j++];
+        } else {
+            items[n++] = a->items[i++];
+            j++;
+        }
+    }
+    free(a->items);
+    a->items = items;
+    a->count = n;
+}
+
+/**
+ * @brief Messages contenant tous les termes d'une alternative
+ *
+ * Les listes sont croisées de la plus courte à la plus longue.
+ */
+static struct offsets match_all(const struct index_reader *r, char **terms, int count) {
+    struct offsets lists[SEARCH_MAX_TERMS];
+    int n = 0;
+    for (int i = 0; i < count && n < SEARCH_MAX_TERMS; i++) {
+        // Terme normalisé comme à l'indexation
+        char term[INDEX_TERM_MAX + 1];
+        size_t pos = 0;
+        size_t length = strlen(terms[i]);
+        int prefix = length > 0 && terms[i][length - 1] == '*';
+        size_t term_length = index_next_term(terms[i], length - prefix, &pos, term);
+        if (term_length == 0) {
+            continue;  // Trop court : ignoré, comme à l'indexation
+        }
+        term[term_length] = '\0';
+        lists[n].count = index_lookup(r, term, prefix, &lists[n].items);
+        n++;
+    }
+
+    struct offsets result = {NULL, 0};
+    if (n == 0) {
+        return result;
+    }
+    int shortest = 0;
+    for (int i = 1; i < n; i++) {
+        if (lists[i].count < lists[shortest].count) {
+            shortest = i;
+        }
+    }
+    result = lists[shortest];
+    for (int i = 0; i < n; i++) {
+        if (i != shortest) {
+            intersect(&result, &lists[i]);
+            free(lists[i].items);
+        }
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    int count_only = 0, build = 0;
+    long max = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "bcn:")) != -1) {
+        if (opt == 'b') {
+            build = 1;
+        } else if (opt == 'c') {
+            count_only = 1;
+        } else if (opt == 'n') {
+            max = atol(optarg);
+        } else {
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind >= argc || (build && argc - optind != 1) || (!build && argc - optind < 2)) {
+        printf("Usage: %s [-c] [-n MAX] LOG TERME... [OU TERME...]...\n", argv[0]);
+        printf("       %s -b LOG\n", argv[0]);
+        return 1;
+    }
+    const char *log_path = argv[optind];
+    if (build) {
+        return rebuild(log_path) == 0 ? 0 : 1;
+    }
+
+    char path[256];
+    index_path_for(log_path, path, sizeof(path));
+    struct index_reader r;
+    if (index_reader_open(&r, path) != 0) {
+        perror(path);
+        fprintf(stderr, "Index absent : le reconstruire avec %s -b %s\n", argv[0], log_path);
+        return 1;
+    }
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct offsets found = {NULL, 0};
+    int first = optind + 1;
+    for (int i = first; i <= argc; i++) {
+        if (i < argc && strcmp(argv[i], "OU") != 0) {
+            continue;
+        }
+        if (i > first) {
+            struct offsets group = match_all(&r, &argv[first], i - first);
+            unite(&found, &group);
+            free(group.items);
+        }
+        first = i + 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double elapsed_ms = (stop.tv_sec - start.tv_sec) * 1e3 + (stop.tv_nsec - start.tv_nsec) / 1e6;
+
+    if (!count_only && found.count > 0) {
+        struct log_map log;
+        if (map_log(log_path, &log) != 0) {
+            perror(log_path);
+            return 1;
+        }
+        size_t from = max >= 0 && (size_t)max < found.count ? found.count - max : 0;
+        const char *end = log.data + log.size;
+        for (size_t i = from; i < found.count; i++) {
+            const char *line = log.data + found.items[i];
+            const char *text;
+            if (found.items[i] >= log.size || !is_record(line, end, &text)) {
+                continue;  // Index d'un autre log
+            }
+            const char *next = record_end(text, end);
+            fwrite(line, 1, next - line, stdout);
+            if (next[-1] != '\n') {
+                putchar('\n');
+            }
+        }
+    }
+    printf("%zu messages trouvés (recherche : %.3f ms)\n", found.count, elapsed_ms);
+    free(found.items);
+    index_reader_close(&r);
+    return 0;
+}
@@ -8,281 +8,997 @@
  * et détermine la langue probable du message reçu en analysant la fréquence des lettres.
  */
 
+#define _GNU_SOURCE
 #include <signal.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
-
-// Alphabet
-char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-/** @brief Tableau des langues supportées */
-char *languages[] = {"Français", "Anglais", "Allemand", "Espagnol"};
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+
+#include "langue.h"
+#include "protocole.h"
+#include "metrics.h"
+#include "trace.h"
+#include "control.h"
+#include "history.h"
+#include "shards.h"
+#include "supervisor.h"
+#include "langue_cache.h"
+#include "transport.h"
+#include "msgbuf.h"
+#include "capture.h"
+#include "index.h"
+#include "scheduler.h"
+#include "config.h"
+#include "placement.h"
+#include "session.h"
+#include "journal.h"
+#include "relay.h"
 
 // def du fichier Log  
 #define LOG_FILE "server_log.txt"  
 
+/** @brief Fichier de métriques réécrit périodiquement (format Prometheus) */
+#define METRICS_FILE "server_metrics.prom"
+/** @brief Période de réécriture du fichier de métriques */
+#define METRICS_INTERVAL_MS 1000
+/** @brief Nombre de messages de l'historique affichés par défaut au démarrage */
+#define HISTORY_TAIL 20
+/** @brief Taille du cache des langues détectées */
+#define LANGUE_CACHE_BYTES (64 * 1024)
+/** @brief Délai sans message après lequel l'index écrit son bloc en cours */
+#define INDEX_IDLE_MS 1000
+/** @brief Arrêt : délai laissé aux envois et messages en cours */
+#define DRAIN_TIMEOUT_MS 5000
+/** @brief Arrêt : période de vérification de la fin des envois */
+#define DRAIN_POLL_US 10000
 
+FILE *log_file;
+/** @brief Fichier de log de ce processus (un segment par worker) */
+char log_path[CONFIG_PATH_MAX + 16] = LOG_FILE;
+/** @brief Ensemble des segments fusionnés à la relecture */
+static char log_segments[CONFIG_PATH_MAX + 16] = "server_log*.txt";
+/** @brief Taille du log, lignes du lot en cours comprises (boucle d'événements) */
+static uint64_t log_offset;
 
 /**
- * @brief Tableau des fréquences d'apparition des lettres pour chaque langue
- * Source : https://fr.wikipedia.org/wiki/Fr%C3%A9quence_d%27apparition_des_lettres
+ * @brief Réglages : valeurs par défaut, remplacées par le fichier de
+ * configuration puis par les options de la ligne de commande
  */
-double probabilities[4][26] = {
-    // Français
-    {7.64, 0.90, 3.26, 3.67, 14.72, 1.06, 0.87, 0.74, 7.53, 0.61, 0.05, 5.45, 2.96, 7.09, 5.28, 3.02, 1.29, 6.69, 7.95, 7.24, 6.31, 1.83, 0.04, 0.42, 0.19, 0.21},
-    // Anglais
-    {8.17, 1.49, 2.78, 4.25, 12.70, 2.23, 2.02, 6.09, 6.97, 0.15, 0.77, 4.03, 2.41, 6.75, 7.51, 1.93, 0.10, 5.99, 6.33, 9.06, 2.76, 0.98, 2.36, 0.15, 1.97, 0.07},
-    // Allemand
-    {6.51, 1.89, 2.73, 5.08, 16.40, 1.66, 3.01, 4.57, 7.55, 0.27, 1.42, 3.44, 2.53, 9.78, 2.51, 0.79, 0.02, 7.00, 7.27, 6.15, 4.35, 0.67, 1.89, 0.03, 0.04, 1.13},
-    // Espagnol
-    {12.53, 1.42, 4.68, 5.86, 13.68, 0.69, 1.01, 0.70, 6.25, 0.44, 0.01, 4.97, 3.15, 6.71, 8.68, 2.51, 0.88, 6.87, 7.98, 4.63, 3.93, 0.90, 0.01, 0.22, 0.90, 0.52}
+static struct config settings = {
+    .log = LOG_FILE,
+    .metrics = METRICS_FILE,
+    .metrics_interval_ms = METRICS_INTERVAL_MS,
+    .shards = "",
+    .loop = "io_uring",
+    .history = HISTORY_TAIL,
+    .pool = MSGBUF_POOL_SIZE,
+    .cache_bytes = LANGUE_CACHE_BYTES,
+    .bulk_ack_delay_us = SIGNAL_BULK_ACK_DELAY_US,
+    .index_idle_ms = INDEX_IDLE_MS,
+    .rate = SCHED_RATE,
+    .burst = SCHED_BURST,
+    .quantum = SCHED_QUANTUM,
+    .journal = JOURNAL_FILE,
+    .drain_timeout_ms = DRAIN_TIMEOUT_MS,
 };
+/** @brief Fichier de configuration, relu par la commande "reload" */
+static char config_path[CONFIG_PATH_MAX] = CONFIG_FILE;
+/** @brief Délai sans message avant l'écriture du bloc d'index, réglable à chaud */
+static _Atomic unsigned index_idle_ms = INDEX_IDLE_MS;
+/** @brief Délai laissé aux envois en cours à l'arrêt, réglable à chaud */
+static _Atomic unsigned drain_timeout_ms = DRAIN_TIMEOUT_MS;
+/** @brief Arrêt demandé par SIGTERM ou SIGINT */
+static volatile sig_atomic_t stop_requested = 0;
 
 /**
- * @brief Structure pour stocker les mots caractéristiques de chaque langue
+ * @brief Chemin dérivé d'un autre (log, métriques)
+ * @param extension Extension du fichier (".txt", ".prom")
+ * @param suffix Inséré avant l'extension : ".N" pour le segment du worker
+ * N, "*" pour l'ensemble des segments
  */
-struct LanguageKeywords {
-    const char* lang;
-    const char* keywords[10];
-};
+static void path_variant(const char *base, const char *extension, const char *suffix, char *path,
+                         size_t size) {
+    size_t length = strlen(base), ext = strlen(extension);
+    if (length > ext && strcmp(base + length - ext, extension) == 0) {
+        snprintf(path, size, "%.*s%s%s", (int)(length - ext), base, suffix, extension);
+    } else {
+        snprintf(path, size, "%s%s", base, suffix);
+    }
+}
 
 /**
- * @brief Mots caractéristiques pour chaque langue
+ * @brief Processus vivant, autre que celui-ci, publié dans un fichier de
+ * découverte
+ * @return Son PID, 0 si le fichier ne liste que ce processus, -1 s'il
+ * n'existe pas ou ne liste que des processus disparus
  */
-struct LanguageKeywords keywords[] = {
-    {"Français", {"le", "la", "les", "un", "une", "des", "est", "et", "en", "dans"}},
-    {"Anglais", {"the", "is", "are", "and", "to", "of", "in", "for", "with", "on"}},
-    {"Allemand", {"der", "die", "das", "und", "ist", "in", "den", "von", "zu", "für"}},
-    {"Espagnol", {"el", "la", "los", "las", "un", "una", "es", "en", "de", "por"}}
-};
+static pid_t shards_owner(const char *path) {
+    struct shard_map map;
+    if (shards_read(path, &map) <= 0) {
+        return -1;
+    }
+    int self = 0;
+    for (int i = 0; i < map.count; i++) {
+        if (map.pids[i] == getpid()) {
+            self = 1;
+        } else if (map.pids[i] > 0 && (kill(map.pids[i], 0) == 0 || errno == EPERM)) {
+            return map.pids[i];
+        }
+    }
+    return self ? 0 : -1;
+}
 
 /**
- * @brief Vérifie si un mot est présent dans le message
+ * @brief Ouvre le log du processus
  */
-int contains_word(const char* message, const char* word) {
-    char* msg_lower = strdup(message);
-    char* word_lower = strdup(word);
-    
-    // Convertir en minuscules
-    for(int i = 0; msg_lower[i]; i++) {
-        msg_lower[i] = tolower(msg_lower[i]);
-    }
-    for(int i = 0; word_lower[i]; i++) {
-        word_lower[i] = tolower(word_lower[i]);
-    }
-    
-    int result = strstr(msg_lower, word_lower) != NULL;
-    free(msg_lower);
-    free(word_lower);
-    return result;
+void open_log(void) {
+    log_file = fopen(log_path, "a+");  // Ouvre le fichier en lecture et écriture
+    if (!log_file) {
+        perror("Erreur lors de l'ouverture du fichier log");
+        exit(EXIT_FAILURE);
+    }
+    fseeko(log_file, 0, SEEK_END);
+    log_offset = ftello(log_file);
+    transport_log_open(fileno(log_file));
 }
 
 /**
- * @brief Détermine la langue probable d'un message
- * @param message Le message à analyser
- * @return Un pointeur vers la chaîne contenant le nom de la langue
+ * @brief Affiche les derniers messages de tous les segments
  *
- * Cette fonction analyse la fréquence des lettres dans le message
- * et la compare aux fréquences connues de différentes langues
- * pour déterminer la langue la plus probable.
+ * Seule la fin des segments est lue : le temps d'affichage ne dépend pas
+ * de la taille du log. Peut servir de corps de thread (option -a).
  */
-char* getlangue(char *message) {
-    double min_diff = 999999;
-    int index = 0;
-    int len = 0;
-    int letter_count[26] = {0};
-    double scores[4] = {0}; // Scores pour chaque langue
-
-    // Compter les lettres
-    for(int i = 0; message[i] != '\0'; i++) {
-        char c = message[i];
-        if(c >= 'a' && c <= 'z') {
-            letter_count[c - 'a']++;
-            len++;
-        } else if(c >= 'A' && c <= 'Z') {
-            letter_count[c - 'A']++;
-            len++;
+void *load_previous_messages(void *arg) {
+    (void)arg;
+    if (settings.history == 0) {
+        return NULL;
+    }
+    if (settings.history < 0) {
+        printf("Messages précédents :\n");
+        history_print(log_segments, stdout);
+    } else {
+        printf("Derniers messages (%d au plus) :\n", settings.history);
+        history_print_tail(log_segments, settings.history, stdout);
+    }
+    printf("\n");
+    fflush(stdout);
+    return NULL;
+}
+
+
+
+/**
+ * @brief Ajoute un message au log avec sa langue et la confiance associée
+ *
+ * Seul le début de la ligne est formaté ; les octets du message sont écrits
+ * directement depuis son tampon. La boucle d'événements écrit en une fois
+ * (suivie d'un fdatasync) toutes les lignes d'un même lot d'événements.
+ * La position de la ligne dans le log est notée dans le tampon pour l'index.
+ */
+void save_message(struct message_buffer *b) {
+    if (log_file) {
+        // Ajouter l'horodatage
+        time_t now = time(NULL);
+        struct tm *local_time = localtime(&now);
+        char timestamp[20];
+        strftime(timestamp, sizeof(timestamp), "%d-%m-%Y %H:%M:%S", local_time);
+
+        // Enregistrer le message dans le log
+        char prefix[256];
+        int length = snprintf(prefix, sizeof(prefix),
+                              "[%s] Client PID: %d, Langue: %s (confiance %.2f), Message complet reçu : ",
+                              timestamp, b->pid, languages[b->result.best], b->result.confidence);
+        if (length >= (int)sizeof(prefix)) {
+            length = sizeof(prefix) - 1;
         }
+        transport_log_append(prefix, length, NULL);
+        transport_log_append(b->data, b->length, b);
+        transport_log_append("\n", 1, NULL);
+        b->log_offset = log_offset;
+        log_offset += length + b->length + 1;
     }
+}
 
-    if(len == 0) return languages[0];
 
-    // 1. Calcul basé sur la fréquence des lettres (50% du score final)
-    double observed_freq[26];
-    for(int i = 0; i < 26; i++) {
-        observed_freq[i] = (double)letter_count[i] / len * 100.0;
+/** @brief Cache des langues détectées, propre au thread de détection */
+static struct langue_cache cache;
+/** @brief Threads de traitement placés et prêts (rapport de placement) */
+static pthread_barrier_t threads_started;
+
+/** @brief Transports écoutés par le serveur */
+static struct transport listeners[TRANSPORT_MAX];
+static struct transport *active[TRANSPORT_MAX];
+static int listener_count = 0;
+
+/** @brief Messages reçus, en attente de détection de langue (une file par classe) */
+static struct msgbuf_queue classify_queues[LANE_COUNT];
+static sem_t classify_ready;
+/** @brief Messages classés, en attente d'écriture dans le log (une file par classe) */
+static struct msgbuf_queue log_queues[LANE_COUNT];
+/** @brief Transport interne de la boucle : l'étape d'écriture du log */
+static struct transport log_stage;
+/** @brief Messages écrits, à indexer (boucle d'événements -> thread d'index) */
+static struct msgbuf_queue index_queue;
+static sem_t index_ready;
+/** @brief Index plein texte du log (thread d'index) */
+static struct index_writer log_index;
+/** @brief Fin de l'index demandée (arrêt du serveur) */
+static atomic_int index_stop = 0;
+/** @brief Messages reçus pas encore ajoutés au lot de log (attendus à l'arrêt) */
+static atomic_int in_flight = 0;
+
+/** @brief Jauges des métriques : remplissage de la chaîne de traitement */
+static uint64_t pool_free(void) {
+    return msgbuf_available();
+}
+
+static uint64_t classify_depth(void) {
+    return msgbuf_queue_depth(&classify_queues[LANE_INTERACTIVE]) +
+           msgbuf_queue_depth(&classify_queues[LANE_BULK]);
+}
+
+static uint64_t log_depth(void) {
+    return msgbuf_queue_depth(&log_queues[LANE_INTERACTIVE]) +
+           msgbuf_queue_depth(&log_queues[LANE_BULK]);
+}
+
+/** @brief Retire le prochain message : interactif d'abord, masse sinon */
+static struct message_buffer *pop_lanes(struct msgbuf_queue *queues) {
+    struct message_buffer *b = msgbuf_queue_pop(&queues[LANE_INTERACTIVE]);
+    return b ? b : msgbuf_queue_pop(&queues[LANE_BULK]);
+}
+
+/**
+ * @brief Reçoit un message complet de n'importe quel transport
+ *
+ * Appelée par la boucle d'événements : le tampon (et la référence du
+ * transport) passe sans copie au thread de détection de langue, dans la
+ * file de sa classe. Un message long est toujours un envoi de masse, quel
+ * que soit le transport.
+ */
+void process_message(struct message_buffer *b) {
+    atomic_fetch_add_explicit(&in_flight, 1, memory_order_relaxed);
+    b->received_ns = metrics_now_ns();
+    if (b->length > LANE_INTERACTIVE_MAX) {
+        b->lane = LANE_BULK;
     }
+    msgbuf_queue_push(&classify_queues[b->lane], b);
+    sem_post(&classify_ready);
+}
+
+/**
+ * @brief Thread de détection de langue
+ *
+ * Affiche et classe chaque message, puis le passe à l'étape d'écriture du
+ * log dans la boucle d'événements. Les messages interactifs en attente
+ * passent avant les envois de masse.
+ */
+void *classifier(void *arg) {
+    (void)arg;
+    // Tables et cache alloués après le placement : sur le nœud du thread
+    placement_apply(PLACEMENT_CLASSIFIER, "détection");
+    if (langue_profile_localize() != 0 || langue_cache_init(&cache, settings.cache_bytes) != 0) {
+        fprintf(stderr, "Impossible d'allouer le cache des langues\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_barrier_wait(&threads_started);
+    while (1) {
+        sem_wait(&classify_ready);
+        struct message_buffer *b = pop_lanes(classify_queues);
+        if (!b) {
+            continue;
+        }
+        printf("\nMessage reçu du client PID %d (%s) : %s\n", b->pid, b->transport, b->data);
+
+        uint64_t start = metrics_now_ns();
+        trace_event(TRACE_CLASSIFY_BEGIN, b->pid, b->length);
+        uint64_t hits = cache.hits;
+        langue_cache_detect(&cache, b->data, b->length, &b->result);
+        metrics_inc(cache.hits != hits ? METRIC_CACHE_HITS : METRIC_CACHE_MISSES);
+        trace_event(TRACE_CLASSIFY_END, b->pid, b->length);
+        metrics_observe(METRIC_CLASSIFY_TIME, metrics_now_ns() - start);
+        printf("Langue détectée : %s (confiance %.2f)\n", languages[b->result.best], b->result.confidence);
+
+        metrics_inc(METRIC_MESSAGES);
+        if (b->truncated) {
+            metrics_inc(METRIC_TRUNCATIONS);
+        }
+        fflush(stdout);
 
-    for (int i = 0; i < 4; i++) {
-        double diff_sum = 0;
-        for (int j = 0; j < 26; j++) {
-            double diff = observed_freq[j] - probabilities[i][j];
-            diff_sum += diff * diff;
+        msgbuf_queue_push(&log_queues[b->lane], b);
+        uint64_t one = 1;
+        if (write(log_stage.fd, &one, sizeof(one)) < 0) {
+            perror("Réveil de la boucle");
         }
-        scores[i] = -diff_sum; // Score négatif car plus la différence est petite, meilleur est le score
     }
+    return NULL;
+}
+
+/**
+ * @brief Étape d'écriture du log, appelée par la boucle quand son eventfd
+ * est prêt
+ *
+ * Le lot de log prend sa propre référence sur chaque tampon, le relais
+ * vers les abonnés aussi ; celle reçue du thread de détection passe au
+ * thread d'index. Les messages interactifs sont ajoutés au lot avant les
+ * envois de masse. Le relais est réveillé une fois par lot.
+ */
+static int log_stage_recv(struct transport *t, int fd, transport_deliver deliver) {
+    (void)t;
+    (void)deliver;
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        return -1;
+    }
+    struct message_buffer *b;
+    while ((b = pop_lanes(log_queues)) != NULL) {
+        uint64_t start = metrics_now_ns();
+        trace_event(TRACE_LOG_BEGIN, b->pid, b->length);
+        save_message(b);
+        trace_event(TRACE_LOG_END, b->pid, b->length);
+        metrics_observe(METRIC_LOG_WRITE, metrics_now_ns() - start);
+        metrics_observe(b->lane == LANE_BULK ? METRIC_BULK_LATENCY : METRIC_INTERACTIVE_LATENCY,
+                        metrics_now_ns() - b->received_ns);
+        relay_publish(b);
+        msgbuf_queue_push(&index_queue, b);
+        sem_post(&index_ready);
+        atomic_fetch_sub_explicit(&in_flight, 1, memory_order_relaxed);
+    }
+    relay_wake();
+    return 0;
+}
 
-    // 2. Recherche de mots caractéristiques (50% du score final)
-    for(int i = 0; i < 4; i++) {
-        int word_matches = 0;
-        for(int j = 0; j < 10; j++) {
-            if(contains_word(message, keywords[i].keywords[j])) {
-                word_matches++;
+/**
+ * @brief Thread d'indexation des messages écrits
+ *
+ * Hors du chemin de réception : les termes sont accumulés en mémoire et
+ * l'index n'est écrit que par blocs, tous les INDEX_FLUSH_RECORDS messages
+ * ou après index_idle_ms (INDEX_IDLE_MS par défaut) sans message. À
+ * l'arrêt du serveur, le thread indexe les derniers messages, écrit son
+ * bloc et se termine.
+ */
+void *indexer(void *arg) {
+    (void)arg;
+    placement_apply(PLACEMENT_INDEX, "index");
+    pthread_barrier_wait(&threads_started);
+    while (1) {
+        struct timespec deadline;
+        unsigned idle_ms = atomic_load_explicit(&index_idle_ms, memory_order_relaxed);
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += idle_ms / 1000;
+        deadline.tv_nsec += (idle_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        if (sem_timedwait(&index_ready, &deadline) != 0) {
+            if (errno == ETIMEDOUT && index_writer_flush(&log_index) != 0) {
+                perror("Écriture de l'index");
             }
+            continue;
         }
-        scores[i] += word_matches * 50.0; // Bonus pour chaque mot trouvé
-    }
-
-    // Trouver la langue avec le meilleur score
-    double max_score = scores[0];
-    int best_index = 0;
-    //printf("\nScores par langue:\n");
-    for(int i = 0; i < 4; i++) {
-        //printf("%s: %.2f\n", languages[i], scores[i]);
-        if(scores[i] > max_score) {
-            max_score = scores[i];
-            best_index = i;
+        struct message_buffer *b = msgbuf_queue_pop(&index_queue);
+        if (b) {
+            index_writer_add(&log_index, b->log_offset, b->data, b->length);
+            msgbuf_put(b);
+        } else if (atomic_load(&index_stop)) {
+            index_writer_close(&log_index);
+            return NULL;
         }
     }
-
-    return languages[best_index];
 }
 
-/** @brief Buffer pour stocker le message reçu */
-char message[1024];
-/** @brief Index courant dans le buffer de message */
-volatile int message_length = 0;
-/** @brief Compteur de bits reçus */
-volatile int bits = 0;
-/** @brief Caractère en cours de construction */
-volatile unsigned char mots = 0;
-/** @brief PID du client pour l'accusé de réception */
-volatile pid_t client_pid = -1;
+static const struct transport_ops log_stage_ops = {
+    .name = "journal",
+    .recv = log_stage_recv,
+};
 
 /**
- * @brief Gestionnaire de signaux pour la réception des messages
- * @param sig Signal reçu (SIGUSR1, SIGUSR2 ou SIGQUIT)
- * @param info Informations supplémentaires sur le signal
- * @param context Contexte de l'appel
- *
- * Cette fonction traite les signaux reçus :
- * - SIGUSR1 : bit 1
- * - SIGUSR2 : bit 0
- * - SIGQUIT : fin du message
+ * @brief Thread de la boucle d'événements de tous les transports
  *
- * Les bits reçus sont assemblés en caractères, qui sont
- * ensuite ajoutés au message. À la réception de SIGQUIT,
- * le message complet est affiché et sa langue est déterminée.
+ * Le thread bloque tous les signaux pour qu'ils soient toujours reçus par
+ * le thread principal : le gestionnaire du transport par signaux reste le
+ * seul producteur de sa file. Il se termine quand l'arrêt du serveur
+ * arrête la boucle (transport_stop()).
  */
+void *event_loop(void *arg) {
+    (void)arg;
+    placement_apply(PLACEMENT_RECEPTION, "boucle");
+    pthread_barrier_wait(&threads_started);
+    if (transport_watch(&log_stage, log_stage.fd) == 0 &&
+        transport_run(active, listener_count, process_message) == 0) {
+        return NULL;
+    }
+    perror("Boucle d'événements");
+    exit(EXIT_FAILURE);
+}
 
+/**
+ * @brief Ouvre un transport en écoute
+ * @param address Adresse d'écoute, suffixée par ".N" pour le worker N
+ * @return 0 en cas de succès, -1 sinon
+ */
+int add_listener(const struct transport_ops *ops, const char *address, int shard) {
+    char path[108];
+    if (listener_count >= TRANSPORT_MAX) {
+        fprintf(stderr, "Trop de transports (maximum %d)\n", TRANSPORT_MAX);
+        return -1;
+    }
+    if (shard >= 0) {
+        snprintf(path, sizeof(path), "%s.%d", address, shard);
+    } else {
+        snprintf(path, sizeof(path), "%s", address);
+    }
+    struct transport *t = &listeners[listener_count];
+    memset(t, 0, sizeof(*t));
+    t->ops = ops;
+    if (ops->listen(t, path) != 0) {
+        fprintf(stderr, "Écoute %s sur %s impossible : %s\n", ops->name, path, strerror(errno));
+        return -1;
+    }
+    active[listener_count++] = t;
+    return 0;
+}
 
+/** @brief Ferme les transports à la sortie (supprime sockets et tubes) */
+void close_listeners(void) {
+    for (int i = 0; i < listener_count; i++) {
+        listeners[i].ops->close(&listeners[i]);
+    }
+}
 
-FILE *log_file;
-
-
-void load_previous_messages() {
-    log_file = fopen(LOG_FILE, "a+");  // Ouvre le fichier en lecture et écriture
-    if (!log_file) {
-        perror("Erreur lors de l'ouverture du fichier log");
-        exit(EXIT_FAILURE);
+/**
+ * @brief Commande de contrôle "trace [FICHIER]" : vide les anneaux de trace
+ */
+void trace_command(int argc, char *argv[], FILE *reply) {
+    const char *path = argc > 1 ? argv[1] : "server_trace.bin";
+    int count = trace_dump(path);
+    if (count < 0) {
+        fprintf(reply, "Erreur: impossible d'écrire %s\n", path);
+    } else {
+        fprintf(reply, "%d événements écrits dans %s\n", count, path);
     }
+}
+
+/**
+ * @brief Commande de contrôle "stats" : métriques au format Prometheus
+ */
+void stats_command(int argc, char *argv[], FILE *reply) {
+    (void)argc;
+    (void)argv;
+    metrics_write_prometheus(reply);
+}
 
-    // Lire et afficher les messages précédents
-    char line[256];
-    printf("Messages précédents :\n");
-    while (fgets(line, sizeof(line), log_file)) {
-        printf("%s", line);
+/**
+ * @brief Commande de contrôle "transports" : transports écoutés
+ */
+void transports_command(int argc, char *argv[], FILE *reply) {
+    (void)argc;
+    (void)argv;
+    fprintf(reply, "Boucle d'événements : %s\n", transport_loop);
+    for (int i = 0; i < listener_count; i++) {
+        unsigned caps = listeners[i].ops->caps;
+        fprintf(reply, "%-8s %-40s%s%s%s%s\n", listeners[i].ops->name, listeners[i].address,
+                caps & TRANSPORT_CAP_MESSAGE ? " message" : "",
+                caps & TRANSPORT_CAP_ACK ? " ack" : "",
+                caps & TRANSPORT_CAP_PEER_PID ? " pid" : "",
+                caps & TRANSPORT_CAP_REPLY ? " réponse" : "");
     }
-    printf("\n");
 }
 
+/**
+ * @brief Commande de contrôle "placement" : CPU et nœuds NUMA des threads
+ * et des principales zones de mémoire
+ */
+void placement_command(int argc, char *argv[], FILE *reply) {
+    (void)argc;
+    (void)argv;
+    placement_report(reply);
+    fprintf(reply, "Réserve de tampons : nœud %d\n", placement_memory_node(msgbuf_at(0)));
+    fprintf(reply, "Cache des langues  : nœud %d\n", placement_memory_node(cache.entries));
+}
 
+/**
+ * @brief Commande de contrôle "abonnes" : abonnés du relais
+ */
+void relay_command(int argc, char *argv[], FILE *reply) {
+    (void)argc;
+    (void)argv;
+    relay_report(reply);
+}
 
-void save_message(pid_t client_pid, const char *msg) {
-    if (log_file) {
-        // Ajouter l'horodatage
-        time_t now = time(NULL);
-        struct tm *local_time = localtime(&now);
-        char timestamp[20];
-        strftime(timestamp, sizeof(timestamp), "%d-%m-%Y %H:%M:%S", local_time);
+/**
+ * @brief Applique les réglages modifiables à chaud
+ * @param errors Flux où décrire les erreurs
+ * @return 0 en cas de succès, -1 si un réglage est refusé (rien n'est
+ * appliqué)
+ *
+ * Tout est vérifié avant le premier changement : le profil de langues est
+ * lu à part, puis utilisé avec les autres réglages. Il est relu même si
+ * son chemin n'a pas changé : c'est ainsi qu'un profil réentraîné est pris
+ * en compte. Les détections en cours ne sont pas bloquées (voir
+ * langue_profile_publish()).
+ */
+static int apply_runtime(const struct config *c, FILE *errors) {
+    struct langue_profile *staged = NULL;
+    if (c->profile[0] && (staged = langue_profile_read(c->profile)) == NULL) {
+        fprintf(errors, "Erreur: profil %s non chargé (voir la sortie du serveur)\n", c->profile);
+        return -1;
+    }
+    if (!sched_limit_valid(c->rate, c->burst, c->quantum)) {
+        fprintf(errors, "Erreur: limites refusées (débit minimal %d, rafale et quantum non nuls)\n",
+                SCHED_RATE_MIN);
+        if (staged) {
+            langue_profile_discard(staged);
+        }
+        return -1;
+    }
 
-        // Enregistrer le message dans le log
-        fprintf(log_file, "[%s] Client PID: %d, Message complet reçu : %s\n", timestamp, client_pid, msg);
-        fflush(log_file);
+    if (staged) {
+        langue_profile_publish(staged);
     }
+    sched_set_limit(c->rate, c->burst, c->quantum);
+    transport_signal_set_bulk_delay(c->bulk_ack_delay_us);
+    atomic_store_explicit(&index_idle_ms, c->index_idle_ms > 0 ? c->index_idle_ms : INDEX_IDLE_MS,
+                          memory_order_relaxed);
+    atomic_store_explicit(&drain_timeout_ms, c->drain_timeout_ms, memory_order_relaxed);
+    return 0;
 }
 
+/**
+ * @brief Commande de contrôle "reload" : relit le fichier de configuration
+ *
+ * Les réglages modifiables à chaud sont appliqués tout de suite ; les
+ * autres clés modifiées sont signalées. Un fichier invalide ne change rien.
+ */
+void reload_command(int argc, char *argv[], FILE *reply) {
+    (void)argc;
+    (void)argv;
+    struct config loaded = settings;
+    if (config_load(config_path, &loaded, reply) != 0) {
+        fprintf(reply, "Configuration inchangée\n");
+        return;
+    }
+    if (apply_runtime(&loaded, reply) != 0) {
+        fprintf(reply, "Configuration inchangée\n");
+        return;
+    }
+    config_restart_needed(&settings, &loaded, reply);
+    fprintf(reply, "Configuration rechargée depuis %s\n", config_path);
+    settings = loaded;
+}
 
-void handler(int sig, siginfo_t *info, void *context) {
-    if (sig == SIGUSR1 || sig == SIGUSR2) {
-        // Obtenir le PID du client depuis siginfo
-        client_pid = info->si_pid;
-        
-        // Traitement du bit reçu
-        if (sig == SIGUSR1) {
-            mots = (mots << 1) | 1;
-        } else {
-            mots = (mots << 1) | 0;
-        }
-        bits++;
+/**
+ * @brief Gestionnaire de SIGTERM et SIGINT : demande l'arrêt propre
+ *
+ * Un second signal arrête le serveur sans attendre ; les sessions en
+ * cours restent dans le journal.
+ */
+static void stop_handler(int sig) {
+    (void)sig;
+    if (stop_requested) {
+        _exit(EXIT_FAILURE);
+    }
+    stop_requested = 1;
+}
 
-        // Envoyer l'accusé de réception avec un petit délai
-        if (client_pid > 0) {
-            usleep(100);  // Petit délai avant l'envoi de l'ACK
-            kill(client_pid, SIGUSR1);
+/**
+ * @brief Arrêt propre du serveur
+ * @param loop Thread de la boucle d'événements
+ * @param index_thread Thread d'index
+ *
+ * Les transports n'acceptent plus de nouveaux clients. Les sessions déjà
+ * commencées et les messages reçus ont delai_arret_ms pour traverser la
+ * détection de langue et l'écriture du log. La boucle s'arrête ensuite
+ * après avoir écrit tout le log en attente, le relais envoie aux abonnés ce
+ * qui peut partir sans attendre, puis l'index écrit son dernier
+ * bloc. Les sessions encore incomplètes restent dans le journal : le
+ * serveur relancé les reprendra.
+ */
+static void drain(pthread_t loop, pthread_t index_thread) {
+    unsigned timeout_ms = atomic_load(&drain_timeout_ms);
+    printf("\nArrêt : plus de nouveaux clients ; %d sessions et %d messages en cours (%u ms au plus)\n",
+           session_active(), atomic_load(&in_flight), timeout_ms);
+    fflush(stdout);
+    for (int i = 0; i < listener_count; i++) {
+        if (listeners[i].ops->drain) {
+            listeners[i].ops->drain(&listeners[i]);
         }
+    }
+    uint64_t deadline = metrics_now_ns() + (uint64_t)timeout_ms * 1000000;
+    while ((session_active() > 0 || atomic_load(&in_flight) > 0) && metrics_now_ns() < deadline) {
+        usleep(DRAIN_POLL_US);
+    }
 
-        if (bits == 8) {
-            if (message_length < sizeof(message) - 1) {
-                message[message_length++] = mots;
-            }
-            bits = 0;
-            mots = 0;
-        }
-    } else if (sig == SIGQUIT) {
-        if (message_length > 0) {
-            message[message_length] = '\0';
-            printf("\nMessage reçu du client PID %d : %s\n", client_pid, message);
-            printf("Langue détectée : %s\n", getlangue(message));
-            save_message(client_pid, message);           
-            memset(message, 0, sizeof(message));
-            message_length = 0;
-            bits = 0;
-            mots = 0;
-            client_pid = -1;
-        }
+    // La boucle attend peut-être : réveil par l'eventfd de l'étape du log
+    transport_stop();
+    uint64_t one = 1;
+    if (write(log_stage.fd, &one, sizeof(one)) < 0) {
+        perror("Réveil de la boucle");
     }
+    pthread_join(loop, NULL);
+    relay_stop();
+    atomic_store(&index_stop, 1);
+    sem_post(&index_ready);
+    pthread_join(index_thread, NULL);
+
+    if (journal_sync() != 0) {
+        perror("Écriture du journal");
+    }
+    fclose(log_file);
+    log_file = NULL;
+    printf("Arrêt terminé : %d sessions incomplètes gardées dans le journal, %d messages perdus\n",
+           session_active(), atomic_load(&in_flight));
+    fflush(stdout);
 }
 
 /**
  * @brief Point d'entrée du programme
+ * @param argc Nombre d'arguments
+ * @param argv Tableau des arguments
  * @return 0 en cas de succès
  *
+ * Usage: ./server [-C CONFIGURATION] [-m FICHIER_METRIQUES] [-s SOCKET_CONTROLE]
+ *                 [-u SOCKET] [-f TUBE] [-c FICHIER_CAPTURE] [-n MESSAGES] [-a]
+ *                 [-p PROFIL] [-l SOCKET_RELAIS] [-w WORKERS [-d FICHIER_SHARDS]]
+ *
+ * Les réglages sont lus dans miniteams.conf s'il existe (CONFIGURATION avec
+ * -C, voir config.h) ; les options de la ligne de commande ont priorité.
+ * La commande de contrôle "reload" relit ce fichier : profil de langues,
+ * limites de débit et délais sont changés sans redémarrage.
+ *
  * Le programme affiche son PID et attend les signaux
- * pour recevoir des messages.
+ * pour recevoir des messages. Les gestionnaires de signaux et les
+ * transports sont installés avant l'affichage de l'historique, limité aux
+ * 20 derniers messages (MESSAGES avec -n, -1 pour tout l'historique, 0 pour
+ * rien) ; avec -a, l'historique est affiché par un thread pendant que le
+ * serveur reçoit déjà. Avec -p, la détection de langue utilise les tables
+ * du profil écrit par l'outil train. Les métriques sont réécrites
+ * chaque seconde dans server_metrics.prom (ou FICHIER_METRIQUES).
+ * La socket de contrôle (/tmp/miniteams-PID.sock par défaut)
+ * accepte les commandes de l'outil ctl.
+ *
+ * Avec -l, chaque message écrit dans le log est aussi relayé, avec sa
+ * langue, aux clients abonnés à son canal sur SOCKET_RELAIS (client -l,
+ * voir relay.h). Un worker relaie ses propres messages sur SOCKET_RELAIS.N.
+ *
+ * Les messages sont toujours reçus par signaux ; -u et -f (répétables)
+ * ajoutent une socket Unix SOCK_SEQPACKET et un tube nommé écoutés en
+ * même temps. La boucle d'événements utilise io_uring si le noyau le
+ * permet, epoll sinon (ou si la variable MINITEAMS_EPOLL est définie, ou
+ * avec "boucle = epoll" dans la configuration).
+ *
+ * Avec -w, le processus devient superviseur de WORKERS serveurs fixés
+ * chacun sur un CPU, dont les PID sont publiés dans server_shards.txt
+ * (ou FICHIER_SHARDS) pour les clients lancés avec -d. Chaque worker
+ * écrit son propre segment server_log.N.txt et ses métriques dans
+ * server_metrics.N.prom (".N" inséré de même dans les chemins choisis) ;
+ * l'historique affiché au démarrage fusionne tous les segments. Les sockets et tubes d'un worker
+ * sont suffixés par ".N".
+ *
+ * Avec -c, les signaux reçus sont enregistrés dans FICHIER_CAPTURE (suffixé
+ * par ".N" pour un worker), à rejouer avec l'outil replay. La capture peut
+ * aussi être démarrée et arrêtée par la commande de contrôle "capture".
+ *
+ * SIGTERM ou SIGINT arrêtent le serveur proprement (voir drain()) ; avec
+ * -w, SIGINT n'est reçu que par le superviseur, qui arrête les workers. Les
+ * sessions en cours de réception sont tenues à jour dans le journal
+ * server_sessions.bin (suffixé par ".N" pour un worker) : après un arrêt,
+ * même brutal, le serveur relancé les reprend et les clients lancés avec
+ * -r continuent leur envoi où il s'était arrêté. Sans -w, le serveur se
+ * publie comme unique worker dans FICHIER_SHARDS s'il est donné (-d ou clé
+ * "shards"), pour qu'un client lancé avec -d le retrouve après un
+ * redémarrage ; il ne remplace pas le fichier d'un autre serveur vivant.
  */
-int main() {
-    // Configuration des gestionnaires de signaux avec sigaction
-    struct sigaction sa;
-    sa.sa_sigaction = handler;
-    sa.sa_flags = SA_SIGINFO;  // Pour obtenir les informations supplémentaires sur le signal
-    sigemptyset(&sa.sa_mask);
-    load_previous_messages();
-    if (sigaction(SIGUSR1, &sa, NULL) == -1 ||
-        sigaction(SIGUSR2, &sa, NULL) == -1 ||
-        sigaction(SIGQUIT, &sa, NULL) == -1) {
-        perror("sigaction");
+int main(int argc, char *argv[]) {
+    const char *optstring = "C:m:s:w:d:u:f:c:n:ap:l:";
+    char metrics_path[CONFIG_PATH_MAX + 16];
+    char control_path[108];
+    int shard = -1;
+    int show_history = 1;
+    int opt;
+
+    // Fichier de configuration d'abord : les options le remplacent
+    int explicit_config = 0;
+    opterr = 0;
+    while ((opt = getopt(argc, argv, optstring)) != -1) {
+        if (opt == 'C') {
+            snprintf(config_path, sizeof(config_path), "%s", optarg);
+            explicit_config = 1;
+        }
+    }
+    if ((explicit_config || access(config_path, F_OK) == 0) &&
+        config_load(config_path, &settings, stderr) != 0) {
         return 1;
     }
+    opterr = 1;
+    optind = 1;
+
+    int socket_options = 0, fifo_options = 0;
+    while ((opt = getopt(argc, argv, optstring)) != -1) {
+        if (opt == 'C') {
+            continue;
+        } else if (opt == 'm') {
+            snprintf(settings.metrics, sizeof(settings.metrics), "%s", optarg);
+        } else if (opt == 's') {
+            snprintf(settings.control, sizeof(settings.control), "%s", optarg);
+        } else if (opt == 'w') {
+            settings.workers = atoi(optarg);
+        } else if (opt == 'd') {
+            snprintf(settings.shards, sizeof(settings.shards), "%s", optarg);
+        } else if (opt == 'u' && socket_options < TRANSPORT_MAX) {
+            // Les sockets données en option remplacent celles du fichier
+            snprintf(settings.sockets[socket_options++], sizeof(settings.sockets[0]), "%s", optarg);
+            settings.socket_count = socket_options;
+        } else if (opt == 'f' && fifo_options < TRANSPORT_MAX) {
+            snprintf(settings.fifos[fifo_options++], sizeof(settings.fifos[0]), "%s", optarg);
+            settings.fifo_count = fifo_options;
+        } else if (opt == 'c') {
+            snprintf(settings.capture, sizeof(settings.capture), "%s", optarg);
+        } else if (opt == 'n') {
+            settings.history = atoi(optarg);
+        } else if (opt == 'a') {
+            settings.history_async = 1;
+        } else if (opt == 'p') {
+            snprintf(settings.profile, sizeof(settings.profile), "%s", optarg);
+        } else if (opt == 'l') {
+            snprintf(settings.relay, sizeof(settings.relay), "%s", optarg);
+        } else {
+            printf("Usage: %s [-C CONFIGURATION] [-m FICHIER_METRIQUES] [-s SOCKET_CONTROLE]\n"
+                   "          [-u SOCKET] [-f TUBE] [-c FICHIER_CAPTURE] [-n MESSAGES] [-a]\n"
+                   "          [-p PROFIL] [-l SOCKET_RELAIS] [-w WORKERS] [-d FICHIER_SHARDS]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (strcmp(settings.loop, "epoll") == 0) {
+        setenv("MINITEAMS_EPOLL", "1", 1);
+    } else if (strcmp(settings.loop, "io_uring") != 0) {
+        fprintf(stderr, "Boucle d'événements inconnue : %s (io_uring ou epoll)\n", settings.loop);
+        return 1;
+    }
+    if (apply_runtime(&settings, stderr) != 0) {
+        return 1;
+    }
+    snprintf(log_path, sizeof(log_path), "%s", settings.log);
+    path_variant(settings.log, ".txt", "*", log_segments, sizeof(log_segments));
+    snprintf(metrics_path, sizeof(metrics_path), "%s", settings.metrics);
+
+    if (settings.workers > 0) {
+        if (!settings.shards[0]) {
+            snprintf(settings.shards, sizeof(settings.shards), "%s", SHARDS_FILE);
+        }
+        // L'historique est affiché une seule fois, par le superviseur
+        load_previous_messages(NULL);
+        show_history = 0;
+
+        shard = supervisor_run(settings.workers, settings.shards, settings.drain_timeout_ms);
+        if (shard < 0) {
+            return 0;
+        }
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), ".%d", shard);
+        path_variant(settings.log, ".txt", suffix, log_path, sizeof(log_path));
+        path_variant(settings.metrics, ".prom", suffix, metrics_path, sizeof(metrics_path));
+    }
+    if (settings.control[0] && shard >= 0) {
+        snprintf(control_path, sizeof(control_path), "%.96s.%d", settings.control, shard);
+    } else if (settings.control[0]) {
+        snprintf(control_path, sizeof(control_path), "%s", settings.control);
+    } else {
+        snprintf(control_path, sizeof(control_path), CONTROL_PATH_FORMAT, getpid());
+    }
+
+    // Thread principal (gestionnaire de signaux) placé avant les allocations
+    // partagées avec la boucle : réserve de tampons, traces, file des signaux
+    static const char *roles[PLACEMENT_ROLE_COUNT] = {"cpu_reception", "cpu_detection", "cpu_index"};
+    for (int role = 0; role < PLACEMENT_ROLE_COUNT; role++) {
+        if (shard < 0 && placement_set(role, settings.cpus[role]) != 0) {
+            fprintf(stderr, "%s : liste de CPU invalide ou hors des CPU du processus : %s\n",
+                    roles[role], settings.cpus[role]);
+            return 1;
+        }
+    }
+    if (placement_apply(PLACEMENT_RECEPTION, "principal") != 0) {
+        perror("Placement du thread principal");
+    }
+    trace_init();
+
+    if (msgbuf_pool_init(settings.pool) != 0) {
+        fprintf(stderr, "Impossible d'allouer la réserve de tampons\n");
+        return 1;
+    }
+    sem_init(&classify_ready, 0, 0);
+    metrics_gauge(METRIC_POOL_FREE, pool_free);
+    metrics_gauge(METRIC_CLASSIFY_QUEUE, classify_depth);
+    metrics_gauge(METRIC_LOG_QUEUE, log_depth);
+    metrics_gauge(METRIC_SCHED_QUEUE, sched_pending);
+    metrics_gauge(METRIC_SUBSCRIBERS, relay_subscribers);
+    log_stage.ops = &log_stage_ops;
+    log_stage.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (log_stage.fd < 0) {
+        perror("eventfd");
+        return 1;
+    }
+    open_log();
+    char index_path[256];
+    index_path_for(log_path, index_path, sizeof(index_path));
+    if (index_writer_open(&log_index, index_path) != 0) {
+        perror(index_path);
+        return 1;
+    }
+    sem_init(&index_ready, 0, 0);
+    if (settings.capture[0]) {
+        char capture_path[CONFIG_PATH_MAX + 16];
+        if (shard >= 0) {
+            snprintf(capture_path, sizeof(capture_path), "%s.%d", settings.capture, shard);
+        } else {
+            snprintf(capture_path, sizeof(capture_path), "%s", settings.capture);
+        }
+        if (capture_start(capture_path) != 0) {
+            perror(capture_path);
+            return 1;
+        }
+    }
+
+    // Sessions interrompues par l'arrêt du serveur précédent : avant les
+    // transports, qui peuvent déjà recevoir leur suite
+    int resumed = 0, recovered = 0;
+    if (settings.journal[0]) {
+        char journal_path[CONFIG_PATH_MAX + 16];
+        if (shard >= 0) {
+            snprintf(journal_path, sizeof(journal_path), "%s.%d", settings.journal, shard);
+        } else {
+            snprintf(journal_path, sizeof(journal_path), "%s", settings.journal);
+        }
+        if (session_journal_open(journal_path) != 0) {
+            perror(journal_path);
+            return 1;
+        }
+        resumed = session_recover(process_message, &recovered);
+        metrics_add(METRIC_SESSIONS_RECOVERED, resumed + recovered);
+    }
+
+    // Transports écoutés ; le gestionnaire des signaux est installé ici,
+    // dans le thread principal
+    if (add_listener(&transport_signal, "", -1) != 0) {
+        return 1;
+    }
+    for (int i = 0; i < settings.socket_count; i++) {
+        if (add_listener(&transport_unix, settings.sockets[i], shard) != 0) {
+            return 1;
+        }
+    }
+    for (int i = 0; i < settings.fifo_count; i++) {
+        if (add_listener(&transport_fifo, settings.fifos[i], shard) != 0) {
+            return 1;
+        }
+    }
+    atexit(close_listeners);
+
+    // Relais vers les abonnés : démarré avant la boucle, qui lui publie les
+    // messages écrits
+    char relay_path[108];
+    if (settings.relay[0]) {
+        if (shard >= 0) {
+            snprintf(relay_path, sizeof(relay_path), "%.96s.%d", settings.relay, shard);
+        } else {
+            snprintf(relay_path, sizeof(relay_path), "%s", settings.relay);
+        }
+        if (relay_start(relay_path) != 0) {
+            fprintf(stderr, "Relais sur %s impossible : %s\n", relay_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    // Boucle d'événements, détection de langue et index, créés avec tous les
+    // signaux bloqués
+    sigset_t all, old;
+    pthread_t loop, detect, index_thread;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    pthread_barrier_init(&threads_started, NULL, 4);
+    int err = pthread_create(&detect, NULL, classifier, NULL);
+    if (err == 0) {
+        err = pthread_create(&index_thread, NULL, indexer, NULL);
+    }
+    if (err == 0) {
+        err = pthread_create(&loop, NULL, event_loop, NULL);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        fprintf(stderr, "Impossible de créer les threads de traitement\n");
+        return 1;
+    }
+
+    pthread_barrier_wait(&threads_started);
+    if (metrics_start_exporter(metrics_path, settings.metrics_interval_ms) != 0) {
+        fprintf(stderr, "Impossible de démarrer l'export des métriques\n");
+    }
+
+    control_register("trace", "[FICHIER] vide les traces (défaut: server_trace.bin)", trace_command);
+    control_register("stats", "affiche les métriques", stats_command);
+    control_register("transports", "liste les transports écoutés", transports_command);
+    control_register("capture", "[FICHIER|stop] enregistre les signaux reçus (voir replay)", capture_command);
+    control_register("placement", "CPU et nœuds NUMA des threads", placement_command);
+    control_register("reload", "relit le fichier de configuration (réglages modifiables à chaud)", reload_command);
+    control_register("abonnes", "abonnés du relais : canal, transport, messages en attente", relay_command);
+    control_register("limit", "[DÉBIT [RAFALE [QUANTUM]]] limite le débit de chaque client (0 : sans limite)", sched_command);
+    if (control_start(control_path) != 0) {
+        perror(control_path);
+    }
+
+    int published = 0;
+    if (shard < 0 && settings.shards[0]) {
+        pid_t self = getpid();
+        if (shards_owner(settings.shards) > 0) {
+            fprintf(stderr, "%s : publié par un autre serveur en marche, non remplacé\n", settings.shards);
+        } else {
+            published = shards_write(settings.shards, &self, 1) == 0;
+        }
+    }
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = stop_handler;
+    sigemptyset(&stop.sa_mask);
+    sigaction(SIGTERM, &stop, NULL);
+    if (shard < 0) {
+        sigaction(SIGINT, &stop, NULL);  // Un worker n'obéit qu'au SIGTERM du superviseur
+    }
+    supervisor_ready();
 
     printf("Server PID: %d\n", getpid());
-    
-    while(1) {
-        pause();
+    for (int i = 1; i < listener_count; i++) {
+        printf("Écoute %s : %s\n", listeners[i].ops->name, listeners[i].address);
+    }
+    if (settings.relay[0]) {
+        printf("Relais des abonnés : %s\n", relay_path);
+    }
+    printf("Placement des threads :\n");
+    placement_report(stdout);
+    if (resumed + recovered > 0) {
+        printf("Journal : %d sessions en attente de reprise, %d messages incomplets rendus\n",
+               resumed, recovered);
+    }
+    fflush(stdout);
+
+    // Serveur prêt : l'historique peut prendre son temps
+    if (show_history && settings.history_async) {
+        pthread_t history;
+        pthread_sigmask(SIG_BLOCK, &all, &old);
+        err = pthread_create(&history, NULL, load_previous_messages, NULL);
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+        if (err == 0) {
+            pthread_detach(history);
+        } else {
+            load_previous_messages(NULL);
+        }
+    } else if (show_history) {
+        load_previous_messages(NULL);
+    }
+
+    // SIGTERM et SIGINT bloqués hors de l'attente : pas de signal perdu
+    // entre le test et sigsuspend()
+    sigset_t stop_signals, waiting;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGTERM);
+    sigaddset(&stop_signals, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &waiting);
+    while (!stop_requested) {
+        sigsuspend(&waiting);
+    }
+    pthread_sigmask(SIG_SETMASK, &waiting, NULL);
+    drain(loop, index_thread);
+    if (published && shards_owner(settings.shards) == 0) {
+        unlink(settings.shards);
     }
-    fclose(log_file); l
     return 0;
 }
@@ -1 +1 @@
-gcc server.c -o server && ./server
\ No newline at end of file
+gcc server.c langue.c metrics.c trace.c control.c history.c shards.c supervisor.c session.c journal.c relay.c langue_cache.c transport.c transport_signal.c transport_unix.c transport_fifo.c transport_uring.c msgbuf.c capture.c scheduler.c config.c placement.c index.c token.c -o server -pthread -lm && ./server "$@"
\ No newline at end of file
@@ -0,0 +1,247 @@
+/**
+ * @file session.c
+ * @brief État de réception d'un message par client
+ * @author silverhawks
+ * @date 06/01/25
+ */
+
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "session.h"
+#include "journal.h"
+#include "metrics.h"
+
+static struct session sessions[SESSIONS_MAX];
+/** @brief Sessions en cours, lu par le thread principal pendant l'arrêt */
+static atomic_int active = 0;
+/** @brief Entrée du journal de chaque session (NULL : pas de journal) */
+static struct journal_entry *journal = NULL;
+
+/**
+ * @brief Cherche la session d'un client
+ * @param pid PID du client
+ * @param create Crée la session si elle n'existe pas
+ * @return La session, ou NULL (absente ou table pleine)
+ *
+ * Adressage ouvert avec sondage linéaire à partir du PID. Une session
+ * créée prend un tampon dans la réserve : elle n'est pas créée si la
+ * réserve est vide.
+ */
+struct session *session_find(pid_t pid, int create) {
+    struct session *free_slot = NULL;
+    for (int i = 0; i < SESSIONS_MAX; i++) {
+        struct session *s = &sessions[(pid + i) % SESSIONS_MAX];
+        if (s->pid == pid) {
+            return s;
+        }
+        if (s->pid == 0 && !free_slot) {
+            free_slot = s;
+        }
+    }
+    if (create && free_slot) {
+        free_slot->buffer = msgbuf_get();
+        if (!free_slot->buffer) {
+            return NULL;
+        }
+        free_slot->pid = pid;
+        free_slot->last_ns = metrics_now_ns();
+        atomic_fetch_add_explicit(&active, 1, memory_order_relaxed);
+        if (journal) {
+            struct journal_entry *e = &journal[free_slot - sessions];
+            atomic_store_explicit(&e->received, 0, memory_order_relaxed);
+            atomic_store_explicit(&e->pid, pid, memory_order_release);
+        }
+        return free_slot;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Note le dernier bit reçu dans le journal
+ * @param added Le bit a complété un octet ajouté au message
+ */
+static void journal_bit(const struct session *s, int added) {
+    struct journal_entry *e = &journal[s - sessions];
+    if (added) {
+        e->data[s->length - 1] = s->buffer->data[s->length - 1];
+    } else if (s->bits > 0) {
+        e->data[s->length] = s->mots << (8 - s->bits);
+    }
+    e->lane = s->buffer->lane;
+    atomic_store_explicit(&e->received, s->received, memory_order_release);
+}
+
+/**
+ * @brief Ajoute un bit à l'octet en cours
+ * @return 1 si un octet complet a été ajouté au message, 0 sinon
+ *
+ * Un octet complet qui ne tient plus dans le message est perdu et la
+ * session est marquée comme tronquée. Une session interactive qui dépasse
+ * LANE_INTERACTIVE_MAX octets passe en envoi de masse. Le bit est noté
+ * dans le journal avant le retour : le client n'est acquitté que d'un bit
+ * journalisé.
+ */
+int session_push_bit(struct session *s, int bit) {
+    s->mots = (s->mots << 1) | (bit & 1);
+    s->received++;
+    int added = 0;
+    if (++s->bits == 8) {
+        if (s->length < MESSAGE_MAX - 1) {
+            s->buffer->data[s->length++] = s->mots;
+            if (s->length > LANE_INTERACTIVE_MAX) {
+                s->buffer->lane = LANE_BULK;
+            }
+            added = 1;
+        } else {
+            s->truncated = 1;
+        }
+        s->bits = 0;
+        s->mots = 0;
+    }
+    if (journal) {
+        journal_bit(s, added);
+    }
+    return added;
+}
+
+/**
+ * @brief Libère la session à la fin du message
+ *
+ * Le tampon, s'il n'a pas été confié à la suite du traitement, est rendu
+ * à la réserve ; ses octets ne sont pas effacés.
+ */
+void session_release(struct session *s) {
+    if (s->buffer) {
+        msgbuf_put(s->buffer);
+    }
+    if (journal && s->pid) {
+        atomic_store_explicit(&journal[s - sessions].pid, 0, memory_order_release);
+    }
+    if (s->pid) {
+        atomic_fetch_sub_explicit(&active, 1, memory_order_relaxed);
+    }
+    s->pid = 0;
+    s->buffer = NULL;
+    s->length = 0;
+    s->bits = 0;
+    s->mots = 0;
+    s->truncated = 0;
+    s->received = 0;
+    s->last_ns = 0;
+}
+
+/**
+ * @brief Rend le message d'une session interrompue
+ *
+ * Les octets déjà reçus sont confiés à deliver comme un message tronqué ;
+ * une session sans octet complet est simplement libérée.
+ */
+static void session_expire(struct session *s, void (*deliver)(struct message_buffer *message)) {
+    if (s->length > 0) {
+        struct message_buffer *b = s->buffer;
+        b->data[s->length] = '\0';
+        b->pid = s->pid;
+        b->length = s->length;
+        b->truncated = 1;
+        s->buffer = NULL;
+        deliver(b);
+    }
+    session_release(s);
+}
+
+/**
+ * @brief Rend les sessions abandonnées par leur client
+ * @param now Instant présent (metrics_now_ns())
+ * @param dead_after_ns Silence après lequel la session d'un client qui
+ * n'existe plus est rendue (0 : dès maintenant)
+ * @param deliver Reçoit le message tronqué d'une session rendue
+ * @return Nombre de sessions rendues
+ *
+ * Une session silencieuse depuis SESSION_IDLE_MS est rendue même si son
+ * client existe encore : il a cessé d'attendre ses ACK bien avant
+ * (ACK_TIMEOUT_US). Celle d'un client disparu l'est dès dead_after_ns,
+ * avant que son PID puisse être repris par un autre processus.
+ */
+int session_sweep(uint64_t now, uint64_t dead_after_ns, void (*deliver)(struct message_buffer *message)) {
+    int expired = 0;
+    for (int i = 0; i < SESSIONS_MAX; i++) {
+        struct session *s = &sessions[i];
+        if (s->pid == 0 || now < s->last_ns + dead_after_ns) {
+            continue;
+        }
+        if (now >= s->last_ns + (uint64_t)SESSION_IDLE_MS * 1000000 ||
+            (kill(s->pid, 0) != 0 && errno == ESRCH)) {
+            session_expire(s, deliver);
+            expired++;
+        }
+    }
+    return expired;
+}
+
+/** @brief Nombre de sessions en cours (utilisable depuis un autre thread) */
+int session_active(void) {
+    return atomic_load_explicit(&active, memory_order_relaxed);
+}
+
+/**
+ * @brief Ouvre le journal des sessions
+ * @return 0 en cas de succès, -1 sinon (errno)
+ *
+ * À appeler avant la première session, puis session_recover().
+ */
+int session_journal_open(const char *path) {
+    journal = journal_open(path, SESSIONS_MAX);
+    return journal ? 0 : -1;
+}
+
+/**
+ * @brief Reprend les sessions interrompues trouvées dans le journal
+ * @param deliver Reçoit le message d'une session dont le client n'existe
+ * plus
+ * @param delivered Nombre de messages passés à deliver
+ * @return Nombre de sessions reprises, en attente de la suite de l'envoi
+ *
+ * La session d'un client encore vivant est remise dans sa case : il peut
+ * reprendre son envoi où le journal s'est arrêté. Celle d'un client
+ * disparu est rendue comme un message tronqué (sa fin a pu être perdue).
+ * À appeler avant le démarrage de la boucle d'événements.
+ */
+int session_recover(void (*deliver)(struct message_buffer *message), int *delivered) {
+    int resumed = 0;
+    *delivered = 0;
+    for (int i = 0; journal && i < SESSIONS_MAX; i++) {
+        struct journal_entry *e = &journal[i];
+        pid_t pid = atomic_load_explicit(&e->pid, memory_order_acquire);
+        if (pid <= 0) {
+            continue;
+        }
+        struct message_buffer *b = msgbuf_get();
+        if (!b) {
+            break;  // Réserve trop petite : les autres restent dans le journal
+        }
+        struct session *s = &sessions[i];
+        s->pid = pid;
+        s->buffer = b;
+        s->last_ns = metrics_now_ns();
+        s->received = atomic_load_explicit(&e->received, memory_order_acquire);
+        s->length = s->received / 8 < MESSAGE_MAX - 1 ? s->received / 8 : MESSAGE_MAX - 1;
+        s->truncated = s->received / 8 > MESSAGE_MAX - 1;
+        s->bits = s->received % 8;
+        s->mots = s->bits > 0 ? (unsigned char)e->data[s->length] >> (8 - s->bits) : 0;
+        b->lane = e->lane == LANE_BULK ? LANE_BULK : LANE_INTERACTIVE;
+        memcpy(b->data, e->data, s->length);
+        atomic_fetch_add_explicit(&active, 1, memory_order_relaxed);
+
+        if (kill(pid, 0) == 0 || errno == EPERM) {
+            resumed++;
+        } else {
+            b->transport = "reprise";
+            *delivered += s->length > 0;
+            session_expire(s, deliver);
+        }
+    }
+    return resumed;
+}
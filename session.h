@@ -0,0 +1,56 @@
+/**
+ * @file session.h
+ * @brief État de réception d'un message par client
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Chaque client (identifié par son PID) a sa propre session : plusieurs
+ * clients peuvent envoyer en même temps sans mélanger leurs bits. La table
+ * n'est utilisée que par le thread de traitement et n'a donc pas de verrou.
+ *
+ * Avec session_journal_open(), chaque session est aussi tenue à jour dans
+ * un journal projeté en mémoire (journal.h) : un serveur relancé retrouve
+ * les sessions interrompues par session_recover().
+ *
+ * Un client qui s'arrête au milieu d'un message (abandon, kill, plantage)
+ * n'envoie jamais SIGQUIT : session_sweep() rend sa session, pour que sa
+ * case et son tampon ne soient pas perdus.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "msgbuf.h"
+
+/** @brief Nombre maximal de clients en cours d'envoi */
+#define SESSIONS_MAX 64
+/** @brief Silence après lequel la session d'un client disparu est rendue (ms) */
+#define SESSION_DEAD_MS 200
+/** @brief Silence après lequel toute session est rendue (ms) : le client a abandonné */
+#define SESSION_IDLE_MS 10000
+/** @brief Intervalle entre deux recherches de sessions abandonnées (ms) */
+#define SESSION_SWEEP_MS 100
+
+struct session {
+    pid_t pid;                  /**< PID du client, 0 si la case est libre */
+    struct message_buffer *buffer;  /**< Message en cours de réception */
+    int length;                 /**< Octets reçus */
+    int bits;                   /**< Bits reçus pour l'octet en cours */
+    unsigned char mots;         /**< Octet en cours de construction */
+    int truncated;              /**< Une partie du message a été perdue */
+    unsigned received;          /**< Bits reçus (position de reprise du client) */
+    uint64_t last_ns;           /**< Dernier signal du client (metrics_now_ns()) */
+};
+
+struct session *session_find(pid_t pid, int create);
+int session_push_bit(struct session *s, int bit);
+void session_release(struct session *s);
+int session_active(void);
+int session_journal_open(const char *path);
+int session_sweep(uint64_t now, uint64_t dead_after_ns, void (*deliver)(struct message_buffer *message));
+int session_recover(void (*deliver)(struct message_buffer *message), int *delivered);
+
+#endif
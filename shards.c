@@ -0,0 +1,120 @@
+/**
+ * @file shards.c
+ * @brief Découverte des workers du serveur et choix d'un shard par hachage cohérent
+ * @author silverhawks
+ * @date 06/01/25
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shards.h"
+
+/** @brief Mélange 64 bits (splitmix64) utilisé pour placer les points */
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Publie la liste des workers
+ * @return 0 en cas de succès, -1 sinon
+ *
+ * Le fichier est écrit sous un nom temporaire puis renommé : un client ne
+ * lit jamais une liste incomplète.
+ */
+int shards_write(const char *path, const pid_t *pids, int count) {
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *out = fopen(tmp_path, "w");
+    if (!out) {
+        return -1;
+    }
+    fprintf(out, "# indice PID\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%d %d\n", i, (int)pids[i]);
+    }
+    fclose(out);
+    return rename(tmp_path, path);
+}
+
+/**
+ * @brief Lit le fichier de découverte
+ * @return Nombre de workers lus, -1 si le fichier est illisible
+ */
+int shards_read(const char *path, struct shard_map *map) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        return -1;
+    }
+    memset(map, 0, sizeof(*map));
+    char line[128];
+    int index, pid;
+    while (fgets(line, sizeof(line), in)) {
+        if (line[0] == '#' || sscanf(line, "%d %d", &index, &pid) != 2) {
+            continue;
+        }
+        if (index >= 0 && index < SHARDS_MAX && pid > 0) {
+            map->pids[index] = pid;
+            if (index + 1 > map->count) {
+                map->count = index + 1;
+            }
+        }
+    }
+    fclose(in);
+    return map->count;
+}
+
+struct ring_point {
+    uint64_t hash;
+    int shard;
+};
+
+static int compare_points(const void *a, const void *b) {
+    uint64_t ha = ((const struct ring_point *)a)->hash;
+    uint64_t hb = ((const struct ring_point *)b)->hash;
+    return ha < hb ? -1 : ha > hb;
+}
+
+/**
+ * @brief Choisit un shard pour une clé (le PID du client)
+ * @return Indice du shard, -1 si aucun worker n'est disponible
+ *
+ * La clé est attribuée au premier point de l'anneau qui la suit.
+ */
+int shards_pick(const struct shard_map *map, uint64_t key) {
+    struct ring_point *points = malloc(sizeof(*points) * SHARD_VNODES * (map->count + 1));
+    int n = 0;
+    for (int s = 0; s < map->count; s++) {
+        if (map->pids[s] <= 0) {
+            continue;
+        }
+        for (int v = 0; v < SHARD_VNODES; v++) {
+            points[n].hash = mix64(((uint64_t)s << 32) | v);
+            points[n].shard = s;
+            n++;
+        }
+    }
+    if (n == 0) {
+        free(points);
+        return -1;
+    }
+    qsort(points, n, sizeof(*points), compare_points);
+
+    uint64_t h = mix64(key);
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (points[mid].hash < h) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    int shard = points[lo % n].shard;
+    free(points);
+    return shard;
+}
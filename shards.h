@@ -0,0 +1,38 @@
+/**
+ * @file shards.h
+ * @brief Découverte des workers du serveur et choix d'un shard par hachage cohérent
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * En mode multi-processus, le superviseur publie la liste de ses workers
+ * dans un fichier de découverte (une ligne "indice PID" par worker). Un
+ * client choisit son worker en hachant son propre PID sur un anneau de
+ * hachage cohérent construit à partir des indices de shard : le
+ * redémarrage d'un worker (nouveau PID, même indice) ne déplace aucun
+ * client, et l'ajout d'un shard n'en déplace qu'une fraction.
+ */
+
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/** @brief Fichier de découverte par défaut */
+#define SHARDS_FILE "server_shards.txt"
+/** @brief Nombre maximal de workers */
+#define SHARDS_MAX 256
+/** @brief Nombre de points de chaque shard sur l'anneau de hachage */
+#define SHARD_VNODES 64
+
+/** @brief Liste des workers, indexée par indice de shard (0 = absent) */
+struct shard_map {
+    int count;
+    pid_t pids[SHARDS_MAX];
+};
+
+int shards_write(const char *path, const pid_t *pids, int count);
+int shards_read(const char *path, struct shard_map *map);
+int shards_pick(const struct shard_map *map, uint64_t key);
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * @file supervisor.c
+ * @brief Mode multi-processus du serveur : un superviseur et N workers
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Le superviseur crée les workers avec fork(), fixe chacun sur un des CPU
+ * permis au processus et publie leurs PID dans le fichier de découverte lu
+ * par les clients, une fois qu'ils sont prêts (supervisor_ready()) : un
+ * signal du protocole reçu avant l'installation du gestionnaire tuerait le
+ * worker. Un worker qui meurt (signal ou code de sortie non nul)
+ * est relancé avec le même indice de shard, pour que les clients qui lui
+ * étaient attribués le restent ; un worker arrêté proprement ne l'est pas.
+ *
+ * Les workers ignorent SIGINT : le Ctrl-C du terminal, envoyé à tout le
+ * groupe de processus, n'arrête que le superviseur, qui leur transmet un
+ * seul SIGTERM. Un second signal ferait abandonner à un worker son arrêt
+ * propre (voir drain() dans server.c).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "supervisor.h"
+#include "shards.h"
+
+/** @brief Délai avant de relancer un worker mort (évite de boucler sur une erreur) */
+#define RESPAWN_DELAY_US 500000
+/** @brief Temps laissé aux workers après leur délai d'arrêt avant SIGKILL (ms) */
+#define STOP_MARGIN_MS 2000
+/** @brief Intervalle entre deux vérifications de la fin des workers (µs) */
+#define STOP_POLL_US 10000
+
+/** @brief Signaux d'arrêt reçus : le second tue les workers sans attendre */
+static volatile sig_atomic_t stop_requested = 0;
+
+/** @brief Dans un worker : tube où annoncer qu'il est prêt (-1 : déjà fait) */
+static int ready_fd = -1;
+
+static void stop_handler(int sig) {
+    (void)sig;
+    stop_requested++;
+}
+
+/**
+ * @brief Annonce au superviseur que le worker peut recevoir des clients
+ *
+ * À appeler une fois les gestionnaires de signaux installés ; sans effet
+ * hors d'un worker.
+ */
+void supervisor_ready(void) {
+    if (ready_fd >= 0) {
+        char ready = 1;
+        if (write(ready_fd, &ready, 1) != 1) {
+            perror("Annonce au superviseur");
+        }
+        close(ready_fd);
+        ready_fd = -1;
+    }
+}
+
+/**
+ * @brief Attend qu'un worker soit prêt
+ * @param fd Extrémité du tube côté superviseur, fermée ici
+ * @return 1 si le worker est prêt, 0 s'il s'est arrêté avant ou si l'arrêt
+ *         du superviseur a été demandé
+ */
+static int wait_ready(int fd) {
+    char ready;
+    ssize_t n;
+    while ((n = read(fd, &ready, 1)) < 0 && errno == EINTR && !stop_requested) {
+    }
+    close(fd);
+    return n == 1;
+}
+
+/**
+ * @brief Crée le worker d'indice shard
+ * @param ready Reçoit, dans le superviseur, le tube à passer à wait_ready()
+ * @return PID du worker dans le superviseur, 0 dans le worker
+ */
+static pid_t spawn_worker(int shard, int *ready) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        fds[0] = fds[1] = -1;
+    }
+    pid_t pid = fork();
+    if (pid != 0) {
+        close(fds[1]);
+        *ready = fds[0];
+        return pid;
+    }
+    close(fds[0]);
+    ready_fd = fds[1];
+
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+
+    // Le shard-ième CPU permis (taskset, cgroup), en bouclant
+    cpu_set_t allowed, set;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+        perror("sched_getaffinity");
+        return 0;
+    }
+    int rank = shard % CPU_COUNT(&allowed), cpu = 0;
+    for (; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed) && rank-- == 0) {
+            break;
+        }
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+        printf("Worker %d (PID %d) fixé sur le CPU %d\n", shard, getpid(), cpu);
+    } else {
+        perror("sched_setaffinity");
+    }
+    return 0;
+}
+
+/**
+ * @brief Lance les workers et les surveille
+ * @param workers Nombre de workers à créer
+ * @param shards_path Fichier de découverte à publier
+ * @param drain_timeout_ms Délai d'arrêt propre des workers (delai_arret_ms)
+ * @return Dans un worker : son indice de shard (le worker continue le
+ *         démarrage normal du serveur). Dans le superviseur : -1 quand
+ *         l'arrêt a été demandé par SIGINT ou SIGTERM.
+ *
+ * À l'arrêt, chaque worker reçoit SIGTERM et a drain_timeout_ms (plus
+ * STOP_MARGIN_MS pour écrire son log et son journal) pour se terminer ;
+ * ceux qui restent sont tués par SIGKILL.
+ */
+int supervisor_run(int workers, const char *shards_path, unsigned drain_timeout_ms) {
+    pid_t pids[SHARDS_MAX];
+    if (workers > SHARDS_MAX) {
+        workers = SHARDS_MAX;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    fflush(stdout);
+    int ready[SHARDS_MAX];
+    for (int i = 0; i < workers; i++) {
+        pids[i] = spawn_worker(i, &ready[i]);
+        if (pids[i] == 0) {
+            return i;
+        }
+    }
+    for (int i = 0; i < workers; i++) {
+        wait_ready(ready[i]);  // Un worker mort avant sera relancé
+    }
+    shards_write(shards_path, pids, workers);
+    printf("Superviseur PID %d : %d workers publiés dans %s\n", getpid(), workers, shards_path);
+    fflush(stdout);
+
+    while (!stop_requested) {
+        int status;
+        pid_t dead = waitpid(-1, &status, 0);
+        if (dead < 0) {
+            if (errno != EINTR) {
+                break;
+            }
+            continue;
+        }
+        for (int i = 0; i < workers; i++) {
+            if (pids[i] != dead) {
+                continue;
+            }
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                printf("Worker %d (PID %d) arrêté proprement\n", i, dead);
+                fflush(stdout);
+                pids[i] = 0;
+                break;
+            }
+            printf("Worker %d (PID %d) terminé, relance...\n", i, dead);
+            fflush(stdout);
+            usleep(RESPAWN_DELAY_US);
+            if (stop_requested) {
+                break;
+            }
+            int ready_pipe;
+            pids[i] = spawn_worker(i, &ready_pipe);
+            if (pids[i] == 0) {
+                return i;
+            }
+            if (wait_ready(ready_pipe)) {
+                shards_write(shards_path, pids, workers);
+            }
+        }
+    }
+
+    int running = 0;
+    for (int i = 0; i < workers; i++) {
+        if (pids[i] > 0 && kill(pids[i], SIGTERM) == 0) {
+            running++;
+        }
+    }
+    long waited_us = 0, deadline_us = ((long)drain_timeout_ms + STOP_MARGIN_MS) * 1000;
+    while (running > 0 && waited_us < deadline_us && stop_requested < 2) {
+        pid_t dead = waitpid(-1, NULL, WNOHANG);
+        if (dead > 0) {
+            running--;
+        } else if (dead < 0 && errno == ECHILD) {
+            break;
+        } else {
+            usleep(STOP_POLL_US);
+            waited_us += STOP_POLL_US;
+        }
+    }
+    if (running > 0) {
+        printf("Superviseur : %d workers encore actifs, arrêt forcé\n", running);
+        fflush(stdout);
+        for (int i = 0; i < workers; i++) {
+            if (pids[i] > 0) {
+                kill(pids[i], SIGKILL);
+            }
+        }
+    }
+    while (wait(NULL) > 0) {
+    }
+    unlink(shards_path);
+    return -1;
+}
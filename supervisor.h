@@ -0,0 +1,14 @@
+/**
+ * @file supervisor.h
+ * @brief Mode multi-processus du serveur : un superviseur et N workers
+ * @author silverhawks
+ * @date 06/01/25
+ */
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+int supervisor_run(int workers, const char *shards_path, unsigned drain_timeout_ms);
+void supervisor_ready(void);
+
+#endif
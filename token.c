@@ -0,0 +1,226 @@
+/**
+ * @file token.c
+ * @brief Découpage d'un texte en mots
+ * @author silverhawks
+ * @date 06/01/25
+ */
+
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "token.h"
+
+/**
+ * @brief Classe de chaque octet
+ *
+ * 0xC2 (U+0080 à U+00BF), les octets de suite, 0xC0, 0xC1 et 0xF5 à 0xFF
+ * sont des séparateurs.
+ */
+const uint8_t token_class[256] = {
+    ['0' ... '9'] = TOKEN_WORD,
+    ['A' ... 'Z'] = TOKEN_WORD,
+    ['a' ... 'z'] = TOKEN_WORD,
+    [0xC3 ... 0xDF] = TOKEN_LEAD2,
+    [0xE0 ... 0xE1] = TOKEN_LEAD3,
+    [0xE2 ... 0xE3] = TOKEN_MIXED3,
+    [0xE4 ... 0xEF] = TOKEN_LEAD3,
+    [0xF0 ... 0xF4] = TOKEN_LEAD4,
+};
+
+static inline int continuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Longueur d'une lettre UTF-8 multi-octets
+ * @param available Octets disponibles à partir de s
+ * @return 2 à 4, ou 0 si le caractère est une ponctuation, un symbole ou
+ *         une séquence invalide (tronquée, trop longue, surrogate)
+ */
+size_t token_utf8_width(const unsigned char *s, size_t available) {
+    switch (token_class[s[0]]) {
+        case TOKEN_LEAD2:
+            if (available < 2 || !continuation(s[1])) {
+                return 0;
+            }
+            // × (U+00D7) et ÷ (U+00F7)
+            return s[0] == 0xC3 && (s[1] == 0x97 || s[1] == 0xB7) ? 0 : 2;
+        case TOKEN_MIXED3:
+            if (available < 3 || !continuation(s[1]) || !continuation(s[2])) {
+                return 0;
+            }
+            // U+2000 à U+2BFF, U+3000 à U+303F
+            return (s[0] == 0xE2 && s[1] < 0xB0) || (s[0] == 0xE3 && s[1] == 0x80) ? 0 : 3;
+        case TOKEN_LEAD3:
+            if (available < 3 || !continuation(s[1]) || !continuation(s[2]) ||
+                (s[0] == 0xE0 && s[1] < 0xA0) || (s[0] == 0xED && s[1] >= 0xA0)) {
+                return 0;
+            }
+            return 3;
+        case TOKEN_LEAD4:
+            if (available < 4 || !continuation(s[1]) || !continuation(s[2]) || !continuation(s[3]) ||
+                (s[0] == 0xF0 && s[1] < 0x90) || (s[0] == 0xF4 && s[1] >= 0x90)) {
+                return 0;
+            }
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Découpe un texte en mots, par lots
+ * @param pos Position de départ, avancée après le dernier mot rendu
+ * @param spans Mots trouvés (max au plus)
+ * @return Nombre de mots rangés dans spans ; moins de max quand le texte
+ *         est fini
+ *
+ * Même découpage que token_next(), plus rapide sur les longs textes : les
+ * blocs de 64 octets sont classés d'un coup (SSE2) en un masque dont les
+ * changements de bit donnent les débuts et fins de mots. Les blocs ASCII
+ * ou dont les seuls caractères non ASCII sont des lettres latines de 2
+ * octets (cas courant en français, allemand, espagnol) passent par ce
+ * chemin ; les autres sont traités caractère par caractère.
+ */
+size_t token_split(const char *text, size_t length, size_t *pos, struct token_span *spans, size_t max) {
+    const unsigned char *s = (const unsigned char *)text;
+    size_t count = 0;
+    size_t i = *pos;
+    size_t start = 0;
+    int in_word = 0;
+    if (max == 0) {
+        return 0;
+    }
+
+    while (i < length) {
+#ifdef __SSE2__
+        if (i + 64 <= length) {
+            uint64_t word = 0, high = 0, cont = 0, lead = 0, c3 = 0, sign = 0;
+            for (int k = 0; k < 4; k++) {
+                __m128i c = _mm_loadu_si128((const __m128i *)(s + i + k * 16));
+                __m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+                __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                              _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), c));
+                __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+                                               _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), l));
+                // Octets signés : 0xC3 à 0xDF valent -61 à -33
+                __m128i lead2 = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(-62)),
+                                              _mm_cmpgt_epi8(_mm_set1_epi8(-32), c));
+                __m128i suite = _mm_cmpeq_epi8(_mm_and_si128(c, _mm_set1_epi8(-64)), _mm_set1_epi8(-128));
+                __m128i times = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(-105)),   // 0x97
+                                             _mm_cmpeq_epi8(c, _mm_set1_epi8(-73)));   // 0xB7
+                int shift = k * 16;
+                word |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(digit, letter)) << shift;
+                high |= (uint64_t)(uint16_t)_mm_movemask_epi8(c) << shift;
+                cont |= (uint64_t)(uint16_t)_mm_movemask_epi8(suite) << shift;
+                lead |= (uint64_t)(uint16_t)_mm_movemask_epi8(lead2) << shift;
+                c3 |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(-61))) << shift;
+                sign |= (uint64_t)(uint16_t)_mm_movemask_epi8(times) << shift;
+            }
+            // Octets non ASCII acceptés d'un coup : uniquement des lettres
+            // de 2 octets (0xC3 à 0xDF suivi d'un octet de suite), hors × et ÷
+            int letters2 = (high & ~cont) == lead && cont == lead << 1 && !(lead >> 63) &&
+                           !(c3 << 1 & sign);
+            if (high == 0 || letters2) {
+                word |= high;
+                // Débuts et fins de mots : changements de bit du masque
+                uint64_t previous = word << 1 | (uint64_t)in_word;
+                uint64_t starts = word & ~previous;
+                uint64_t ends = ~word & previous;
+                if (in_word && ends) {
+                    size_t at = i + __builtin_ctzll(ends);
+                    ends &= ends - 1;
+                    in_word = 0;
+                    spans[count++] = (struct token_span){start, at - start};
+                    if (count == max) {
+                        *pos = at;
+                        return count;
+                    }
+                }
+                while (ends) {
+                    size_t from = i + __builtin_ctzll(starts);
+                    size_t at = i + __builtin_ctzll(ends);
+                    starts &= starts - 1;
+                    ends &= ends - 1;
+                    spans[count++] = (struct token_span){from, at - from};
+                    if (count == max) {
+                        *pos = at;
+                        return count;
+                    }
+                }
+                if (starts) {
+                    start = i + __builtin_ctzll(starts);  // Mot continué au bloc suivant
+                    in_word = 1;
+                }
+                i += 64;
+                continue;
+            }
+        }
+        size_t end = i + 64 < length ? i + 64 : length;
+#else
+        size_t end = length;
+#endif
+        // Caractère par caractère
+        while (i < end) {
+            uint8_t c = token_class[s[i]];
+            size_t width = c == TOKEN_WORD ? 1 : c == TOKEN_SEPARATOR ? 0 : token_utf8_width(s + i, length - i);
+            if (width > 0 && !in_word) {
+                start = i;
+                in_word = 1;
+            } else if (width == 0 && in_word) {
+                spans[count++] = (struct token_span){start, i - start};
+                in_word = 0;
+                if (count == max) {
+                    *pos = i;
+                    return count;
+                }
+            }
+            i += width ? width : 1;
+        }
+    }
+    if (in_word) {
+        spans[count++] = (struct token_span){start, length - start};
+    }
+    *pos = length;
+    return count;
+}
+
+/**
+ * @brief Compare un mot à un mot en minuscules, sans tenir compte de la casse
+ * @param word Mot de référence, en minuscules
+ * @return 1 si les deux mots sont égaux, 0 sinon
+ */
+int token_equal(const char *text, const struct token_span *span, const char *word, size_t word_length) {
+    if (span->length != word_length) {
+        return 0;
+    }
+    const unsigned char *s = (const unsigned char *)text + span->start;
+    for (size_t i = 0; i < word_length; i++) {
+        if (token_fold(s, i) != (unsigned char)word[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Copie un mot en minuscules
+ * @param max Taille de out ; un mot plus long est coupé avant le premier
+ *            caractère qui dépasse
+ * @return Longueur copiée (sans terminateur)
+ */
+size_t token_lower(const char *text, const struct token_span *span, char *out, size_t max) {
+    const unsigned char *s = (const unsigned char *)text + span->start;
+    size_t n = span->length < max ? span->length : max;
+    if (n < span->length) {
+        while (n > 0 && (s[n] & 0xC0) == 0x80) {
+            n--;  // Pas de caractère UTF-8 coupé
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[i] = token_fold(s, i);
+    }
+    return n;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file token.h
+ * @brief Découpage d'un texte en mots
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un mot est une suite de lettres ou de chiffres ASCII et de caractères
+ * UTF-8 multi-octets, hors ponctuation et symboles (U+0080 à U+00BF, × et
+ * ÷, U+2000 à U+2BFF, U+3000 à U+303F) : espace insécable, guillemets « »,
+ * tirets et apostrophe typographiques, points de suspension... Les
+ * séquences UTF-8 invalides séparent les mots.
+ *
+ * Le découpage se fait en une passe, pilotée par la table token_class, et
+ * ne copie rien : chaque mot est rendu comme une position et une longueur
+ * dans le texte d'origine. token_next() rend un mot à la fois ;
+ * token_split(), à préférer sur les longs textes, les rend par lots.
+ */
+
+#ifndef TOKEN_H
+#define TOKEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Classe d'un octet dans token_class */
+enum token_class {
+    TOKEN_SEPARATOR,        /**< Espace, ponctuation, octet de suite isolé ou invalide */
+    TOKEN_WORD,             /**< Lettre ou chiffre ASCII */
+    TOKEN_LEAD2,            /**< Début d'une lettre de 2 octets */
+    TOKEN_LEAD3,            /**< Début d'une lettre de 3 octets */
+    TOKEN_LEAD4,            /**< Début d'une lettre de 4 octets */
+    TOKEN_MIXED3,           /**< Début d'un caractère de 3 octets, ponctuation selon le 2e octet */
+};
+
+/** @brief Mot trouvé dans un texte */
+struct token_span {
+    size_t start;           /**< Position du premier octet */
+    size_t length;          /**< Longueur en octets */
+};
+
+extern const uint8_t token_class[256];
+
+size_t token_utf8_width(const unsigned char *s, size_t available);
+
+/**
+ * @brief Cherche le mot suivant
+ * @param pos Position de départ, avancée après le mot trouvé
+ * @param span Mot trouvé
+ * @return 1 si un mot a été trouvé, 0 à la fin du texte
+ *
+ * Les lettres ASCII, de loin les plus fréquentes, sont traitées par la
+ * seule lecture de la table ; les caractères multi-octets passent par
+ * token_utf8_width(). Un séparateur multi-octets est sauté octet par
+ * octet : ses octets de suite sont eux-mêmes des séparateurs.
+ */
+static inline int token_next(const char *text, size_t length, size_t *pos, struct token_span *span) {
+    const unsigned char *s = (const unsigned char *)text;
+    size_t i = *pos;
+
+    // Séparateurs
+    while (1) {
+        while (i < length && token_class[s[i]] == TOKEN_SEPARATOR) {
+            i++;
+        }
+        if (i >= length) {
+            *pos = i;
+            return 0;
+        }
+        if (token_class[s[i]] == TOKEN_WORD || token_utf8_width(s + i, length - i) > 0) {
+            break;
+        }
+        i++;
+    }
+
+    // Mot
+    span->start = i;
+    while (i < length) {
+        uint8_t c = token_class[s[i]];
+        if (c == TOKEN_WORD) {
+            i++;
+        } else if (c == TOKEN_SEPARATOR) {
+            break;
+        } else {
+            size_t width = token_utf8_width(s + i, length - i);
+            if (width == 0) {
+                break;
+            }
+            i += width;
+        }
+    }
+    span->length = i - span->start;
+    *pos = i;
+    return 1;
+}
+
+/**
+ * @brief Octet i d'un mot mis en minuscules
+ *
+ * La casse est ignorée pour l'ASCII et les lettres accentuées latines
+ * (U+00C0 à U+00DE, hors ×) : la mise en minuscules garde la longueur.
+ */
+static inline unsigned char token_fold(const unsigned char *s, size_t i) {
+    unsigned char c = s[i];
+    if (c >= 'A' && c <= 'Z') {
+        return c + ('a' - 'A');
+    }
+    if (i > 0 && s[i - 1] == 0xC3 && c >= 0x80 && c <= 0x9E && c != 0x97) {
+        return c + 0x20;
+    }
+    return c;
+}
+
+size_t token_split(const char *text, size_t length, size_t *pos, struct token_span *spans, size_t max);
+int token_equal(const char *text, const struct token_span *span, const char *word, size_t word_length);
+size_t token_lower(const char *text, const struct token_span *span, char *out, size_t max);
+
+#endif
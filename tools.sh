@@ -0,0 +1 @@
+gcc ctl.c -o ctl && gcc trace2json.c trace.c -o trace2json && gcc replay.c -o replay && gcc -O2 search.c index.c token.c -o search && gcc -O2 train.c langue.c token.c -o train -pthread -lm
@@ -0,0 +1,188 @@
+/**
+ * @file trace.c
+ * @brief Traces binaires à faible coût du chemin critique
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un événement coûte une lecture du compteur de cycles, un ajout atomique
+ * sur l'indice de l'anneau du thread et l'écriture de 24 octets. Les anneaux
+ * écrasent les plus anciens événements : on garde toujours les
+ * TRACE_RING_SIZE derniers par thread.
+ *
+ * L'écriture d'un événement marque d'abord son numéro de séquence comme
+ * invalide puis le publie en dernier, ce qui permet au vidage de se faire
+ * pendant que les threads continuent d'écrire : les entrées en cours de
+ * réécriture sont simplement ignorées.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "trace.h"
+
+#define TRACE_SEQ_INVALID 0xFFFFFFFFu
+
+/** @brief Anneau d'événements d'un thread */
+struct trace_ring {
+    atomic_int used;
+    _Atomic uint32_t head;
+    struct trace_event events[TRACE_RING_SIZE];
+} __attribute__((aligned(64)));
+
+static struct trace_ring rings[TRACE_MAX_THREADS];
+static __thread struct trace_ring *thread_ring;
+
+static uint64_t base_ticks;
+static uint64_t base_ns;
+
+/** @brief Noms des types d'événements (utilisés par trace2json) */
+const char *trace_type_names[TRACE_TYPE_COUNT] = {
+    [TRACE_BIT_RECV] = "bit_recu",
+    [TRACE_ACK_SENT] = "ack_envoye",
+    [TRACE_QUIT_RECV] = "fin_recue",
+    [TRACE_CLASSIFY_BEGIN] = "detection_langue",
+    [TRACE_CLASSIFY_END] = "detection_langue",
+    [TRACE_LOG_BEGIN] = "ecriture_log",
+    [TRACE_LOG_END] = "ecriture_log",
+    [TRACE_BIT_SENT] = "bit_envoye",
+    [TRACE_ACK_RECV] = "ack_recu",
+    [TRACE_TIMEOUT] = "expiration",
+    [TRACE_QUIT_SENT] = "fin_envoyee",
+    [TRACE_PAUSE] = "pause",
+    [TRACE_RESUME] = "reprise",
+};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/** @brief Horodatage brut : compteur de cycles si disponible */
+static inline uint64_t read_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return monotonic_ns();
+#endif
+}
+
+/**
+ * @brief Mémorise le point de référence entre ticks et CLOCK_MONOTONIC
+ *
+ * À appeler au démarrage, avant le premier événement.
+ */
+void trace_init(void) {
+    base_ns = monotonic_ns();
+    base_ticks = read_ticks();
+}
+
+/** @brief Renvoie l'anneau du thread courant, réservé au premier appel */
+static struct trace_ring *get_ring(void) {
+    struct trace_ring *ring = thread_ring;
+    if (ring) {
+        return ring;
+    }
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&rings[i].used, &expected, 1)) {
+            thread_ring = &rings[i];
+            return thread_ring;
+        }
+    }
+    thread_ring = &rings[TRACE_MAX_THREADS - 1];
+    return thread_ring;
+}
+
+/**
+ * @brief Enregistre un événement dans l'anneau du thread courant
+ * @param type Type d'événement
+ * @param pid PID du correspondant (client ou serveur)
+ * @param arg Argument dépendant du type
+ *
+ * Utilisable depuis un gestionnaire de signal.
+ */
+void trace_event(enum trace_type type, int32_t pid, uint32_t arg) {
+    struct trace_ring *ring = get_ring();
+    uint32_t seq = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    struct trace_event *e = &ring->events[seq & (TRACE_RING_SIZE - 1)];
+
+    __atomic_store_n(&e->seq, TRACE_SEQ_INVALID, __ATOMIC_RELAXED);
+    atomic_signal_fence(memory_order_release);
+    e->ticks = read_ticks();
+    e->pid = pid;
+    e->type = type;
+    e->ring = (uint16_t)(ring - rings);
+    e->arg = arg;
+    __atomic_store_n(&e->seq, seq, __ATOMIC_RELEASE);
+}
+
+/** @brief Estime la fréquence du compteur de ticks depuis trace_init() */
+static double calibrate(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (monotonic_ns() - base_ns < 10000000ull) {
+        usleep(10000);
+    }
+    uint64_t ns = monotonic_ns();
+    uint64_t ticks = read_ticks();
+    return (double)(ticks - base_ticks) / (double)(ns - base_ns);
+#else
+    return 1.0;
+#endif
+}
+
+/**
+ * @brief Vide tous les anneaux dans un fichier de trace binaire
+ * @param path Chemin du fichier à écrire
+ * @return Nombre d'événements écrits, -1 en cas d'erreur
+ */
+int trace_dump(const char *path) {
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        return -1;
+    }
+
+    struct trace_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.pid = getpid();
+    header.base_ticks = base_ticks;
+    header.base_ns = base_ns;
+    header.ticks_per_ns = calibrate();
+    fwrite(&header, sizeof(header), 1, out);
+
+    uint32_t count = 0;
+    for (int r = 0; r < TRACE_MAX_THREADS; r++) {
+        if (!atomic_load(&rings[r].used)) {
+            continue;
+        }
+        uint32_t head = atomic_load_explicit(&rings[r].head, memory_order_acquire);
+        uint32_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        for (uint32_t seq = first; seq != head; seq++) {
+            struct trace_event *src = &rings[r].events[seq & (TRACE_RING_SIZE - 1)];
+            if (__atomic_load_n(&src->seq, __ATOMIC_ACQUIRE) != seq) {
+                continue;
+            }
+            struct trace_event copy = *src;
+            atomic_thread_fence(memory_order_acquire);
+            if (__atomic_load_n(&src->seq, __ATOMIC_RELAXED) != seq) {
+                continue;
+            }
+            copy.seq = seq;
+            fwrite(&copy, sizeof(copy), 1, out);
+            count++;
+        }
+    }
+
+    header.count = count;
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    fclose(out);
+    return count;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file trace.h
+ * @brief Traces binaires à faible coût du chemin critique
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Chaque thread enregistre ses événements dans son propre anneau circulaire
+ * en mémoire. Les anneaux sont toujours actifs et peuvent être vidés à la
+ * demande dans un fichier binaire, converti ensuite par trace2json en JSON
+ * pour le visualiseur de traces de Chrome.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/** @brief Types d'événements tracés */
+enum trace_type {
+    TRACE_BIT_RECV = 1,     /**< Serveur : bit reçu (arg = valeur du bit) */
+    TRACE_ACK_SENT,         /**< Serveur : ACK envoyé au client */
+    TRACE_QUIT_RECV,        /**< Serveur : fin de message reçue (arg = longueur) */
+    TRACE_CLASSIFY_BEGIN,   /**< Serveur : début de la détection de langue */
+    TRACE_CLASSIFY_END,     /**< Serveur : fin de la détection de langue */
+    TRACE_LOG_BEGIN,        /**< Serveur : début de l'écriture dans le log */
+    TRACE_LOG_END,          /**< Serveur : fin de l'écriture dans le log */
+    TRACE_BIT_SENT,         /**< Client : bit envoyé (arg = rang du bit) */
+    TRACE_ACK_RECV,         /**< Client : ACK reçu */
+    TRACE_TIMEOUT,          /**< Client : pas d'ACK avant l'expiration */
+    TRACE_QUIT_SENT,        /**< Client : fin de message envoyée */
+    TRACE_PAUSE,            /**< Client : pause demandée par le serveur (arg = durée en µs) */
+    TRACE_RESUME,           /**< Client : reprise après le retour du serveur (arg = rang du bit) */
+    TRACE_TYPE_COUNT
+};
+
+/** @brief Événement tel qu'il est stocké dans l'anneau et dans le fichier */
+struct trace_event {
+    uint64_t ticks;     /**< Horodatage brut (rdtsc ou nanosecondes) */
+    uint32_t seq;       /**< Numéro de séquence dans l'anneau */
+    int32_t pid;        /**< PID du correspondant */
+    uint16_t type;      /**< enum trace_type */
+    uint16_t ring;      /**< Anneau (thread) d'origine */
+    uint32_t arg;       /**< Argument dépendant du type */
+};
+
+/** @brief En-tête d'un fichier de trace */
+struct trace_header {
+    char magic[8];          /**< "MTTRACE1" */
+    int32_t pid;            /**< PID du processus tracé */
+    uint32_t count;         /**< Nombre d'événements qui suivent */
+    uint64_t base_ticks;    /**< Horodatage brut de référence */
+    uint64_t base_ns;       /**< CLOCK_MONOTONIC correspondant (ns) */
+    double ticks_per_ns;    /**< Conversion ticks -> nanosecondes */
+};
+
+#define TRACE_MAGIC "MTTRACE1"
+/** @brief Nombre d'événements par anneau (puissance de 2) */
+#define TRACE_RING_SIZE 4096
+/** @brief Nombre maximal de threads tracés */
+#define TRACE_MAX_THREADS 16
+
+extern const char *trace_type_names[TRACE_TYPE_COUNT];
+
+void trace_init(void);
+void trace_event(enum trace_type type, int32_t pid, uint32_t arg);
+int trace_dump(const char *path);
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file trace2json.c
+ * @brief Conversion des fichiers de trace en JSON pour le visualiseur Chrome
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Usage: ./trace2json FICHIER... > trace.json
+ *
+ * Plusieurs fichiers (par exemple celui du serveur et ceux des clients)
+ * peuvent être fusionnés : les horodatages sont ramenés sur CLOCK_MONOTONIC,
+ * commune à tous les processus de la machine. Le résultat s'ouvre dans
+ * chrome://tracing ou https://ui.perfetto.dev.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+/** @brief Contenu d'un fichier de trace chargé */
+struct trace_file {
+    struct trace_header header;
+    struct trace_event *events;
+};
+
+/** @brief Convertit un horodatage brut en nanosecondes CLOCK_MONOTONIC */
+static double event_ns(const struct trace_header *h, const struct trace_event *e) {
+    return h->base_ns + ((double)e->ticks - (double)h->base_ticks) / h->ticks_per_ns;
+}
+
+static int load(const char *path, struct trace_file *file) {
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return -1;
+    }
+    if (fread(&file->header, sizeof(file->header), 1, in) != 1 ||
+        memcmp(file->header.magic, TRACE_MAGIC, sizeof(file->header.magic)) != 0) {
+        fprintf(stderr, "%s : fichier de trace invalide\n", path);
+        fclose(in);
+        return -1;
+    }
+    file->events = malloc((file->header.count + 1) * sizeof(struct trace_event));
+    file->header.count = fread(file->events, sizeof(struct trace_event), file->header.count, in);
+    fclose(in);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s FICHIER... > trace.json\n", argv[0]);
+        return 1;
+    }
+
+    int file_count = argc - 1;
+    struct trace_file *files = calloc(file_count, sizeof(*files));
+    double origin = -1;
+    for (int f = 0; f < file_count; f++) {
+        if (load(argv[f + 1], &files[f]) != 0) {
+            return 1;
+        }
+        for (uint32_t i = 0; i < files[f].header.count; i++) {
+            double ns = event_ns(&files[f].header, &files[f].events[i]);
+            if (origin < 0 || ns < origin) {
+                origin = ns;
+            }
+        }
+    }
+
+    printf("{\"traceEvents\":[\n");
+    int first = 1;
+    for (int f = 0; f < file_count; f++) {
+        const struct trace_header *h = &files[f].header;
+        printf("%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s (PID %d)\"}}",
+               first ? "" : ",\n", h->pid, argv[f + 1], h->pid);
+        first = 0;
+
+        for (uint32_t i = 0; i < h->count; i++) {
+            const struct trace_event *e = &files[f].events[i];
+            if (e->type == 0 || e->type >= TRACE_TYPE_COUNT) {
+                continue;
+            }
+            const char *phase = "i";
+            if (e->type == TRACE_CLASSIFY_BEGIN || e->type == TRACE_LOG_BEGIN) {
+                phase = "B";
+            } else if (e->type == TRACE_CLASSIFY_END || e->type == TRACE_LOG_END) {
+                phase = "E";
+            }
+            printf(",\n{\"name\":\"%s\",\"ph\":\"%s\",%s\"ts\":%.3f,\"pid\":%d,\"tid\":%u,"
+                   "\"args\":{\"pid\":%d,\"arg\":%u,\"seq\":%u}}",
+                   trace_type_names[e->type], phase, phase[0] == 'i' ? "\"s\":\"t\"," : "",
+                   (event_ns(h, e) - origin) / 1000.0, h->pid, e->ring, e->pid, e->arg, e->seq);
+        }
+        free(files[f].events);
+    }
+    printf("\n]}\n");
+    free(files);
+    return 0;
+}
@@ -0,0 +1,722 @@
+/**
+ * @file train.c
+ * @brief Apprentissage des tables de détection de langue sur un corpus
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Usage: ./train [-j THREADS] [-o PROFIL] [-x LEXIQUE] [-v] [CORPUS]
+ * - CORPUS: dossier contenant un sous-dossier par langue (corpus/fr,
+ *   corpus/en...) de fichiers .txt, une phrase par ligne (défaut: corpus)
+ * - -j THREADS: nombre de threads (défaut: nombre de processeurs)
+ * - -o PROFIL: profil écrit (défaut: langue_profile.txt), à charger avec
+ *   ./server -p PROFIL ou ./bench_langue -p PROFIL
+ * - -x LEXIQUE: écrit aussi le lexique des messages courts, en C
+ *   (langue_lexique.h, compilé dans langue.c : recompiler ensuite)
+ * - -v: affiche le score des mots retenus
+ *
+ * Pour chaque langue, le profil donne la fréquence des lettres et les mots
+ * les plus discriminants : ceux présents dans la plus grande part des
+ * lignes de la langue, diminuée de leur part dans la langue où ils sont
+ * le plus fréquents ensuite. Un mot commun à deux langues n'aide pas à les
+ * départager et n'est donc pas retenu.
+ *
+ * Le lexique donne à chaque mot assez fréquent un poids par langue (log
+ * de sa part des lignes de la langue, centré) et le range dans une table
+ * à hachage parfait, dont les graines sont cherchées ici.
+ *
+ * Les fichiers sont projetés en mémoire et découpés en tranches de
+ * TRAIN_CHUNK octets (coupées en fin de ligne), réparties entre les
+ * threads. Chaque thread compte dans ses propres tables, fusionnées à la
+ * fin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "langue.h"
+#include "token.h"
+
+/** @brief Taille d'une tranche de fichier traitée par un thread */
+#define TRAIN_CHUNK (4 * 1024 * 1024)
+/** @brief Nombre maximal de fichiers du corpus */
+#define TRAIN_MAX_FILES 4096
+/** @brief Nombre maximal de threads */
+#define TRAIN_MAX_THREADS 64
+/** @brief Taille initiale d'une table de mots (puissance de 2) */
+#define TRAIN_TABLE_INITIAL 1024
+/** @brief Lignes minimales d'un mot dans sa langue pour entrer au lexique */
+#define LEXIQUE_MIN_LINES 2
+
+/** @brief Mot compté, rangé par sa clé (octets en minuscules, voir token_fold()) */
+struct word_count {
+    uint64_t key;           /**< 0 si la case est libre */
+    uint64_t lines;         /**< Lignes contenant le mot */
+    uint64_t last_line;     /**< Dernière ligne comptée (+1) */
+};
+
+/** @brief Table de hachage des mots d'une langue */
+struct word_table {
+    struct word_count *items;
+    size_t capacity;
+    size_t used;
+};
+
+/** @brief Comptes d'une langue */
+struct language_counts {
+    uint64_t letters[26];
+    uint64_t lines;
+    uint64_t bytes;
+    struct word_table words;
+};
+
+/** @brief Tranche de fichier à traiter */
+struct chunk {
+    int lang;
+    const char *data;       /**< Début du fichier projeté */
+    size_t size;            /**< Taille du fichier */
+    size_t start;
+    size_t end;
+};
+
+static struct chunk chunks[TRAIN_MAX_FILES * 8];
+static size_t chunk_count;
+static atomic_size_t next_chunk;
+
+/** @brief Comptes d'un thread */
+struct worker {
+    pthread_t thread;
+    struct language_counts counts[LANGUE_COUNT];
+    uint64_t line_id;
+};
+
+static inline uint32_t hash_key(uint64_t key) {
+    return (key * 0x9E3779B97F4A7C15ull) >> 32;
+}
+
+static int table_grow(struct word_table *t) {
+    size_t capacity = t->capacity ? t->capacity * 2 : TRAIN_TABLE_INITIAL;
+    struct word_count *items = calloc(capacity, sizeof(*items));
+    if (!items) {
+        return -1;
+    }
+    for (size_t i = 0; i < t->capacity; i++) {
+        if (t->items[i].key) {
+            size_t slot = hash_key(t->items[i].key) & (capacity - 1);
+            while (items[slot].key) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            items[slot] = t->items[i];
+        }
+    }
+    free(t->items);
+    t->items = items;
+    t->capacity = capacity;
+    return 0;
+}
+
+/** @brief Case d'un mot, créée si besoin ; NULL si la mémoire manque */
+static struct word_count *table_find(struct word_table *t, uint64_t key) {
+    if ((t->used + 1) * 4 > t->capacity * 3 && table_grow(t) != 0) {
+        return NULL;
+    }
+    size_t slot = hash_key(key) & (t->capacity - 1);
+    while (t->items[slot].key && t->items[slot].key != key) {
+        slot = (slot + 1) & (t->capacity - 1);
+    }
+    if (!t->items[slot].key) {
+        t->items[slot].key = key;
+        t->used++;
+    }
+    return &t->items[slot];
+}
+
+/** @brief Nombre de lignes contenant un mot, 0 s'il est absent */
+static uint64_t table_lines(const struct word_table *t, uint64_t key) {
+    if (t->capacity == 0) {
+        return 0;
+    }
+    size_t slot = hash_key(key) & (t->capacity - 1);
+    while (t->items[slot].key) {
+        if (t->items[slot].key == key) {
+            return t->items[slot].lines;
+        }
+        slot = (slot + 1) & (t->capacity - 1);
+    }
+    return 0;
+}
+
+/** @brief Compte les lettres et les mots d'une ligne */
+static void count_line(struct worker *w, struct language_counts *c, const char *line, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char l = (unsigned char)line[i] | 0x20;
+        if (l >= 'a' && l <= 'z' && ((unsigned char)line[i] & 0x80) == 0) {
+            c->letters[l - 'a']++;
+        }
+    }
+
+    uint64_t id = ++w->line_id;
+    struct token_span spans[64];
+    size_t pos = 0, count;
+    do {
+        count = token_split(line, length, &pos, spans, 64);
+        for (size_t k = 0; k < count; k++) {
+            if (spans[k].length > LANGUE_KEYWORD_MAX) {
+                continue;
+            }
+            const unsigned char *s = (const unsigned char *)line + spans[k].start;
+            uint64_t key = 0;
+            for (size_t i = 0; i < spans[k].length; i++) {
+                key = key << 8 | token_fold(s, i);
+            }
+            struct word_count *word = table_find(&c->words, key);
+            if (word && word->last_line != id) {
+                word->last_line = id;
+                word->lines++;
+            }
+        }
+    } while (count == 64);
+    c->lines++;
+}
+
+static void *work(void *arg) {
+    struct worker *w = arg;
+    size_t index;
+    while ((index = atomic_fetch_add(&next_chunk, 1)) < chunk_count) {
+        const struct chunk *ch = &chunks[index];
+        size_t start = ch->start, end = ch->end;
+        // Les lignes à cheval appartiennent à la tranche où elles commencent
+        if (start > 0 && ch->data[start - 1] != '\n') {
+            const char *nl = memchr(ch->data + start, '\n', ch->size - start);
+            start = nl ? (size_t)(nl - ch->data) + 1 : ch->size;
+        }
+        if (end < ch->size && ch->data[end - 1] != '\n') {
+            const char *nl = memchr(ch->data + end, '\n', ch->size - end);
+            end = nl ? (size_t)(nl - ch->data) + 1 : ch->size;
+        }
+        struct language_counts *c = &w->counts[ch->lang];
+        c->bytes += end > start ? end - start : 0;
+        while (start < end) {
+            const char *nl = memchr(ch->data + start, '\n', end - start);
+            size_t length = nl ? (size_t)(nl - ch->data) - start : end - start;
+            if (length > 0 && ch->data[start + length - 1] == '\r') {
+                length--;
+            }
+            if (length > 0) {
+                count_line(w, c, ch->data + start, length);
+            }
+            start = nl ? (size_t)(nl - ch->data) + 1 : end;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Projette les fichiers .txt d'une langue et les découpe en tranches
+ * @return Nombre de fichiers ajoutés
+ */
+static int add_language(const char *dir, int lang, int *files) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, language_codes[lang]);
+    DIR *d = opendir(path);
+    if (!d) {
+        perror(path);
+        return 0;
+    }
+    int added = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL && *files < TRAIN_MAX_FILES) {
+        size_t name_len = strlen(entry->d_name);
+        if (name_len < 4 || strcmp(entry->d_name + name_len - 4, ".txt") != 0) {
+            continue;
+        }
+        char file_path[8192];
+        snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+        int fd = open(file_path, O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            perror(file_path);
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+        if (st.st_size == 0) {
+            close(fd);
+            continue;
+        }
+        const char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            perror(file_path);
+            continue;
+        }
+        madvise((void *)data, st.st_size, MADV_SEQUENTIAL);
+        for (size_t start = 0; start < (size_t)st.st_size &&
+                               chunk_count < sizeof(chunks) / sizeof(chunks[0]); start += TRAIN_CHUNK) {
+            size_t end = start + TRAIN_CHUNK < (size_t)st.st_size ? start + TRAIN_CHUNK : (size_t)st.st_size;
+            chunks[chunk_count++] = (struct chunk){lang, data, st.st_size, start, end};
+        }
+        (*files)++;
+        added++;
+    }
+    closedir(d);
+    return added;
+}
+
+/** @brief Mot candidat et son score */
+struct candidate {
+    uint64_t key;
+    double score;
+};
+
+static int compare_candidates(const void *a, const void *b) {
+    const struct candidate *x = a, *y = b;
+    if (x->score != y->score) {
+        return x->score < y->score ? 1 : -1;
+    }
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+/** @brief Écrit le mot d'une clé */
+static void key_to_word(uint64_t key, char *word) {
+    int n = 0;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        unsigned char c = key >> shift;
+        if (c || n > 0) {
+            word[n++] = c;
+        }
+    }
+    word[n] = '\0';
+}
+
+/**
+ * @brief Choisit les mots les plus discriminants d'une langue
+ * @return Nombre de mots retenus (au plus LANGUE_KEYWORDS)
+ */
+static int select_keywords(struct language_counts *counts, int lang, struct candidate *best) {
+    const struct word_table *t = &counts[lang].words;
+    int found = 0;
+    for (size_t i = 0; i < t->capacity; i++) {
+        const struct word_count *w = &t->items[i];
+        if (!w->key) {
+            continue;
+        }
+        double share = (double)w->lines / counts[lang].lines;
+        double other = 0;
+        for (int o = 0; o < LANGUE_COUNT; o++) {
+            if (o != lang && counts[o].lines > 0) {
+                double s = (double)table_lines(&counts[o].words, w->key) / counts[o].lines;
+                other = s > other ? s : other;
+            }
+        }
+        struct candidate c = {w->key, share - other};
+        if (c.score <= 0) {
+            continue;
+        }
+        // Insertion dans les LANGUE_KEYWORDS meilleurs
+        if (found < LANGUE_KEYWORDS) {
+            best[found++] = c;
+        } else if (compare_candidates(&c, &best[LANGUE_KEYWORDS - 1]) < 0) {
+            best[LANGUE_KEYWORDS - 1] = c;
+        } else {
+            continue;
+        }
+        qsort(best, found, sizeof(*best), compare_candidates);
+    }
+    return found;
+}
+
+/** @brief Mot du lexique des messages courts */
+struct lexicon_word {
+    uint64_t key;
+    int weights[LANGUE_COUNT];  /**< En LANGUE_LEXIQUE_UNIT par nat */
+    int spread;                 /**< Écart entre les deux meilleurs poids */
+};
+
+static int compare_lexicon(const void *a, const void *b) {
+    const struct lexicon_word *x = a, *y = b;
+    if (x->spread != y->spread) {
+        return y->spread - x->spread;
+    }
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+/**
+ * @brief Choisit les mots du lexique
+ * @return Nombre de mots retenus (au plus LANGUE_LEXIQUE_MAX), -1 si la
+ * mémoire manque
+ *
+ * Le poids d'un mot pour une langue est le log de sa part (lissée) des
+ * lignes de la langue, moins la moyenne sur les langues : la somme des
+ * poids des mots d'un message est sa log-vraisemblance relative, à une
+ * constante près. Un mot vu dans moins de LEXIQUE_MIN_LINES lignes de
+ * chaque langue n'est pas retenu : son poids serait appris par cœur. Les
+ * mots qui départagent le mieux deux langues passent en premier.
+ */
+static int select_lexicon(struct language_counts *counts, struct lexicon_word **out) {
+    size_t capacity = 0;
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        capacity += counts[lang].words.used;
+    }
+    struct lexicon_word *words = malloc((capacity ? capacity : 1) * sizeof(*words));
+    if (!words) {
+        return -1;
+    }
+    size_t found = 0;
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        const struct word_table *t = &counts[lang].words;
+        for (size_t i = 0; i < t->capacity; i++) {
+            uint64_t key = t->items[i].key;
+            if (!key) {
+                continue;
+            }
+            uint64_t lines[LANGUE_COUNT], most = 0;
+            int seen_before = 0;
+            for (int o = 0; o < LANGUE_COUNT; o++) {
+                lines[o] = table_lines(&counts[o].words, key);
+                most = lines[o] > most ? lines[o] : most;
+                seen_before |= o < lang && lines[o] > 0;
+            }
+            if (seen_before || most < LEXIQUE_MIN_LINES) {
+                continue;  // Déjà vu dans une langue précédente, ou trop rare
+            }
+            double logs[LANGUE_COUNT], mean = 0;
+            for (int o = 0; o < LANGUE_COUNT; o++) {
+                logs[o] = log((lines[o] + 0.5) / (counts[o].lines + 1.0));
+                mean += logs[o] / LANGUE_COUNT;
+            }
+            struct lexicon_word *w = &words[found++];
+            w->key = key;
+            int first = -128, second = -128;
+            for (int o = 0; o < LANGUE_COUNT; o++) {
+                long v = lround((logs[o] - mean) * LANGUE_LEXIQUE_UNIT);
+                w->weights[o] = v < -127 ? -127 : v > 127 ? 127 : (int)v;
+                if (w->weights[o] > first) {
+                    second = first;
+                    first = w->weights[o];
+                } else if (w->weights[o] > second) {
+                    second = w->weights[o];
+                }
+            }
+            w->spread = first - second;
+        }
+    }
+    qsort(words, found, sizeof(*words), compare_lexicon);
+    *out = words;
+    return found < LANGUE_LEXIQUE_MAX ? (int)found : LANGUE_LEXIQUE_MAX;
+}
+
+/** @brief Taille maximale de la table du lexique et de ses seaux (bits) */
+#define LEXIQUE_SLOT_BITS_MAX 14
+#define LEXIQUE_BUCKET_BITS_MAX 12
+
+/**
+ * @brief Cherche les graines du hachage parfait du lexique
+ * @param slot_bits Reçoit le nombre de bits des cases
+ * @param bucket_bits Reçoit le nombre de bits des seaux
+ * @param seeds Graine de chaque seau (1 << LEXIQUE_BUCKET_BITS_MAX cases)
+ * @param slots Mot de chaque case, -1 si libre (1 << LEXIQUE_SLOT_BITS_MAX
+ * cases)
+ * @return 0 en cas de succès, -1 si aucune table ne convient
+ *
+ * Les seaux sont placés du plus plein au plus vide : pour chacun, la
+ * première graine qui envoie tous ses mots dans des cases libres et
+ * distinctes est retenue. Sans graine pour un seau, la table est agrandie.
+ */
+static int build_lexicon_hash(const struct lexicon_word *words, int count, int *slot_bits,
+                              int *bucket_bits, uint8_t *seeds, int *slots) {
+    int sb = 1, bb = 1;
+    while ((1 << sb) < count + count / 4) {
+        sb++;
+    }
+    while ((1 << bb) < count / 2) {
+        bb++;
+    }
+    for (; sb <= LEXIQUE_SLOT_BITS_MAX && bb <= LEXIQUE_BUCKET_BITS_MAX; sb++, bb++) {
+        int buckets = 1 << bb, size = 1 << sb;
+        int *order = malloc(count * sizeof(*order));
+        int *bucket_size = calloc(buckets, sizeof(*bucket_size));
+        if (!order || !bucket_size) {
+            free(order);
+            free(bucket_size);
+            return -1;
+        }
+        memset(seeds, 0, buckets);
+        for (int i = 0; i < size; i++) {
+            slots[i] = -1;
+        }
+        for (int i = 0; i < count; i++) {
+            bucket_size[langue_lexique_bucket(words[i].key, bb)]++;
+        }
+        int failed = 0;
+        // Seaux du plus plein au plus vide (LANGUE_LEXIQUE_MAX mots au plus)
+        for (int fill = count; fill > 0 && !failed; fill--) {
+            for (int b = 0; b < buckets && !failed; b++) {
+                if (bucket_size[b] != fill) {
+                    continue;
+                }
+                int n = 0;
+                for (int i = 0; i < count; i++) {
+                    if ((int)langue_lexique_bucket(words[i].key, bb) == b) {
+                        order[n++] = i;
+                    }
+                }
+                int seed;
+                for (seed = 0; seed < 256; seed++) {
+                    int ok = 1;
+                    for (int k = 0; k < n && ok; k++) {
+                        uint32_t slot = langue_lexique_slot(words[order[k]].key, seed, sb);
+                        ok = slots[slot] < 0;
+                        for (int j = 0; j < k && ok; j++) {
+                            ok = langue_lexique_slot(words[order[j]].key, seed, sb) != slot;
+                        }
+                    }
+                    if (ok) {
+                        break;
+                    }
+                }
+                if (seed == 256) {
+                    failed = 1;
+                    break;
+                }
+                seeds[b] = seed;
+                for (int k = 0; k < n; k++) {
+                    slots[langue_lexique_slot(words[order[k]].key, seed, sb)] = order[k];
+                }
+            }
+        }
+        free(order);
+        free(bucket_size);
+        if (!failed) {
+            *slot_bits = sb;
+            *bucket_bits = bb;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Écrit le lexique des messages courts en C
+ * @return Nombre de mots écrits, -1 en cas d'erreur (affichée)
+ */
+static int write_lexicon(struct language_counts *counts, const char *corpus_dir, const char *path) {
+    struct lexicon_word *words;
+    int count = select_lexicon(counts, &words);
+    if (count < 0) {
+        fprintf(stderr, "Mémoire insuffisante\n");
+        return -1;
+    }
+    static uint8_t seeds[1 << LEXIQUE_BUCKET_BITS_MAX];
+    static int slots[1 << LEXIQUE_SLOT_BITS_MAX];
+    int slot_bits, bucket_bits;
+    if (build_lexicon_hash(words, count, &slot_bits, &bucket_bits, seeds, slots) != 0) {
+        fprintf(stderr, "Aucune table de hachage parfait pour %d mots\n", count);
+        free(words);
+        return -1;
+    }
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        free(words);
+        return -1;
+    }
+    char codes[64] = "";
+    for (int o = 0; o < LANGUE_COUNT; o++) {
+        snprintf(codes + strlen(codes), sizeof(codes) - strlen(codes), "%s%s", o ? ", " : "",
+                 language_codes[o]);
+    }
+    fprintf(out, "/**\n"
+                 " * @file langue_lexique.h\n"
+                 " * @brief Lexique des messages courts, généré par ./train -x (ne pas modifier)\n"
+                 " *\n"
+                 " * Corpus : %s. Poids de chaque mot par langue (%s), en\n"
+                 " * LANGUE_LEXIQUE_UNIT par nat ; inclus par langue.c seulement.\n"
+                 " */\n\n"
+                 "#ifndef LANGUE_LEXIQUE_H\n#define LANGUE_LEXIQUE_H\n\n",
+            corpus_dir, codes);
+    fprintf(out, "#define LEXIQUE_WORDS %d\n#define LEXIQUE_SLOT_BITS %d\n#define LEXIQUE_BUCKET_BITS %d\n\n",
+            count, slot_bits, bucket_bits);
+    fprintf(out, "static const uint8_t lexique_seeds[1 << LEXIQUE_BUCKET_BITS] = {");
+    for (int b = 0; b < 1 << bucket_bits; b++) {
+        fprintf(out, "%s%d,", b % 16 ? " " : "\n    ", seeds[b]);
+    }
+    fprintf(out, "\n};\n\nstatic const struct lexique_slot lexique_table[1 << LEXIQUE_SLOT_BITS] = {\n");
+    for (int i = 0; i < 1 << slot_bits; i++) {
+        if (slots[i] < 0) {
+            continue;
+        }
+        const struct lexicon_word *w = &words[slots[i]];
+        char word[LANGUE_KEYWORD_MAX + 1];
+        key_to_word(w->key, word);
+        fprintf(out, "    [%d] = {0x%llxull, {", i, (unsigned long long)w->key);
+        for (int o = 0; o < LANGUE_COUNT; o++) {
+            fprintf(out, "%s%d", o ? ", " : "", w->weights[o]);
+        }
+        fprintf(out, "}},  /* %s */\n", word);
+    }
+    fprintf(out, "};\n\n#endif\n");
+    free(words);
+    if (fclose(out) != 0) {
+        perror(path);
+        return -1;
+    }
+    return count;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    const char *corpus_dir = "corpus";
+    const char *output = LANGUE_PROFILE_FILE;
+    const char *lexicon = NULL;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int verbose = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:o:x:v")) != -1) {
+        if (opt == 'j') {
+            threads = atoi(optarg);
+        } else if (opt == 'o') {
+            output = optarg;
+        } else if (opt == 'x') {
+            lexicon = optarg;
+        } else if (opt == 'v') {
+            verbose = 1;
+        } else {
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind < argc) {
+        corpus_dir = argv[optind++];
+    }
+    if (optind != argc) {
+        printf("Usage: %s [-j THREADS] [-o PROFIL] [-x LEXIQUE] [-v] [CORPUS]\n", argv[0]);
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > TRAIN_MAX_THREADS) {
+        threads = TRAIN_MAX_THREADS;
+    }
+
+    double start = now_s();
+    int files = 0;
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        if (add_language(corpus_dir, lang, &files) == 0) {
+            fprintf(stderr, "Aucun fichier .txt pour la langue %s\n", language_codes[lang]);
+            return 1;
+        }
+    }
+
+    struct worker *workers = calloc(threads, sizeof(*workers));
+    if (!workers) {
+        fprintf(stderr, "Mémoire insuffisante\n");
+        return 1;
+    }
+    for (long i = 0; i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, work, &workers[i]) != 0) {
+            fprintf(stderr, "Impossible de créer les threads\n");
+            return 1;
+        }
+    }
+    for (long i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    // Fusion des comptes des threads dans ceux du premier
+    struct language_counts *counts = workers[0].counts;
+    uint64_t bytes = 0;
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        for (long i = 1; i < threads; i++) {
+            struct language_counts *c = &workers[i].counts[lang];
+            for (int l = 0; l < 26; l++) {
+                counts[lang].letters[l] += c->letters[l];
+            }
+            counts[lang].lines += c->lines;
+            counts[lang].bytes += c->bytes;
+            for (size_t k = 0; k < c->words.capacity; k++) {
+                if (c->words.items[k].key) {
+                    struct word_count *w = table_find(&counts[lang].words, c->words.items[k].key);
+                    if (w) {
+                        w->lines += c->words.items[k].lines;
+                    }
+                }
+            }
+        }
+        bytes += counts[lang].bytes;
+        if (counts[lang].lines == 0) {
+            fprintf(stderr, "Corpus vide pour la langue %s\n", language_codes[lang]);
+            return 1;
+        }
+    }
+    double counted = now_s();
+
+    FILE *out = fopen(output, "w");
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+    fprintf(out, "# Profil de langues miniteams, généré par train\n");
+    fprintf(out, "# Corpus : %s (%d fichiers, %.1f Mo)\n", corpus_dir, files, bytes / 1e6);
+    for (int lang = 0; lang < LANGUE_COUNT; lang++) {
+        uint64_t letters = 0;
+        for (int l = 0; l < 26; l++) {
+            letters += counts[lang].letters[l];
+        }
+        fprintf(out, "%s lettres", language_codes[lang]);
+        for (int l = 0; l < 26; l++) {
+            fprintf(out, " %.2f", letters ? 100.0 * counts[lang].letters[l] / letters : 0.0);
+        }
+        fprintf(out, "\n");
+
+        struct candidate best[LANGUE_KEYWORDS];
+        int found = select_keywords(counts, lang, best);
+        fprintf(out, "%s mots", language_codes[lang]);
+        if (verbose) {
+            printf("%s (%llu lignes) :", languages[lang], (unsigned long long)counts[lang].lines);
+        }
+        for (int k = 0; k < found; k++) {
+            char word[LANGUE_KEYWORD_MAX + 1];
+            key_to_word(best[k].key, word);
+            fprintf(out, " %s", word);
+            if (verbose) {
+                printf(" %s (%.2f)", word, best[k].score);
+            }
+        }
+        fprintf(out, "\n");
+        if (verbose) {
+            printf("\n");
+        }
+    }
+    if (fclose(out) != 0) {
+        perror(output);
+        return 1;
+    }
+
+    double elapsed = counted - start;
+    printf("%d fichiers, %.1f Mo lus en %.3f s (%.0f Mo/s, %ld threads) ; profil écrit dans %s\n",
+           files, bytes / 1e6, elapsed, elapsed > 0 ? bytes / 1e6 / elapsed : 0.0, threads, output);
+    if (lexicon) {
+        int words = write_lexicon(counts, corpus_dir, lexicon);
+        if (words < 0) {
+            return 1;
+        }
+        printf("Lexique : %d mots écrits dans %s (recompiler langue.c)\n", words, lexicon);
+    }
+    return 0;
+}
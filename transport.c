@@ -0,0 +1,318 @@
+/**
+ * @file transport.c
+ * @brief Boucle d'événements du serveur commune à tous les transports
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * La boucle surveille les descripteurs de tous les transports écoutés :
+ * socket d'écoute, connexions acceptées, tube nommé et eventfd du transport
+ * par signaux. Elle utilise io_uring quand le noyau le permet (voir
+ * transport_uring.c), epoll sinon : chaque descripteur prêt est alors
+ * confié au transport qui l'a enregistré.
+ *
+ * La boucle écrit aussi le log : les lignes ajoutées pendant le traitement
+ * d'un lot d'événements sont écrites en une fois, suivies d'un fdatasync,
+ * avant que la boucle ne se remette en attente.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+
+#include "transport.h"
+#include "transport_uring.h"
+#include "metrics.h"
+
+struct transport_fd transport_fds[TRANSPORT_MAX_FDS];
+int transport_fd_count = 0;
+int (*transport_fd_added)(int slot) = NULL;
+const char *transport_loop = "aucune";
+/** @brief Arrêt de la boucle demandé par transport_stop() */
+static atomic_int stop_requested = 0;
+
+/**
+ * @brief Lot de lignes de log écrit en une fois
+ *
+ * Le texte ajouté par la boucle (horodatage, langue...) est copié dans
+ * text ; les octets des messages ne le sont pas : le lot pointe dans leur
+ * tampon et en garde une référence jusqu'à la fin de l'écriture.
+ */
+struct log_batch {
+    char text[TRANSPORT_LOG_BATCH];
+    size_t text_used;
+    struct iovec iov[TRANSPORT_LOG_IOV];
+    int iov_count;
+    struct message_buffer *refs[TRANSPORT_LOG_IOV];
+    int ref_count;
+};
+
+/** @brief Lot en cours de remplissage et lot en cours d'écriture */
+static struct log_batch log_batches[2];
+static int log_current = 0;
+static int log_fd = -1;
+/** @brief Un lot est en cours d'écriture par io_uring */
+static int log_busy = 0;
+static int log_uring = 0;
+
+/**
+ * @brief Ajoute un descripteur à surveiller pour un transport
+ * @return 0 en cas de succès, -1 si la table est pleine
+ *
+ * Utilisable par un transport pendant listen() ou recv() (connexion
+ * acceptée), depuis le thread de la boucle.
+ */
+int transport_watch(struct transport *t, int fd) {
+    int slot = 0;
+    while (slot < transport_fd_count && transport_fds[slot].fd >= 0) {
+        slot++;
+    }
+    if (slot >= TRANSPORT_MAX_FDS) {
+        return -1;
+    }
+    transport_fds[slot].fd = fd;
+    transport_fds[slot].t = t;
+    if (slot == transport_fd_count) {
+        transport_fd_count++;
+    }
+    if (transport_fd_added && transport_fd_added(slot) != 0) {
+        transport_fds[slot].fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/** @brief Ferme un descripteur surveillé et libère sa case */
+void transport_unwatch(int slot) {
+    struct transport_fd *w = &transport_fds[slot];
+    if (w->fd != w->t->fd) {
+        close(w->fd);
+    }
+    w->fd = -1;
+    w->t = NULL;
+}
+
+/**
+ * @brief Demande l'arrêt de la boucle d'événements
+ *
+ * Utilisable depuis n'importe quel thread. La boucle s'arrête au début de
+ * son prochain lot, après avoir écrit tout le log en attente : il faut la
+ * réveiller (par un descripteur surveillé) si elle attend.
+ */
+void transport_stop(void) {
+    atomic_store(&stop_requested, 1);
+}
+
+/** @brief L'arrêt de la boucle a été demandé */
+int transport_stopping(void) {
+    return atomic_load_explicit(&stop_requested, memory_order_relaxed);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Log                                                                       */
+/* ------------------------------------------------------------------------- */
+
+/** @brief Fichier de log (ouvert en ajout) écrit par la boucle */
+void transport_log_open(int fd) {
+    log_fd = fd;
+}
+
+/** @brief Écrit un lot en entier, de façon synchrone */
+static void write_all(struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(log_fd, iov, count);  // count <= TRANSPORT_LOG_IOV
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Écriture du log");
+            return;
+        }
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+/** @brief Rend les tampons d'un lot écrit et le vide */
+static void batch_reset(struct log_batch *batch) {
+    for (int i = 0; i < batch->ref_count; i++) {
+        msgbuf_put(batch->refs[i]);
+    }
+    batch->ref_count = 0;
+    batch->iov_count = 0;
+    batch->text_used = 0;
+}
+
+/**
+ * @brief Ajoute un morceau de ligne au lot de log en cours
+ * @param data Octets à écrire
+ * @param length Nombre d'octets
+ * @param ref Tampon contenant data (pas de copie, une référence est prise
+ *            jusqu'à l'écriture), ou NULL pour copier data
+ *
+ * Le lot est écrit au plus tard à la fin du lot d'événements en cours
+ * (transport_log_flush()).
+ */
+void transport_log_append(const char *data, size_t length, struct message_buffer *ref) {
+    struct log_batch *batch = &log_batches[log_current];
+    if (batch->iov_count + 1 > TRANSPORT_LOG_IOV ||
+        (!ref && batch->text_used + length > TRANSPORT_LOG_BATCH)) {
+        if (log_uring && log_busy) {
+            transport_uring_log_wait();
+        }
+        transport_log_flush();
+        batch = &log_batches[log_current];
+    }
+    if (!ref && length > TRANSPORT_LOG_BATCH) {
+        return;  // Ne tient dans aucun lot : ignoré
+    }
+
+    struct iovec *last = batch->iov_count ? &batch->iov[batch->iov_count - 1] : NULL;
+    if (ref) {
+        batch->refs[batch->ref_count++] = msgbuf_ref(ref);
+        batch->iov[batch->iov_count++] = (struct iovec){(void *)data, length};
+        return;
+    }
+    char *dest = batch->text + batch->text_used;
+    memcpy(dest, data, length);
+    batch->text_used += length;
+    if (last && (char *)last->iov_base + last->iov_len == dest) {
+        last->iov_len += length;  // Suite du texte précédent
+    } else {
+        batch->iov[batch->iov_count++] = (struct iovec){dest, length};
+    }
+}
+
+/**
+ * @brief Écrit le lot de log en cours
+ *
+ * Avec io_uring, l'écriture et le fdatasync sont liés et asynchrones :
+ * un seul lot est en vol, les lignes suivantes s'accumulent dans l'autre
+ * lot et partent à la fin de l'écriture précédente.
+ */
+void transport_log_flush(void) {
+    struct log_batch *batch = &log_batches[log_current];
+    if (batch->iov_count == 0 || log_fd < 0) {
+        return;
+    }
+    if (log_uring) {
+        if (log_busy) {
+            return;
+        }
+        transport_uring_log_submit(log_fd, batch->iov, batch->iov_count);
+        log_busy = 1;
+        log_current ^= 1;
+    } else {
+        write_all(batch->iov, batch->iov_count);
+        fdatasync(log_fd);
+        batch_reset(batch);
+    }
+    metrics_inc(METRIC_LOG_FLUSHES);
+}
+
+/** @brief Fin de l'écriture d'un lot par io_uring */
+void transport_log_done(void) {
+    batch_reset(&log_batches[log_current ^ 1]);
+    log_busy = 0;
+    transport_log_flush();
+}
+
+/** @brief Écrit tout le log en attente, lot en vol compris (arrêt de la boucle) */
+void transport_log_finish(void) {
+    transport_log_flush();
+    while (log_uring && log_busy) {
+        transport_uring_log_wait();  // Écrit aussi le lot suivant s'il n'est pas vide
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Boucle epoll                                                              */
+/* ------------------------------------------------------------------------- */
+
+static int epoll_fd = -1;
+
+static int epoll_added(int slot) {
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = slot};
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, transport_fds[slot].fd, &ev);
+}
+
+static int epoll_run(transport_deliver deliver) {
+    struct epoll_event events[64];
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        return -1;
+    }
+    for (int slot = 0; slot < transport_fd_count; slot++) {
+        if (transport_fds[slot].fd >= 0 && epoll_added(slot) != 0) {
+            return -1;
+        }
+    }
+    transport_fd_added = epoll_added;
+    transport_loop = "epoll";
+
+    while (!transport_stopping()) {
+        transport_log_flush();
+        int n = epoll_wait(epoll_fd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        metrics_inc(METRIC_LOOP_WAKEUPS);
+        for (int i = 0; i < n; i++) {
+            int slot = events[i].data.u32;
+            struct transport *t = transport_fds[slot].t;
+            if (!t) {
+                continue;  // Fermé plus tôt dans ce lot
+            }
+            if (t->ops->recv(t, transport_fds[slot].fd, deliver) != 0) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, transport_fds[slot].fd, NULL);
+                transport_unwatch(slot);
+            }
+        }
+    }
+    transport_log_finish();
+    return 0;
+}
+
+/**
+ * @brief Boucle d'événements : rend les messages reçus sur tous les transports
+ * @param transports Transports déjà à l'écoute
+ * @param count Nombre de transports
+ * @param deliver Fonction appelée pour chaque message complet
+ * @return 0 après transport_stop(), -1 en cas d'erreur
+ *
+ * io_uring est utilisé s'il est disponible et que MINITEAMS_EPOLL n'est
+ * pas défini.
+ */
+int transport_run(struct transport **transports, int count, transport_deliver deliver) {
+    for (int i = 0; i < count; i++) {
+        if (transports[i]->fd >= 0 && transport_watch(transports[i], transports[i]->fd) != 0) {
+            return -1;
+        }
+    }
+
+    if (!getenv("MINITEAMS_EPOLL")) {
+        log_uring = 1;
+        if (transport_uring_run(deliver) == 0) {
+            return 0;
+        }
+        log_uring = 0;
+        if (errno != ENOSYS) {
+            return -1;
+        }
+    }
+    return epoll_run(deliver);
+}
@@ -0,0 +1,140 @@
+/**
+ * @file transport.h
+ * @brief Interface commune des moyens de transport des messages
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Un transport sait, côté client, se connecter à un serveur et lui envoyer
+ * un message ; côté serveur, écouter et rendre les messages complets reçus.
+ * L'affichage, la détection de langue et le log se font au-dessus de cette
+ * interface et ne dépendent donc pas du transport utilisé.
+ *
+ * Transports disponibles :
+ * - signal : protocole historique, bit par bit avec SIGUSR1/SIGUSR2/SIGQUIT
+ *   (adresse : PID du serveur) ;
+ * - unix : socket Unix SOCK_SEQPACKET, un paquet par message (adresse :
+ *   chemin de la socket) ;
+ * - fifo : tube nommé partagé par tous les clients, un enregistrement
+ *   atomique par message (adresse : chemin du tube).
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "msgbuf.h"
+
+/** @brief Le message arrive en une seule opération (pas de reconstitution) */
+#define TRANSPORT_CAP_MESSAGE   0x1
+/** @brief Chaque envoi est acquitté par le serveur */
+#define TRANSPORT_CAP_ACK       0x2
+/** @brief Le PID de l'émetteur est fourni par le noyau (non déclaratif) */
+#define TRANSPORT_CAP_PEER_PID  0x4
+/** @brief Le serveur peut répondre sur la connexion du client */
+#define TRANSPORT_CAP_REPLY     0x8
+/**
+ * @brief fd est une socket d'écoute dont chaque connexion acceptée porte
+ * un message par paquet : la boucle io_uring peut accepter et recevoir
+ * elle-même sans passer par recv()
+ */
+#define TRANSPORT_CAP_ACCEPT    0x10
+
+/** @brief Nombre maximal de transports écoutés par le serveur */
+#define TRANSPORT_MAX 8
+/** @brief Nombre maximal de descripteurs surveillés par la boucle */
+#define TRANSPORT_MAX_FDS 256
+/** @brief Taille d'un lot de lignes de log écrit en une fois */
+#define TRANSPORT_LOG_BATCH (64 * 1024)
+/** @brief Nombre maximal de morceaux (iovec) d'un lot de log */
+#define TRANSPORT_LOG_IOV 512
+
+/**
+ * @brief Fonction appelée pour chaque message complet reçu
+ *
+ * Le message est dans un tampon de la réserve (voir msgbuf.h) dont pid,
+ * length, truncated, transport et lane sont remplis ; la fonction reçoit la
+ * référence du transport et doit la rendre.
+ */
+typedef void (*transport_deliver)(struct message_buffer *message);
+
+struct transport;
+
+/** @brief Opérations d'un transport */
+struct transport_ops {
+    const char *name;
+    unsigned caps;          /**< Combinaison de TRANSPORT_CAP_* */
+
+    /** @brief Client : se connecte au serveur désigné par address */
+    int (*connect)(struct transport *t, const char *address);
+    /** @brief Client : envoie un message complet */
+    int (*send)(struct transport *t, const char *message, size_t length);
+    /** @brief Serveur : commence à écouter sur address */
+    int (*listen)(struct transport *t, const char *address);
+    /**
+     * @brief Serveur : fd est prêt en lecture
+     * @return 0 pour continuer à surveiller fd, -1 pour le fermer
+     */
+    int (*recv)(struct transport *t, int fd, transport_deliver deliver);
+    /**
+     * @brief Serveur : n'accepte plus de nouveaux clients, ceux en cours
+     * peuvent finir leur envoi (arrêt du serveur ; facultatif)
+     *
+     * Appelée depuis le thread principal, pendant que la boucle tourne.
+     */
+    void (*drain)(struct transport *t);
+    /** @brief Ferme le transport (client ou serveur) */
+    void (*close)(struct transport *t);
+};
+
+/** @brief Instance d'un transport */
+struct transport {
+    const struct transport_ops *ops;
+    int fd;                 /**< Descripteur principal (écoute ou connexion) */
+    pid_t peer;             /**< Signal : PID du serveur */
+    char address[108];      /**< Adresse d'écoute ou de connexion */
+    int listening;          /**< Ouvert par listen() (côté serveur) */
+    int lane;               /**< Client : classe de priorité des envois (signal, fifo) */
+    int resume;             /**< Client signal : attend un serveur relancé et reprend l'envoi */
+    const char *shards;     /**< Client signal : fichier de découverte où retrouver le serveur relancé */
+    void *state;            /**< Données propres au transport */
+};
+
+extern const struct transport_ops transport_signal;
+extern const struct transport_ops transport_unix;
+extern const struct transport_ops transport_fifo;
+
+/** @brief Boucle d'événements utilisée ("io_uring" ou "epoll") */
+extern const char *transport_loop;
+
+/** @brief Délai par défaut avant l'ACK d'un bit d'envoi de masse (µs) */
+#define SIGNAL_BULK_ACK_DELAY_US 100
+
+int transport_watch(struct transport *t, int fd);
+int transport_run(struct transport **transports, int count, transport_deliver deliver);
+void transport_stop(void);
+void transport_log_open(int fd);
+void transport_log_append(const char *data, size_t length, struct message_buffer *ref);
+void transport_signal_set_bulk_delay(unsigned us);
+
+/* Usage interne des boucles d'événements */
+
+/** @brief Descripteur surveillé par la boucle */
+struct transport_fd {
+    int fd;                 /**< -1 si la case est libre */
+    struct transport *t;    /**< Transport propriétaire, NULL si fermé */
+};
+
+extern struct transport_fd transport_fds[TRANSPORT_MAX_FDS];
+extern int transport_fd_count;
+/** @brief Appelée par transport_watch() pour armer un nouveau descripteur */
+extern int (*transport_fd_added)(int slot);
+
+void transport_unwatch(int slot);
+void transport_log_flush(void);
+void transport_log_done(void);
+int transport_stopping(void);
+void transport_log_finish(void);
+
+#endif
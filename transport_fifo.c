@@ -0,0 +1,199 @@
+/**
+ * @file transport_fifo.c
+ * @brief Transport par tube nommé
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Tous les clients écrivent dans le même tube. Chaque message est précédé
+ * d'un en-tête (PID, longueur ; le bit de poids fort de la longueur marque
+ * un envoi de masse) et écrit en un seul write() d'au plus
+ * PIPE_BUF octets : le noyau garantit qu'il n'est pas entrelacé avec celui
+ * d'un autre client. Le PID est celui déclaré par le client.
+ *
+ * Le serveur ouvre le tube en lecture et écriture : il n'en voit jamais la
+ * fin quand le dernier client le ferme.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "transport.h"
+#include "metrics.h"
+
+/** @brief En-tête d'un message dans le tube */
+struct fifo_record {
+    int32_t pid;
+    uint32_t length;
+};
+
+/** @brief Bit de length : message d'envoi de masse */
+#define FIFO_RECORD_BULK 0x80000000u
+
+/** @brief Taille maximale d'un message envoyé sans risque d'entrelacement */
+#define FIFO_MESSAGE_MAX (PIPE_BUF - sizeof(struct fifo_record))
+
+/** @brief Octets lus mais pas encore rendus (message incomplet) */
+struct fifo_state {
+    size_t used;
+    char buffer[2 * PIPE_BUF];
+};
+
+/* ------------------------------------------------------------------------- */
+/* Client                                                                    */
+/* ------------------------------------------------------------------------- */
+
+static int fifo_connect(struct transport *t, const char *address) {
+    snprintf(t->address, sizeof(t->address), "%s", address);
+    t->fd = open(address, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    return t->fd < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Envoie un message en un seul enregistrement atomique
+ * @return 0 en cas de succès, 1 sinon
+ *
+ * Un message de plus de FIFO_MESSAGE_MAX octets est tronqué.
+ */
+static int fifo_send(struct transport *t, const char *message, size_t length) {
+    char record[PIPE_BUF];
+    struct fifo_record header;
+
+    printf("Envoi du message dans le tube %s\n", t->address);
+    if (length > FIFO_MESSAGE_MAX) {
+        printf("Message tronqué à %zu octets\n", FIFO_MESSAGE_MAX);
+        length = FIFO_MESSAGE_MAX;
+    }
+    header.pid = getpid();
+    header.length = length | (t->lane == LANE_BULK ? FIFO_RECORD_BULK : 0);
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), message, length);
+
+    // Tube plein : on attend que le serveur le vide
+    ssize_t n;
+    while ((n = write(t->fd, record, sizeof(header) + length)) < 0 && errno == EAGAIN) {
+        usleep(1000);
+    }
+    if (n != (ssize_t)(sizeof(header) + length)) {
+        perror("Erreur: envoi impossible");
+        return 1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Serveur                                                                   */
+/* ------------------------------------------------------------------------- */
+
+static int fifo_listen(struct transport *t, const char *address) {
+    t->fd = -1;
+    if (mkfifo(address, 0622) < 0 && errno != EEXIST) {
+        return -1;
+    }
+    struct fifo_state *state = calloc(1, sizeof(*state));
+    if (!state) {
+        return -1;
+    }
+    t->fd = open(address, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (t->fd < 0) {
+        free(state);
+        return -1;
+    }
+    t->state = state;
+    t->listening = 1;
+    snprintf(t->address, sizeof(t->address), "%s", address);
+    return 0;
+}
+
+/**
+ * @brief Rend les messages complets présents dans le tampon
+ *
+ * Chaque message est copié du tampon de lecture du tube dans un tampon de
+ * la réserve ; il est perdu si la réserve est vide.
+ */
+static void deliver_records(struct fifo_state *state, transport_deliver deliver) {
+    size_t offset = 0;
+    while (state->used - offset >= sizeof(struct fifo_record)) {
+        struct fifo_record header;
+        memcpy(&header, state->buffer + offset, sizeof(header));
+        int lane = header.length & FIFO_RECORD_BULK ? LANE_BULK : LANE_INTERACTIVE;
+        header.length &= ~FIFO_RECORD_BULK;
+        if (header.length > FIFO_MESSAGE_MAX) {
+            // En-tête invalide : on abandonne le contenu du tampon
+            offset = state->used;
+            break;
+        }
+        if (state->used - offset < sizeof(header) + header.length) {
+            break;
+        }
+        struct message_buffer *b = header.length > 0 ? msgbuf_get() : NULL;
+        if (b) {
+            b->length = header.length < MESSAGE_MAX - 1 ? header.length : MESSAGE_MAX - 1;
+            memcpy(b->data, state->buffer + offset + sizeof(header), b->length);
+            b->data[b->length] = '\0';
+            b->pid = header.pid;
+            b->truncated = header.length > b->length;
+            b->transport = transport_fifo.name;
+            b->lane = lane;
+            deliver(b);
+        } else if (header.length > 0) {
+            metrics_inc(METRIC_POOL_EXHAUSTED);
+        }
+        offset += sizeof(header) + header.length;
+    }
+    memmove(state->buffer, state->buffer + offset, state->used - offset);
+    state->used -= offset;
+}
+
+static int fifo_recv(struct transport *t, int fd, transport_deliver deliver) {
+    struct fifo_state *state = t->state;
+    while (1) {
+        ssize_t n = read(fd, state->buffer + state->used, sizeof(state->buffer) - state->used);
+        if (n <= 0) {
+            return n < 0 && errno != EAGAIN && errno != EINTR ? -1 : 0;
+        }
+        state->used += n;
+        deliver_records(state, deliver);
+    }
+}
+
+/**
+ * @brief Arrêt du serveur : retire le chemin pour que les nouveaux clients
+ * ne le trouvent plus ; les clients qui l'ont déjà ouvert peuvent encore écrire
+ */
+static void fifo_drain(struct transport *t) {
+    if (t->listening) {
+        unlink(t->address);
+        t->listening = 0;  // Un serveur relancé a pu recréer le chemin avant notre sortie
+    }
+}
+
+static void fifo_close(struct transport *t) {
+    if (t->fd >= 0) {
+        close(t->fd);
+        t->fd = -1;
+    }
+    if (t->listening) {
+        unlink(t->address);
+        t->listening = 0;
+    }
+    free(t->state);
+    t->state = NULL;
+}
+
+const struct transport_ops transport_fifo = {
+    .name = "fifo",
+    .caps = TRANSPORT_CAP_MESSAGE,
+    .connect = fifo_connect,
+    .send = fifo_send,
+    .listen = fifo_listen,
+    .recv = fifo_recv,
+    .drain = fifo_drain,
+    .close = fifo_close,
+};
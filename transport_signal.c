@@ -0,0 +1,661 @@
+/**
+ * @file transport_signal.c
+ * @brief Transport par signaux UNIX (protocole historique)
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Client : chaque octet est envoyé bit par bit (SIGUSR1 pour 1, SIGUSR2
+ * pour 0) en attendant l'ACK du serveur avant le bit suivant, puis SIGQUIT
+ * termine le message. Avec t->resume, un serveur qui ne répond plus est
+ * attendu : relancé, il dit où reprendre (PROTO_FLAG_RESUME).
+ *
+ * Serveur : le gestionnaire de signal se contente de déposer (si_pid,
+ * signal, si_value, horodatage) dans une file sans verrou et de réveiller
+ * la boucle d'événements par un eventfd. La boucle reconstitue les octets
+ * dans la session du client, envoie les ACK et rend le message complet à
+ * la réception de SIGQUIT. L'ordre de traitement est choisi par scheduler.c :
+ * chacun son tour entre clients, interactifs d'abord, au débit autorisé.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "transport.h"
+#include "protocole.h"
+#include "metrics.h"
+#include "trace.h"
+#include "ring.h"
+#include "session.h"
+#include "capture.h"
+#include "scheduler.h"
+#include "shards.h"
+
+/* ------------------------------------------------------------------------- */
+/* Client                                                                    */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief Convertit un caractère en sa représentation binaire
+ * @param c Le caractère à convertir
+ * @param binary Buffer de sortie pour stocker la représentation binaire (doit être de taille 9)
+ *
+ * Cette fonction convertit un caractère en sa représentation binaire sur 8 bits.
+ * Le résultat est stocké dans le buffer binary sous forme de chaîne de '0' et '1'.
+ */
+static void char_to_binary(char c, char *binary) {
+    int ascii_value = (int)c;
+    for (int i = 7; i >= 0; i--) {
+        binary[7 - i] = (ascii_value & (1 << i)) ? '1' : '0';
+    }
+    binary[8] = '\0';
+}
+
+// Variable globale pour l'accusé de réception
+static volatile sig_atomic_t ack_received = 0;
+// Refus et crédit portés par le dernier ACK (-1 : serveur sans crédit)
+static volatile sig_atomic_t ack_busy = 0;
+static volatile sig_atomic_t ack_credit = -1;
+// Position de reprise portée par la réponse à PROTO_FLAG_RESUME (-1 : pas de réponse)
+static volatile sig_atomic_t ack_offset = -1;
+
+// Handler pour recevoir l'accusé de réception
+static void ack_handler(int signo, siginfo_t *info, void *context) {
+    (void)context;
+    if (signo == SIGUSR1) {
+        int value = info->si_value.sival_int;
+        if (info->si_code == SI_QUEUE && (value & PROTO_FLAG_RESUME)) {
+            ack_offset = PROTO_ACK_OFFSET(value);
+        } else if (info->si_code == SI_QUEUE && (value & PROTO_FLAG_CREDIT)) {
+            ack_busy = (value & PROTO_ACK_BUSY) != 0;
+            ack_credit = PROTO_ACK_CREDIT(value);
+        }
+        ack_received = 1;
+        trace_event(TRACE_ACK_RECV, info->si_pid, 0);
+    }
+}
+
+/**
+ * @brief Prépare l'envoi vers un serveur
+ * @param address PID du serveur
+ */
+static int signal_connect(struct transport *t, const char *address) {
+    t->peer = atoi(address);
+    t->fd = -1;
+    if (t->peer <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    snprintf(t->address, sizeof(t->address), "%s", address);
+
+    // Configuration du handler pour l'accusé de réception
+    struct sigaction sa;
+    sa.sa_sigaction = ack_handler;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    return sigaction(SIGUSR1, &sa, NULL);
+}
+
+/** @brief Attend un ACK au plus ACK_TIMEOUT_US, 1 s'il est arrivé */
+static int wait_ack(void) {
+    for (int i = 0; !ack_received && i < ACK_TIMEOUT_US / 100; i++) {
+        usleep(100);
+    }
+    return ack_received;
+}
+
+/**
+ * @brief Envoie un bit et attend son ACK
+ * @param rank Rang du bit dans le message (traces)
+ * @param waited_us Durée cumulée des pauses demandées par le serveur
+ * @return 0 si le bit est acquitté, 1 si le serveur ne répond pas, -1 s'il
+ * reste saturé plus de FLOW_WAIT_MAX_US
+ *
+ * Quand le serveur refuse le bit (PROTO_ACK_BUSY), le client attend de plus
+ * en plus longtemps (FLOW_PAUSE_MIN_US à FLOW_PAUSE_MAX_US) puis le renvoie.
+ */
+static int send_bit(pid_t pid, int bit, union sigval flags, size_t rank, unsigned *waited_us) {
+    unsigned pause_us = FLOW_PAUSE_MIN_US;
+    while (1) {
+        ack_received = 0;
+        ack_busy = 0;
+
+        // Envoi du bit
+        trace_event(TRACE_BIT_SENT, pid, rank);
+        sigqueue(pid, bit ? SIGUSR1 : SIGUSR2, flags);
+
+        // Attente de l'accusé de réception avec timeout
+        if (!wait_ack()) {
+            trace_event(TRACE_TIMEOUT, pid, rank);
+            return 1;
+        }
+        if (!ack_busy) {
+            return 0;
+        }
+
+        // Serveur saturé : pause puis nouvel essai du même bit
+        if (*waited_us >= FLOW_WAIT_MAX_US) {
+            return -1;
+        }
+        trace_event(TRACE_PAUSE, pid, pause_us);
+        usleep(pause_us);
+        *waited_us += pause_us;
+        pause_us = pause_us * 2 < FLOW_PAUSE_MAX_US ? pause_us * 2 : FLOW_PAUSE_MAX_US;
+    }
+}
+
+/**
+ * @brief Attend le retour du serveur et lui demande où reprendre
+ * @param bits Nombre de bits du message
+ * @return Rang du prochain bit à envoyer, -1 si le serveur n'est pas
+ * revenu après RESUME_WAIT_MAX_US
+ *
+ * Un serveur relancé a un autre PID : il est cherché de nouveau dans le
+ * fichier de découverte (t->shards) avant chaque demande. Sans ce
+ * fichier, la demande est renvoyée au même PID (serveur suspendu puis
+ * repris, par exemple).
+ */
+static long signal_resume(struct transport *t, size_t bits) {
+    union sigval query = {.sival_int = PROTO_FLAG_RESUME};
+    printf("Serveur sans réponse, attente de son retour pour reprendre l'envoi...\n");
+    for (unsigned waited_us = 0; waited_us < RESUME_WAIT_MAX_US; waited_us += RESUME_RETRY_US) {
+        struct shard_map map;
+        int shard;
+        if (t->shards && shards_read(t->shards, &map) > 0 && (shard = shards_pick(&map, getpid())) >= 0) {
+            t->peer = map.pids[shard];
+        }
+        ack_received = 0;
+        ack_offset = -1;
+        if (sigqueue(t->peer, SIGUSR1, query) == 0 && wait_ack() && ack_offset >= 0) {
+            if ((size_t)ack_offset > bits) {
+                printf("Erreur: le serveur (PID: %d) a déjà %d bits, plus que le message\n",
+                       t->peer, (int)ack_offset);
+                return -1;
+            }
+            printf("Reprise au bit %d (octet %d) sur le serveur PID %d\n", (int)ack_offset,
+                   (int)ack_offset / 8, t->peer);
+            trace_event(TRACE_RESUME, t->peer, ack_offset);
+            return ack_offset;
+        }
+        usleep(RESUME_RETRY_US);
+    }
+    return -1;
+}
+
+/**
+ * @brief Envoie un message bit par bit avec attente d'ACK
+ * @return 0 en cas de succès, 1 si le serveur ne répond pas
+ *
+ * Un crédit nul ralentit l'envoi des bits suivants. Avec t->resume, un
+ * serveur qui ne répond plus n'est pas une erreur tant qu'il revient dans
+ * les RESUME_WAIT_MAX_US (voir signal_resume()).
+ */
+static int signal_send(struct transport *t, const char *message, size_t length) {
+    union sigval flags = {.sival_int = PROTO_FLAG_CREDIT | (t->lane == LANE_BULK ? PROTO_FLAG_BULK : 0)};
+    unsigned waited_us = 0;
+
+    printf("Envoi du message au serveur (PID: %d)\n", t->peer);
+
+    size_t bits = length * 8;
+    size_t rank = 0;
+    while (rank < bits) {
+        char binary[9];
+        char_to_binary(message[rank / 8], binary);
+        int status = send_bit(t->peer, binary[rank % 8] == '1', flags, rank, &waited_us);
+        if (status > 0 && t->resume) {
+            long offset = signal_resume(t, bits);
+            if (offset >= 0) {
+                rank = offset;
+                continue;
+            }
+        }
+        if (status > 0) {
+            printf("Erreur: Pas de réponse du serveur\n");
+            return 1;
+        }
+        if (status < 0) {
+            printf("Erreur: serveur saturé depuis %u s\n", waited_us / 1000000);
+            return 1;
+        }
+        rank++;
+
+        // Petit délai entre chaque bit pour stabilité, plus long si le
+        // serveur n'a plus de crédit
+        if (ack_credit == 0) {
+            trace_event(TRACE_PAUSE, t->peer, FLOW_PAUSE_MIN_US);
+            usleep(FLOW_PAUSE_MIN_US);
+        } else {
+            usleep(100);
+        }
+    }
+
+    printf("Message envoyé, envoi du signal de fin...\n");
+    usleep(1000);  // Attendre un peu avant d'envoyer le signal de fin
+    kill(t->peer, SIGQUIT);
+    trace_event(TRACE_QUIT_SENT, t->peer, length);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Serveur                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/** @brief Nombre maximal de signaux retirés de la file entre deux traitements */
+#define SIGNAL_BATCH 256
+
+/** @brief File des signaux reçus, remplie par handler() */
+static struct signal_ring events;
+/** @brief Réveille la boucle d'événements (write est sûr dans un handler) */
+static int events_fd = -1;
+/** @brief Réveille la boucle quand un client retenu par sa limite peut être servi */
+static int timer_fd = -1;
+/** @brief Échéance du timerfd (0 : désarmé) */
+static uint64_t timer_armed = 0;
+/** @brief Délai avant l'ACK d'un bit d'envoi de masse (µs), réglable à chaud */
+static _Atomic unsigned bulk_ack_delay_us = SIGNAL_BULK_ACK_DELAY_US;
+/**
+ * @brief ACK d'un bit d'envoi de masse retenu jusqu'à son échéance
+ *
+ * L'ACK est envoyé par signal_recv(), réveillé par le timerfd : la boucle
+ * d'événements ne dort jamais pendant le délai.
+ */
+struct held_ack {
+    struct signal_event ev;
+    uint64_t due_ns;
+    int bits;               /**< Bits de l'octet en cours (traces) */
+};
+
+/** @brief ACK retenus au plus (un bit en attente d'ACK par client, puissance de 2) */
+#define HELD_ACKS_MAX (SESSIONS_MAX * 2)
+
+/** @brief ACK retenus, triés par échéance (hold_ack()) */
+static struct held_ack held_acks[HELD_ACKS_MAX];
+static unsigned held_head = 0, held_tail = 0;
+/** @brief Prochaine recherche de sessions abandonnées (0 : aucune session) */
+static uint64_t sweep_ns = 0;
+/** @brief Arrêt en cours : plus de nouvelle session */
+static atomic_int draining = 0;
+
+/** @brief Change le délai avant l'ACK d'un bit d'envoi de masse */
+void transport_signal_set_bulk_delay(unsigned us) {
+    atomic_store_explicit(&bulk_ack_delay_us, us, memory_order_relaxed);
+}
+
+/**
+ * @brief Gestionnaire de signaux pour la réception des messages
+ * @param sig Signal reçu (SIGUSR1, SIGUSR2 ou SIGQUIT)
+ * @param info Informations supplémentaires sur le signal
+ * @param context Contexte de l'appel
+ *
+ * Le gestionnaire n'appelle que des fonctions sûres dans un handler
+ * (opérations atomiques, clock_gettime, write). Tout le décodage est fait
+ * par signal_recv() dans la boucle d'événements.
+ */
+static void handler(int sig, siginfo_t *info, void *context) {
+    (void)context;
+    struct signal_event ev;
+    ev.ns = metrics_now_ns();
+    ev.pid = info->si_pid;
+    ev.signo = sig;
+    ev.code = info->si_code;
+    ev.value = info->si_value.sival_int;
+
+    if (sig == SIGUSR1 || sig == SIGUSR2) {
+        metrics_inc(sig == SIGUSR1 ? METRIC_SIGUSR1 : METRIC_SIGUSR2);
+        trace_event(TRACE_BIT_RECV, ev.pid, sig == SIGUSR1);
+    } else {
+        metrics_inc(METRIC_SIGQUIT);
+    }
+
+    if (signal_ring_push(&events, &ev)) {
+        int saved_errno = errno;
+        uint64_t one = 1;
+        ssize_t written = write(events_fd, &one, sizeof(one));
+        (void)written;
+        errno = saved_errno;
+    } else {
+        metrics_inc(METRIC_SIGNALS_DROPPED);
+    }
+}
+
+/**
+ * @brief Installe le gestionnaire des signaux du protocole
+ * @param address Ignorée : l'adresse est le PID du serveur
+ *
+ * À appeler depuis le thread qui recevra les signaux ; la boucle
+ * d'événements doit les bloquer.
+ */
+static int signal_listen(struct transport *t, const char *address) {
+    (void)address;
+    events_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (events_fd < 0) {
+        return -1;
+    }
+    t->fd = events_fd;
+    snprintf(t->address, sizeof(t->address), "%d", getpid());
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0 || transport_watch(t, timer_fd) != 0) {
+        return -1;
+    }
+    if (session_active() > 0) {
+        // Sessions reprises du journal : leurs clients ne reviendront
+        // peut-être pas, la recherche des abandons n'attend pas un signal
+        sweep_ns = metrics_now_ns() + (uint64_t)SESSION_SWEEP_MS * 1000000;
+        struct itimerspec when = {
+            .it_value = {.tv_sec = sweep_ns / 1000000000, .tv_nsec = sweep_ns % 1000000000},
+        };
+        timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &when, NULL);
+        timer_armed = sweep_ns;
+    }
+
+    // Configuration des gestionnaires de signaux avec sigaction
+    struct sigaction sa;
+    sa.sa_sigaction = handler;
+    sa.sa_flags = SA_SIGINFO;  // Pour obtenir les informations supplémentaires sur le signal
+    sigemptyset(&sa.sa_mask);
+    // Le handler n'est jamais réentré : un seul producteur pour la file
+    sigaddset(&sa.sa_mask, SIGUSR1);
+    sigaddset(&sa.sa_mask, SIGUSR2);
+    sigaddset(&sa.sa_mask, SIGQUIT);
+    if (sigaction(SIGUSR1, &sa, NULL) == -1 ||
+        sigaction(SIGUSR2, &sa, NULL) == -1 ||
+        sigaction(SIGQUIT, &sa, NULL) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Envoie l'ACK d'un bit
+ * @param busy Le bit a été refusé (seulement pour un client PROTO_FLAG_CREDIT)
+ *
+ * Les bits envoyés par sigqueue() avec PROTO_FLAG_RT_ACK sont acquittés
+ * par SIG_ACK_RT au lieu de SIGUSR1. Avec PROTO_FLAG_CREDIT, l'ACK porte
+ * le crédit du serveur : le nombre de tampons libres de la réserve.
+ */
+static void send_ack(const struct signal_event *ev, int busy) {
+    int flags = ev->code == SI_QUEUE ? ev->value & 0xFF : 0;
+    int sig = flags & PROTO_FLAG_RT_ACK ? SIG_ACK_RT : SIGUSR1;
+    if (flags & PROTO_FLAG_CREDIT) {
+        unsigned credit = msgbuf_available();
+        if (credit > PROTO_CREDIT_MAX) {
+            credit = PROTO_CREDIT_MAX;
+        }
+        union sigval value = {.sival_int = flags | (busy ? PROTO_ACK_BUSY : 0) |
+                                           (int)(credit << PROTO_CREDIT_SHIFT)};
+        sigqueue(ev->pid, sig, value);
+    } else if (flags) {
+        union sigval value = {.sival_int = flags};
+        sigqueue(ev->pid, sig, value);
+    } else {
+        kill(ev->pid, sig);
+    }
+}
+
+/** @brief Acquitte un bit traité */
+static void ack_bit(const struct signal_event *ev, int bits) {
+    send_ack(ev, 0);
+    trace_event(TRACE_ACK_SENT, ev->pid, bits);
+    metrics_observe(METRIC_ACK_LATENCY, metrics_now_ns() - ev->ns);
+}
+
+/**
+ * @brief Retient l'ACK d'un bit jusqu'à due_ns
+ *
+ * Les échéances arrivent presque toujours dans l'ordre ; après un reload
+ * qui raccourcit delai_ack_masse_us, le nouvel ACK passe devant ceux qui
+ * attendent plus longtemps que lui.
+ */
+static void hold_ack(const struct signal_event *ev, uint64_t due_ns, int bits) {
+    unsigned i = held_head++;
+    while (i != held_tail && held_acks[(i - 1) % HELD_ACKS_MAX].due_ns > due_ns) {
+        held_acks[i % HELD_ACKS_MAX] = held_acks[(i - 1) % HELD_ACKS_MAX];
+        i--;
+    }
+    held_acks[i % HELD_ACKS_MAX] = (struct held_ack){*ev, due_ns, bits};
+}
+
+/**
+ * @brief Envoie les ACK retenus arrivés à échéance
+ * @param now Instant présent, ou UINT64_MAX pour tous les envoyer
+ * @return Échéance du prochain ACK retenu (0 : aucun)
+ */
+static uint64_t release_acks(uint64_t now) {
+    while (held_tail != held_head) {
+        struct held_ack *h = &held_acks[held_tail % HELD_ACKS_MAX];
+        if (h->due_ns > now) {
+            return h->due_ns;
+        }
+        ack_bit(&h->ev, h->bits);
+        held_tail++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Répond à une demande de reprise : bits déjà reçus de la session
+ * du client, 0 si elle est inconnue
+ */
+static void process_resume(const struct signal_event *ev) {
+    struct session *s = session_find(ev->pid, 0);
+    unsigned offset = s ? s->received : 0;
+    if (s) {
+        s->last_ns = ev->ns;
+    }
+    if (offset > PROTO_OFFSET_MAX) {
+        offset = PROTO_OFFSET_MAX;
+    }
+    int flags = ev->value & 0xFF;
+    union sigval value = {.sival_int = (int)((unsigned)flags | offset << PROTO_OFFSET_SHIFT)};
+    sigqueue(ev->pid, flags & PROTO_FLAG_RT_ACK ? SIG_ACK_RT : SIGUSR1, value);
+    metrics_inc(METRIC_RESUMES);
+}
+
+/**
+ * @brief Traite un bit : l'ajoute à la session du client et l'acquitte
+ * @param deliver Reçoit les messages des sessions abandonnées rendues
+ * pour faire de la place
+ *
+ * Pendant l'arrêt du serveur, seules les sessions déjà commencées
+ * continuent. Quand la table est pleine, les sessions des clients disparus
+ * sont rendues avant de refuser le bit.
+ */
+static void process_bit(const struct signal_event *ev, transport_deliver deliver) {
+    if (ev->code == SI_QUEUE && (ev->value & PROTO_FLAG_RESUME)) {
+        process_resume(ev);
+        return;
+    }
+    int create = !atomic_load_explicit(&draining, memory_order_relaxed);
+    struct session *s = session_find(ev->pid, create);
+    if (!s && create && msgbuf_available() > 0 && session_sweep(metrics_now_ns(), 0, deliver) > 0) {
+        s = session_find(ev->pid, create);
+    }
+    if (!s) {
+        // Table ou réserve pleine, ou arrêt en cours : refus explicite si le
+        // client le comprend, sinon pas d'ACK
+        metrics_inc(msgbuf_available() == 0 ? METRIC_POOL_EXHAUSTED : METRIC_SIGNALS_DROPPED);
+        if (ev->pid > 0 && ev->code == SI_QUEUE && (ev->value & PROTO_FLAG_CREDIT)) {
+            send_ack(ev, 1);
+            metrics_inc(METRIC_BUSY_ACKS);
+        }
+        return;
+    }
+
+    if (s->length == 0 && s->bits == 0) {
+        // Premier bit : classe de la session
+        s->buffer->transport = transport_signal.name;
+        if (ev->code == SI_QUEUE && (ev->value & PROTO_FLAG_BULK)) {
+            s->buffer->lane = LANE_BULK;
+        }
+    }
+    s->last_ns = ev->ns;
+    if (session_push_bit(s, ev->signo == SIGUSR1)) {
+        metrics_inc(METRIC_BYTES_REASSEMBLED);
+    }
+
+    // Envoyer l'accusé de réception, après un petit délai pour les envois
+    // de masse seulement : l'ACK est alors retenu (voir release_acks())
+    if (ev->pid > 0) {
+        unsigned delay_us = atomic_load_explicit(&bulk_ack_delay_us, memory_order_relaxed);
+        if (s->buffer->lane == LANE_BULK && delay_us > 0 && held_head - held_tail < HELD_ACKS_MAX) {
+            hold_ack(ev, ev->ns + (uint64_t)delay_us * 1000, s->bits);
+        } else {
+            ack_bit(ev, s->bits);
+        }
+    }
+}
+
+/**
+ * @brief Traite la fin d'un message : confie son tampon à la couche supérieure
+ */
+static void process_end(const struct signal_event *ev, transport_deliver deliver) {
+    struct session *s = session_find(ev->pid, 0);
+    trace_event(TRACE_QUIT_RECV, ev->pid, s ? s->length : 0);
+    if (!s) {
+        return;
+    }
+    if (s->length > 0) {
+        struct message_buffer *b = s->buffer;
+        b->data[s->length] = '\0';
+        b->pid = s->pid;
+        b->length = s->length;
+        b->truncated = s->truncated;
+        b->transport = transport_signal.name;
+        s->buffer = NULL;
+        deliver(b);
+    }
+    session_release(s);
+}
+
+/** @brief Traite un signal de la file */
+static void process_event(const struct signal_event *ev, transport_deliver deliver) {
+    if (ev->signo == SIGUSR1 || ev->signo == SIGUSR2) {
+        process_bit(ev, deliver);
+    } else if (ev->signo == SIGQUIT) {
+        process_end(ev, deliver);
+    }
+}
+
+/** @brief Le signal appartient à un envoi de masse */
+static int is_bulk(const struct signal_event *ev) {
+    struct session *s = session_find(ev->pid, 0);
+    if (s) {
+        return s->buffer && s->buffer->lane == LANE_BULK;
+    }
+    return ev->code == SI_QUEUE && (ev->value & PROTO_FLAG_BULK);
+}
+
+/** @brief Traite les signaux que l'ordonnanceur autorise */
+static void dispatch(transport_deliver deliver) {
+    struct signal_event ev;
+    uint64_t now = metrics_now_ns();
+    while (sched_next(now, &ev)) {
+        process_event(&ev, deliver);
+        now = metrics_now_ns();
+    }
+}
+
+/**
+ * @brief Consomme la file des signaux
+ * @param fd eventfd du gestionnaire ou timerfd de l'ordonnanceur
+ *
+ * Les signaux sont pris par lots et rangés dans la file de leur client,
+ * puis traités dans l'ordre choisi par l'ordonnanceur. Les signaux d'un
+ * client retenu par sa limite de débit restent en attente : le timerfd est
+ * armé pour le premier instant où l'un d'eux pourra être traité, pour
+ * l'échéance du prochain ACK retenu d'un envoi de masse, ou pour la
+ * prochaine recherche de sessions abandonnées (session_sweep()) tant
+ * qu'il reste des sessions.
+ */
+static int signal_recv(struct transport *t, int fd, transport_deliver deliver) {
+    (void)t;
+    uint64_t pending;
+    struct signal_event ev;
+    if (read(fd, &pending, sizeof(pending)) < 0 && errno != EAGAIN) {
+        return -1;
+    }
+    while (1) {
+        int popped = 0;
+        while (popped < SIGNAL_BATCH && signal_ring_pop(&events, &ev)) {
+            popped++;
+            capture_record_signal(&ev);
+            int queued = sched_enqueue(&ev, is_bulk(&ev) ? LANE_BULK : LANE_INTERACTIVE);
+            if (queued < 0) {
+                // File du client pleine : la vider avant de réessayer
+                dispatch(deliver);
+                queued = sched_enqueue(&ev, is_bulk(&ev) ? LANE_BULK : LANE_INTERACTIVE);
+            }
+            if (queued > 0) {
+                process_event(&ev, deliver);  // Table des clients pleine
+            } else if (queued < 0) {
+                metrics_inc(METRIC_SIGNALS_DROPPED);  // Client retenu par sa limite
+            }
+        }
+        dispatch(deliver);
+        capture_flush();
+        if (popped < SIGNAL_BATCH) {
+            break;
+        }
+    }
+
+    uint64_t now = metrics_now_ns();
+    if (sweep_ns > 0 && now >= sweep_ns) {
+        session_sweep(now, (uint64_t)SESSION_DEAD_MS * 1000000, deliver);
+        sweep_ns = 0;
+    }
+    if (sweep_ns == 0 && session_active() > 0) {
+        sweep_ns = now + (uint64_t)SESSION_SWEEP_MS * 1000000;
+    }
+    uint64_t wakeup = sched_wakeup_ns();
+    uint64_t deadlines[2] = {sweep_ns, release_acks(now)};
+    for (int i = 0; i < 2; i++) {
+        if (deadlines[i] > 0 && (wakeup == 0 || deadlines[i] < wakeup)) {
+            wakeup = deadlines[i];
+        }
+    }
+    if (wakeup != timer_armed || fd == timer_fd) {
+        struct itimerspec when = {
+            .it_value = {.tv_sec = wakeup / 1000000000, .tv_nsec = wakeup % 1000000000},
+        };
+        timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &when, NULL);
+        timer_armed = wakeup;
+    }
+    return 0;
+}
+
+/** @brief Arrêt du serveur : les nouveaux clients sont refusés comme par un serveur saturé */
+static void signal_drain(struct transport *t) {
+    (void)t;
+    atomic_store(&draining, 1);
+}
+
+static void signal_close(struct transport *t) {
+    if (t->fd >= 0 && t->fd == events_fd) {
+        release_acks(UINT64_MAX);  // Bits journalisés : leur ACK part sans attendre
+        signal(SIGUSR1, SIG_DFL);
+        signal(SIGUSR2, SIG_DFL);
+        signal(SIGQUIT, SIG_DFL);
+        close(events_fd);
+        events_fd = -1;
+        close(timer_fd);
+        timer_fd = -1;
+    }
+    t->fd = -1;
+}
+
+const struct transport_ops transport_signal = {
+    .name = "signal",
+    .caps = TRANSPORT_CAP_ACK | TRANSPORT_CAP_PEER_PID,
+    .connect = signal_connect,
+    .send = signal_send,
+    .listen = signal_listen,
+    .recv = signal_recv,
+    .drain = signal_drain,
+    .close = signal_close,
+};
@@ -0,0 +1,177 @@
+/**
+ * @file transport_unix.c
+ * @brief Transport par socket Unix SOCK_SEQPACKET
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * Chaque message est un paquet : les limites sont conservées par le noyau,
+ * il n'y a ni découpage ni reconstitution. Le PID du client est celui que
+ * le noyau a enregistré à la connexion (SO_PEERCRED). Une connexion peut
+ * porter plusieurs messages.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "transport.h"
+#include "metrics.h"
+
+/** @brief Remplit l'adresse d'une socket Unix */
+static int make_address(struct sockaddr_un *addr, const char *path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Client                                                                    */
+/* ------------------------------------------------------------------------- */
+
+static int unix_connect(struct transport *t, const char *address) {
+    struct sockaddr_un addr;
+    t->fd = -1;
+    if (make_address(&addr, address) != 0) {
+        return -1;
+    }
+    snprintf(t->address, sizeof(t->address), "%s", address);
+    t->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (t->fd < 0) {
+        return -1;
+    }
+    if (connect(t->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(t->fd);
+        t->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Envoie un message en un seul paquet
+ * @return 0 en cas de succès, 1 sinon
+ */
+static int unix_send(struct transport *t, const char *message, size_t length) {
+    printf("Envoi du message sur la socket %s\n", t->address);
+    if (send(t->fd, message, length, MSG_NOSIGNAL) != (ssize_t)length) {
+        perror("Erreur: envoi impossible");
+        return 1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Serveur                                                                   */
+/* ------------------------------------------------------------------------- */
+
+static int unix_listen(struct transport *t, const char *address) {
+    struct sockaddr_un addr;
+    t->fd = -1;
+    if (make_address(&addr, address) != 0) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(address);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+        close(fd);
+        return -1;
+    }
+    t->fd = fd;
+    t->listening = 1;
+    snprintf(t->address, sizeof(t->address), "%s", address);
+    return 0;
+}
+
+/**
+ * @brief Accepte les connexions en attente ou lit un message
+ *
+ * Le paquet est lu directement dans un tampon de la réserve. Un paquet
+ * plus grand que MESSAGE_MAX - 1 est tronqué (MSG_TRUNC donne sa taille
+ * réelle). Si la réserve est vide, le paquet est lu et perdu.
+ */
+static int unix_recv(struct transport *t, int fd, transport_deliver deliver) {
+    if (fd == t->fd) {
+        int conn;
+        while ((conn = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            if (transport_watch(t, conn) != 0) {
+                close(conn);
+            }
+        }
+        return 0;
+    }
+
+    while (1) {
+        struct message_buffer *b = msgbuf_get();
+        char discard[1];
+        ssize_t n = b ? recv(fd, b->data, MESSAGE_MAX - 1, MSG_TRUNC) : recv(fd, discard, 1, MSG_TRUNC);
+        if (n <= 0) {
+            if (b) {
+                msgbuf_put(b);
+            }
+            if (n == 0) {
+                return -1;  // Connexion fermée par le client
+            }
+            return errno == EAGAIN || errno == EINTR ? 0 : -1;
+        }
+        if (!b) {
+            metrics_inc(METRIC_POOL_EXHAUSTED);
+            continue;
+        }
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+            cred.pid = 0;
+        }
+        b->length = (size_t)n < MESSAGE_MAX - 1 ? (size_t)n : MESSAGE_MAX - 1;
+        b->data[b->length] = '\0';
+        b->pid = cred.pid;
+        b->truncated = (size_t)n > b->length;
+        b->transport = transport_unix.name;
+        deliver(b);
+    }
+}
+
+/**
+ * @brief Arrêt du serveur : retire le chemin pour que les nouveaux clients
+ * ne le trouvent plus ; les connexions déjà acceptées restent lues
+ */
+static void unix_drain(struct transport *t) {
+    if (t->listening) {
+        unlink(t->address);
+        t->listening = 0;  // Un serveur relancé a pu recréer le chemin avant notre sortie
+    }
+}
+
+static void unix_close(struct transport *t) {
+    if (t->fd >= 0) {
+        close(t->fd);
+        t->fd = -1;
+    }
+    if (t->listening) {
+        unlink(t->address);
+        t->listening = 0;
+    }
+}
+
+const struct transport_ops transport_unix = {
+    .name = "unix",
+    .caps = TRANSPORT_CAP_MESSAGE | TRANSPORT_CAP_PEER_PID | TRANSPORT_CAP_REPLY | TRANSPORT_CAP_ACCEPT,
+    .connect = unix_connect,
+    .send = unix_send,
+    .listen = unix_listen,
+    .recv = unix_recv,
+    .drain = unix_drain,
+    .close = unix_close,
+};
@@ -0,0 +1,528 @@
+/**
+ * @file transport_uring.c
+ * @brief Boucle d'événements du serveur avec io_uring
+ * @author silverhawks
+ * @date 06/01/25
+ *
+ * L'anneau est utilisé directement par les appels système (pas de
+ * liburing). Un seul io_uring_enter() soumet toutes les requêtes préparées
+ * pendant le lot précédent et attend les complétions suivantes :
+ * - les sockets d'écoute (TRANSPORT_CAP_ACCEPT) ont un accept multishot,
+ *   chaque connexion un recv multishot dont les octets arrivent dans un
+ *   des tampons de la réserve fournis au noyau (IORING_OP_PROVIDE_BUFFERS) ;
+ *   le tampon rempli est confié tel quel à la suite du traitement et un
+ *   autre tampon de la réserve est fourni à sa place ;
+ * - les autres descripteurs (eventfd des signaux, tubes) ont un poll
+ *   multishot et sont lus par le recv() de leur transport ;
+ * - le log est écrit par un writev lié à un fdatasync (IOSQE_IO_LINK).
+ *
+ * Si le noyau ne fournit pas ces opérations, transport_uring_run() échoue
+ * avec ENOSYS et la boucle epoll prend le relais.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "transport_uring.h"
+#include "metrics.h"
+
+/** @brief Nature d'une requête, dans les 8 bits de poids fort de user_data */
+enum uring_request {
+    REQ_ACCEPT = 1,     /**< Accept multishot (bas : case de la socket d'écoute) */
+    REQ_RECV,           /**< Recv multishot (bas : case de la connexion) */
+    REQ_POLL,           /**< Poll multishot (bas : case du descripteur) */
+    REQ_POLL_REMOVE,    /**< Retrait d'un poll */
+    REQ_PROVIDE,        /**< Tampon redonné au noyau */
+    REQ_LOG_WRITE,      /**< Écriture d'un lot de log */
+    REQ_LOG_SYNC,       /**< fdatasync lié à l'écriture */
+};
+
+#define USER_DATA(type, slot) (((uint64_t)(type) << 56) | (uint32_t)(slot))
+#define USER_TYPE(data) ((int)((data) >> 56))
+#define USER_SLOT(data) ((int)((data) & 0xFFFFFFFFu))
+
+/** @brief Groupe des tampons de réception */
+#define BUFFER_GROUP 1
+
+/** @brief Connexion acceptée par la boucle */
+struct uring_conn {
+    int fd;                 /**< -1 si la case est libre */
+    pid_t pid;              /**< PID du client (SO_PEERCRED, lu une fois) */
+    struct transport *t;
+    int starved;            /**< recv arrêté faute de tampon fourni */
+};
+
+static struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned sq_entries;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned cq_entries;
+    unsigned queued;        /**< Requêtes préparées non soumises */
+} ring;
+
+static struct uring_conn conns[TRANSPORT_MAX_FDS];
+static transport_deliver deliver_fn;
+/** @brief Tampons actuellement fournis au noyau */
+static int provided = 0;
+/** @brief Tampons à fournir dès que la réserve en aura de libres */
+static int owed = 0;
+/** @brief Connexions dont le recv attend des tampons */
+static int starved_count = 0;
+
+/**
+ * @brief Lot de log en cours d'écriture : la partie pas encore écrite
+ *
+ * Une écriture incomplète annule le fdatasync qui lui est lié ; la suite
+ * est alors soumise de nouveau (comme write_all() dans la boucle epoll).
+ */
+static struct {
+    int fd;
+    struct iovec *iov;
+    int count;              /**< 0 : lot entièrement écrit (ou abandonné sur erreur) */
+} log_write;
+
+/** @brief Complétions lues pendant l'attente du log, traitées ensuite */
+static struct io_uring_cqe *deferred;
+static unsigned deferred_count = 0;
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(unsigned submit, unsigned wait) {
+    return syscall(__NR_io_uring_enter, ring.fd, submit, wait,
+                   wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+}
+
+/** @brief Vérifie que le noyau fournit toutes les opérations utilisées */
+static int probe_ops(void) {
+    static const int needed[] = {
+        IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_POLL_ADD, IORING_OP_POLL_REMOVE,
+        IORING_OP_PROVIDE_BUFFERS, IORING_OP_WRITEV, IORING_OP_FSYNC,
+        // Apparue avec le recv multishot (Linux 6.0) : sert de témoin
+        IORING_OP_SEND_ZC,
+    };
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    int ok = probe && syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (size_t i = 0; ok && i < sizeof(needed) / sizeof(needed[0]); i++) {
+        ok = needed[i] < probe->ops_len && (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    return ok ? 0 : -1;
+}
+
+/** @brief Crée l'anneau et projette ses files en mémoire */
+static int ring_init(void) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    ring.fd = sys_setup(URING_ENTRIES, &p);
+    if (ring.fd < 0) {
+        return -1;
+    }
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP) || probe_ops() != 0) {
+        close(ring.fd);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    size_t size = sq_size > cq_size ? sq_size : cq_size;
+    char *rings = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring.fd, IORING_OFF_SQ_RING);
+    ring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    deferred = malloc(p.cq_entries * sizeof(struct io_uring_cqe));
+    if (rings == MAP_FAILED || ring.sqes == MAP_FAILED || !deferred) {
+        close(ring.fd);
+        return -1;
+    }
+
+    ring.sq_head = (unsigned *)(rings + p.sq_off.head);
+    ring.sq_tail = (unsigned *)(rings + p.sq_off.tail);
+    ring.sq_mask = (unsigned *)(rings + p.sq_off.ring_mask);
+    ring.sq_array = (unsigned *)(rings + p.sq_off.array);
+    ring.sq_entries = p.sq_entries;
+    ring.cq_head = (unsigned *)(rings + p.cq_off.head);
+    ring.cq_tail = (unsigned *)(rings + p.cq_off.tail);
+    ring.cq_mask = (unsigned *)(rings + p.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(rings + p.cq_off.cqes);
+    ring.cq_entries = p.cq_entries;
+    return 0;
+}
+
+/** @brief Soumet les requêtes préparées et attend wait complétions */
+static int submit(unsigned wait) {
+    while (1) {
+        int ret = sys_enter(ring.queued, wait);
+        if (ret >= 0) {
+            if ((unsigned)ret > ring.queued) {
+                ret = ring.queued;
+            }
+            ring.queued -= ret;
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+/** @brief Réserve une entrée de la file de soumission (soumet si elle est pleine) */
+static struct io_uring_sqe *get_sqe(void) {
+    unsigned tail = *ring.sq_tail;
+    if (tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) == ring.sq_entries) {
+        submit(0);
+    }
+    unsigned index = tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sq_array[index] = index;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring.queued++;
+    return sqe;
+}
+
+/**
+ * @brief Fournit un tampon de la réserve au noyau pour les recv
+ * @return 0 en cas de succès, -1 si la réserve est vide
+ *
+ * L'identifiant du tampon pour le noyau est son indice dans la réserve ;
+ * la référence prise ici passe au message qui y sera reçu.
+ */
+static int provide_buffer(void) {
+    struct message_buffer *b = msgbuf_get();
+    if (!b) {
+        return -1;
+    }
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = (uint64_t)(uintptr_t)b->data;
+    sqe->len = MESSAGE_MAX - 1;  // Place pour le '\0'
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->off = msgbuf_index(b);
+    sqe->user_data = USER_DATA(REQ_PROVIDE, msgbuf_index(b));
+    provided++;
+    return 0;
+}
+
+static void arm_accept(int slot) {
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = transport_fds[slot].fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = USER_DATA(REQ_ACCEPT, slot);
+}
+
+static void arm_recv(int slot) {
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conns[slot].fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = USER_DATA(REQ_RECV, slot);
+}
+
+static void arm_poll(int slot) {
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = transport_fds[slot].fd;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = USER_DATA(REQ_POLL, slot);
+}
+
+/** @brief Arme un descripteur ajouté par transport_watch() */
+static int uring_added(int slot) {
+    if (transport_fds[slot].t->ops->caps & TRANSPORT_CAP_ACCEPT &&
+        transport_fds[slot].fd == transport_fds[slot].t->fd) {
+        arm_accept(slot);
+    } else {
+        arm_poll(slot);
+    }
+    return 0;
+}
+
+/**
+ * @brief Prépare l'écriture d'un lot de log suivie d'un fdatasync
+ *
+ * Les entrées de iov sont avancées en place si l'écriture est incomplète :
+ * elles doivent rester valides jusqu'à transport_log_done().
+ */
+void transport_uring_log_submit(int fd, struct iovec *iov, int count) {
+    log_write.fd = fd;
+    log_write.iov = iov;
+    log_write.count = count;
+    struct io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)iov;
+    sqe->len = count;
+    sqe->off = (uint64_t)-1;  // Position courante (fichier ouvert en ajout)
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = USER_DATA(REQ_LOG_WRITE, 0);
+
+    sqe = get_sqe();
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = fd;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sqe->user_data = USER_DATA(REQ_LOG_SYNC, 0);
+}
+
+/** @brief Connexion acceptée : lit le PID du client une fois pour toutes */
+static void handle_accept(int slot, const struct io_uring_cqe *cqe) {
+    if (cqe->res >= 0) {
+        int c = 0;
+        while (c < TRANSPORT_MAX_FDS && conns[c].fd >= 0) {
+            c++;
+        }
+        if (c == TRANSPORT_MAX_FDS) {
+            close(cqe->res);
+        } else {
+            struct ucred cred;
+            socklen_t len = sizeof(cred);
+            conns[c].fd = cqe->res;
+            conns[c].pid = getsockopt(cqe->res, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 ? cred.pid : 0;
+            conns[c].t = transport_fds[slot].t;
+            arm_recv(c);
+        }
+    }
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        arm_accept(slot);
+    }
+}
+
+/**
+ * @brief Paquet reçu : le tampon rempli est confié tel quel au traitement
+ *
+ * Un paquet qui remplit tout le tampon est considéré comme tronqué (le
+ * noyau en a jeté la fin).
+ */
+static void handle_recv(int slot, const struct io_uring_cqe *cqe) {
+    struct uring_conn *conn = &conns[slot];
+    if (cqe->res > 0) {
+        struct message_buffer *b = msgbuf_at(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        provided--;
+        b->data[cqe->res] = '\0';
+        b->pid = conn->pid;
+        b->length = cqe->res;
+        b->truncated = cqe->res == MESSAGE_MAX - 1;
+        b->transport = conn->t->ops->name;
+        deliver_fn(b);
+        if (provide_buffer() != 0) {
+            owed++;
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            arm_recv(slot);
+        }
+    } else if (cqe->res == -ENOBUFS) {
+        // Plus de tampon fourni : le recv reprendra quand la réserve en
+        // aura rendu (voir refill())
+        conn->starved = 1;
+        starved_count++;
+    } else if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        close(conn->fd);  // Fin de connexion ou erreur
+        conn->fd = -1;
+    }
+}
+
+static void handle_poll(int slot, const struct io_uring_cqe *cqe) {
+    struct transport_fd *w = &transport_fds[slot];
+    if (w->t && cqe->res > 0 && w->t->ops->recv(w->t, w->fd, deliver_fn) != 0) {
+        struct io_uring_sqe *sqe = get_sqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->addr = USER_DATA(REQ_POLL, slot);
+        sqe->user_data = USER_DATA(REQ_POLL_REMOVE, slot);
+        if (w->fd != w->t->fd) {
+            close(w->fd);
+        }
+        w->t = NULL;
+    }
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        if (w->t) {
+            arm_poll(slot);
+        } else {
+            w->fd = -1;  // Dernière complétion : la case peut être réutilisée
+        }
+    }
+}
+
+/** @brief Fin d'une écriture de log : retire ce qui a été écrit du lot */
+static void handle_log_write(const struct io_uring_cqe *cqe) {
+    if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+        return;  // Rien d'écrit : tout le lot sera soumis de nouveau
+    }
+    if (cqe->res < 0) {
+        fprintf(stderr, "Écriture du log : %s\n", strerror(-cqe->res));
+        log_write.count = 0;
+        return;
+    }
+    size_t n = cqe->res;
+    while (log_write.count > 0 && n >= log_write.iov->iov_len) {
+        n -= log_write.iov->iov_len;
+        log_write.iov++;
+        log_write.count--;
+    }
+    if (log_write.count > 0) {
+        log_write.iov->iov_base = (char *)log_write.iov->iov_base + n;
+        log_write.iov->iov_len -= n;
+    }
+}
+
+/** @brief Fin du fdatasync d'un lot, ou son annulation après une écriture incomplète */
+static void handle_log_sync(void) {
+    if (log_write.count > 0) {
+        transport_uring_log_submit(log_write.fd, log_write.iov, log_write.count);
+    } else {
+        transport_log_done();
+    }
+}
+
+static void handle(const struct io_uring_cqe *cqe) {
+    int slot = USER_SLOT(cqe->user_data);
+    switch (USER_TYPE(cqe->user_data)) {
+    case REQ_ACCEPT:
+        handle_accept(slot, cqe);
+        break;
+    case REQ_RECV:
+        handle_recv(slot, cqe);
+        break;
+    case REQ_POLL:
+        handle_poll(slot, cqe);
+        break;
+    case REQ_LOG_WRITE:
+        handle_log_write(cqe);
+        break;
+    case REQ_LOG_SYNC:
+        handle_log_sync();
+        break;
+    default:
+        break;
+    }
+}
+
+/** @brief Lit la prochaine complétion, 0 si la file est vide */
+static int next_cqe(struct io_uring_cqe *cqe) {
+    unsigned head = *ring.cq_head;
+    if (head == __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    *cqe = ring.cqes[head & *ring.cq_mask];
+    __atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/**
+ * @brief Attend la fin de l'écriture du lot de log en vol
+ *
+ * Appelée quand le lot suivant est plein. Les autres complétions lues
+ * pendant l'attente sont mises de côté pour la boucle principale : on ne
+ * rend pas de message depuis l'intérieur d'un autre.
+ */
+void transport_uring_log_wait(void) {
+    struct io_uring_cqe cqe;
+    while (1) {
+        if (submit(1) != 0) {
+            return;
+        }
+        while (next_cqe(&cqe)) {
+            int type = USER_TYPE(cqe.user_data);
+            if (type == REQ_LOG_SYNC) {
+                handle(&cqe);  // Libère le tampon et écrit le lot suivant
+                if (log_write.count == 0) {
+                    return;
+                }
+                continue;  // Écriture incomplète : la suite vient d'être soumise
+            }
+            if (type == REQ_LOG_WRITE || deferred_count == ring.cq_entries) {
+                handle(&cqe);
+            } else {
+                deferred[deferred_count++] = cqe;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Fournit au noyau les tampons en retard et relance les recv arrêtés
+ */
+static void refill(void) {
+    while (owed > 0 && provide_buffer() == 0) {
+        owed--;
+    }
+    for (int c = 0; provided > 0 && starved_count > 0 && c < TRANSPORT_MAX_FDS; c++) {
+        if (conns[c].starved) {
+            conns[c].starved = 0;
+            starved_count--;
+            arm_recv(c);
+        }
+    }
+}
+
+/**
+ * @brief Boucle d'événements io_uring
+ * @return 0 après transport_stop(), -1 en cas d'erreur (errno = ENOSYS si
+ *         io_uring n'est pas utilisable)
+ */
+int transport_uring_run(transport_deliver deliver) {
+    if (ring_init() != 0) {
+        errno = ENOSYS;  // Quelle que soit la cause, epoll prend le relais
+        return -1;
+    }
+    deliver_fn = deliver;
+    for (int c = 0; c < TRANSPORT_MAX_FDS; c++) {
+        conns[c].fd = -1;
+    }
+    unsigned share = msgbuf_capacity() / URING_POOL_SHARE;
+    share = share < 1 ? 1 : share > URING_BUFFERS ? URING_BUFFERS : share;
+    for (unsigned i = 0; i < share; i++) {
+        if (provide_buffer() != 0) {
+            owed++;
+        }
+    }
+    for (int slot = 0; slot < transport_fd_count; slot++) {
+        if (transport_fds[slot].fd >= 0) {
+            uring_added(slot);
+        }
+    }
+    transport_fd_added = uring_added;
+    transport_loop = "io_uring";
+
+    struct io_uring_cqe cqe;
+    while (!transport_stopping()) {
+        transport_log_flush();
+        if (owed > 0 || starved_count > 0) {
+            refill();
+        }
+        if (submit(1) != 0) {
+            return -1;
+        }
+        metrics_inc(METRIC_LOOP_WAKEUPS);
+        for (unsigned i = 0; i < deferred_count; i++) {
+            handle(&deferred[i]);
+        }
+        deferred_count = 0;
+        while (next_cqe(&cqe)) {
+            handle(&cqe);
+        }
+    }
+    transport_log_finish();
+    return 0;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file transport_uring.h
+ * @brief Boucle d'événements du serveur avec io_uring
+ * @author silverhawks
+ * @date 06/01/25
+ */
+
+#ifndef TRANSPORT_URING_H
+#define TRANSPORT_URING_H
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "transport.h"
+
+/** @brief Nombre d'entrées de la file de soumission */
+#define URING_ENTRIES 512
+/** @brief Nombre maximal de tampons de la réserve fournis au noyau pour les recv */
+#define URING_BUFFERS 256
+/**
+ * @brief Part de la réserve fournie au noyau (1/URING_POOL_SHARE)
+ *
+ * Le reste sert aux autres transports : avec une petite réserve, les
+ * sessions des signaux et des tubes ne sont pas toutes refusées.
+ */
+#define URING_POOL_SHARE 4
+
+int transport_uring_run(transport_deliver deliver);
+void transport_uring_log_submit(int fd, struct iovec *iov, int count);
+void transport_uring_log_wait(void);
+
+#endif